@@ -0,0 +1,44 @@
+/*
+ * ASMSampler.cpp
+ *
+ *  Created on: May 12, 2017
+ *      Author: nick
+ */
+
+#include <cmath>
+#include <algorithm>
+
+#include "ASMSampler.h"
+#include "ModelRandom.h"
+
+namespace TransModel {
+
+ASMSampler::ASMSampler(const RangeWithProbability& asm_bins) :
+		bins { asm_bins } {
+}
+
+ASMSampler::~ASMSampler() {
+}
+
+long ASMSampler::drawDeathTick(const Person& person, long first_tick, long end_tick) {
+	ModelRandom& rng = ModelRandom::instance();
+	long tick = first_tick;
+	while (tick < end_tick) {
+		const RangeBin& bin = bins.findBin(person.ageAt(tick + 1));
+		// first tick whose age is past the bin
+		long bin_end = std::max(tick + 1, (long) person.clockAtAge(bin.max) - 1);
+		bin_end = std::min(bin_end, end_tick);
+
+		if (bin.prob > 0) {
+			// number of trials up to and including the first death
+			double trials = 1 + (double) rng.geometric(bin.prob);
+			if (trials <= bin_end - tick) {
+				return tick + (long) trials - 1;
+			}
+		}
+		tick = bin_end;
+	}
+	return -1;
+}
+
+} /* namespace TransModel */
@@ -0,0 +1,47 @@
+/*
+ * ASMSampler.h
+ *
+ *  Created on: May 12, 2017
+ *      Author: nick
+ */
+
+#ifndef SRC_ASMSAMPLER_H_
+#define SRC_ASMSAMPLER_H_
+
+#include "RangeWithProbability.h"
+#include "Person.h"
+
+namespace TransModel {
+
+/**
+ * Samples the tick of a person's age specific mortality (ASM) death.
+ *
+ * The ASM bins give the probability of dying in any one tick for a
+ * person whose age is in the bin's range. Rather than a draw each tick, the number
+ * of ticks until death within a bin is drawn from the geometric distribution
+ * with the bin's probability. If that falls after the person's age leaves the bin,
+ * the draw is repeated from the tick the next bin is entered. The geometric distribution is
+ * memoryless, so the tick of death has the same distribution as with a draw each tick.
+ */
+class ASMSampler {
+
+private:
+	RangeWithProbability bins;
+
+public:
+	ASMSampler(const RangeWithProbability& asm_bins);
+	virtual ~ASMSampler();
+
+	/**
+	 * Draws the tick at which the person dies of ASM, with a trial at each tick
+	 * from first_tick up to but not including end_tick. The age tested at tick t is the
+	 * person's age after that tick's step, i.e. ageAt(t + 1).
+	 *
+	 * @return the tick of death, or -1 if the person doesn't die before end_tick.
+	 */
+	long drawDeathTick(const Person& person, long first_tick, long end_tick);
+};
+
+} /* namespace TransModel */
+
+#endif /* SRC_ASMSAMPLER_H_ */
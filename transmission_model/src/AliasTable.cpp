@@ -0,0 +1,71 @@
+/*
+ * AliasTable.cpp
+ *
+ *  Created on: May 16, 2017
+ *      Author: nick
+ */
+
+#include <stdexcept>
+
+#include "AliasTable.h"
+
+namespace TransModel {
+
+AliasTable::AliasTable() :
+		probs(), aliases() {
+}
+
+AliasTable::AliasTable(const std::vector<double>& weights) :
+		probs(weights.size(), 1.0), aliases(weights.size()) {
+	double sum = 0;
+	for (double weight : weights) {
+		if (weight < 0) {
+			throw std::invalid_argument("AliasTable weights must be non-negative");
+		}
+		sum += weight;
+	}
+	if (weights.size() == 0 || sum <= 0) {
+		throw std::invalid_argument("AliasTable weights must sum to more than 0");
+	}
+
+	size_t n = weights.size();
+	std::vector<double> scaled(n);
+	std::vector<size_t> small, large;
+	for (size_t i = 0; i < n; ++i) {
+		aliases[i] = i;
+		scaled[i] = weights[i] * n / sum;
+		if (scaled[i] < 1) {
+			small.push_back(i);
+		} else {
+			large.push_back(i);
+		}
+	}
+
+	// each small index is paired with a large index that tops it up to 1
+	while (!small.empty() && !large.empty()) {
+		size_t s = small.back();
+		small.pop_back();
+		size_t l = large.back();
+
+		probs[s] = scaled[s];
+		aliases[s] = l;
+		scaled[l] = (scaled[l] + scaled[s]) - 1;
+		if (scaled[l] < 1) {
+			large.pop_back();
+			small.push_back(l);
+		}
+	}
+
+	// whatever is left is 1 give or take rounding error
+	for (size_t i : large) {
+		probs[i] = 1.0;
+	}
+	for (size_t i : small) {
+		probs[i] = 1.0;
+	}
+}
+
+AliasTable::~AliasTable() {
+}
+
+} /* namespace TransModel */
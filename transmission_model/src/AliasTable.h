@@ -0,0 +1,57 @@
+/*
+ * AliasTable.h
+ *
+ *  Created on: May 16, 2017
+ *      Author: nick
+ */
+
+#ifndef SRC_ALIASTABLE_H_
+#define SRC_ALIASTABLE_H_
+
+#include <vector>
+
+namespace TransModel {
+
+/**
+ * Discrete distribution over the indices [0, n) sampled in O(1) time
+ * with Walker's alias method, using Vose's construction of the table.
+ */
+class AliasTable {
+
+private:
+	std::vector<double> probs;
+	std::vector<size_t> aliases;
+
+public:
+	/**
+	 * Creates an empty table.
+	 */
+	AliasTable();
+
+	/**
+	 * Creates a table where the probability of each index is proportional
+	 * to its weight. The weights must be non-negative and sum to more than 0.
+	 */
+	AliasTable(const std::vector<double>& weights);
+	virtual ~AliasTable();
+
+	/**
+	 * Draws an index using the specified uniform [0, 1) draw.
+	 */
+	size_t draw(double val) const {
+		double scaled = val * probs.size();
+		size_t idx = (size_t) scaled;
+		if (idx >= probs.size()) {
+			idx = probs.size() - 1;
+		}
+		return scaled - idx < probs[idx] ? idx : aliases[idx];
+	}
+
+	size_t size() const {
+		return probs.size();
+	}
+};
+
+} /* namespace TransModel */
+
+#endif /* SRC_ALIASTABLE_H_ */
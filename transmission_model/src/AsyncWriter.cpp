@@ -0,0 +1,98 @@
+/*
+ * AsyncWriter.cpp
+ *
+ *  Created on: May 23, 2017
+ *      Author: nick
+ */
+
+#include <iostream>
+#include <stdexcept>
+
+#include "AsyncWriter.h"
+
+namespace TransModel {
+
+AsyncWriter::AsyncWriter(size_t max_pending) :
+		mutex(), not_empty(), not_full(), idle(), tasks(), max_pending(max_pending), busy(false), stopping(false), error(), worker() {
+	if (max_pending == 0) {
+		throw std::invalid_argument("AsyncWriter max pending tasks must be greater than 0");
+	}
+	worker = std::thread(&AsyncWriter::work, this);
+}
+
+AsyncWriter::~AsyncWriter() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	not_empty.notify_one();
+	worker.join();
+
+	if (error) {
+		try {
+			std::rethrow_exception(error);
+		} catch (std::exception& ex) {
+			std::cerr << "Error writing output: " << ex.what() << std::endl;
+		}
+	}
+}
+
+void AsyncWriter::work() {
+	while (true) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			not_empty.wait(lock, [this] {return stopping || !tasks.empty();});
+			if (tasks.empty()) {
+				// stopping and all tasks have run
+				return;
+			}
+			task = std::move(tasks.front());
+			tasks.pop_front();
+			busy = true;
+		}
+		not_full.notify_one();
+
+		try {
+			task();
+		} catch (...) {
+			std::lock_guard<std::mutex> lock(mutex);
+			if (!error) {
+				error = std::current_exception();
+			}
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			busy = false;
+		}
+		idle.notify_all();
+	}
+}
+
+// expects the mutex to be held
+void AsyncWriter::rethrowError() {
+	if (error) {
+		std::exception_ptr ex = error;
+		error = nullptr;
+		std::rethrow_exception(ex);
+	}
+}
+
+void AsyncWriter::submit(std::function<void()> task) {
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		rethrowError();
+		not_full.wait(lock, [this] {return tasks.size() < max_pending;});
+		tasks.push_back(std::move(task));
+	}
+	not_empty.notify_one();
+}
+
+void AsyncWriter::flush() {
+	std::unique_lock<std::mutex> lock(mutex);
+	idle.wait(lock, [this] {return tasks.empty() && !busy;});
+	rethrowError();
+}
+
+} /* namespace TransModel */
@@ -0,0 +1,70 @@
+/*
+ * AsyncWriter.h
+ *
+ *  Created on: May 23, 2017
+ *      Author: nick
+ */
+
+#ifndef SRC_ASYNCWRITER_H_
+#define SRC_ASYNCWRITER_H_
+
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+
+namespace TransModel {
+
+/**
+ * Runs output tasks on a single background I/O thread in the order in
+ * which they are submitted. The queue of pending tasks is bounded so
+ * submit only blocks when the I/O thread has fallen that far behind.
+ *
+ * An exception thrown by a task is rethrown on the submitting thread by
+ * the next call to submit or flush.
+ */
+class AsyncWriter {
+
+private:
+	std::mutex mutex;
+	std::condition_variable not_empty, not_full, idle;
+	std::deque<std::function<void()>> tasks;
+	size_t max_pending;
+	bool busy, stopping;
+	std::exception_ptr error;
+	std::thread worker;
+
+	void work();
+	void rethrowError();
+
+public:
+	/**
+	 * @param max_pending the maximum number of tasks waiting to be run
+	 */
+	AsyncWriter(size_t max_pending = 64);
+
+	/**
+	 * Runs any pending tasks and stops the I/O thread.
+	 */
+	virtual ~AsyncWriter();
+
+	AsyncWriter(const AsyncWriter&) = delete;
+	AsyncWriter& operator=(const AsyncWriter&) = delete;
+
+	/**
+	 * Queues the task to be run on the I/O thread, blocking if
+	 * the queue is full.
+	 */
+	void submit(std::function<void()> task);
+
+	/**
+	 * Blocks until all the submitted tasks have been run.
+	 */
+	void flush();
+};
+
+} /* namespace TransModel */
+
+#endif /* SRC_ASYNCWRITER_H_ */
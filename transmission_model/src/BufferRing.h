@@ -0,0 +1,92 @@
+/*
+ * BufferRing.h
+ *
+ *  Created on: May 30, 2017
+ *      Author: nick
+ */
+
+#ifndef SRC_BUFFERRING_H_
+#define SRC_BUFFERRING_H_
+
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+namespace TransModel {
+
+/**
+ * Fixed ring of buffers whose storage is allocated once, up front. A
+ * producer fills the buffers in ring order, handing each full one to
+ * a consumer that releases it back to the ring once it has been used.
+ * Acquiring a buffer blocks until the consumer has released it, so the
+ * producer is at most the size of the ring ahead of the consumer.
+ *
+ * The buffers should be released in the order in which they were acquired.
+ */
+template<typename T>
+class BufferRing {
+
+private:
+	std::vector<std::vector<T>> buffers;
+	std::vector<bool> available;
+	size_t next;
+	std::mutex mutex;
+	std::condition_variable released;
+
+public:
+	/**
+	 * @param count the number of buffers
+	 * @param capacity the number of items each buffer holds without reallocating
+	 */
+	BufferRing(size_t count, size_t capacity);
+
+	BufferRing(const BufferRing&) = delete;
+	BufferRing& operator=(const BufferRing&) = delete;
+
+	/**
+	 * Gets the next buffer in the ring, blocking until it has been released.
+	 * The buffer is empty.
+	 */
+	std::vector<T>& acquire();
+
+	/**
+	 * Clears the buffer, keeping its storage, and returns it to the ring.
+	 */
+	void release(std::vector<T>& buffer);
+
+	size_t size() const {
+		return buffers.size();
+	}
+};
+
+template<typename T>
+BufferRing<T>::BufferRing(size_t count, size_t capacity) :
+		buffers(count), available(count, true), next(0), mutex(), released() {
+	for (auto& buffer : buffers) {
+		buffer.reserve(capacity);
+	}
+}
+
+template<typename T>
+std::vector<T>& BufferRing<T>::acquire() {
+	std::unique_lock<std::mutex> lock(mutex);
+	size_t idx = next;
+	released.wait(lock, [this, idx] {return available[idx];});
+	available[idx] = false;
+	next = (next + 1) % buffers.size();
+	return buffers[idx];
+}
+
+template<typename T>
+void BufferRing<T>::release(std::vector<T>& buffer) {
+	buffer.clear();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		available[&buffer - &buffers[0]] = true;
+	}
+	released.notify_all();
+}
+
+} /* namespace TransModel */
+
+#endif /* SRC_BUFFERRING_H_ */
@@ -0,0 +1,91 @@
+/*
+ * CalendarQueue.h
+ *
+ *  Created on: May 8, 2017
+ *      Author: nick
+ */
+
+#ifndef SRC_CALENDARQUEUE_H_
+#define SRC_CALENDARQUEUE_H_
+
+#include <vector>
+
+namespace TransModel {
+
+/**
+ * Calendar queue of items keyed by integer tick. Items are stored in a ring
+ * of buckets indexed by tick modulo the number of buckets, so push is O(1)
+ * and pop for a tick only visits that tick's bucket. Items more than a full
+ * ring ahead share a bucket with nearer items and are left in place when the
+ * nearer ones are popped.
+ *
+ * The ticks passed to pop are expected to increase and an item should not
+ * be pushed with a tick earlier than the last popped tick.
+ */
+template<typename T>
+class CalendarQueue {
+
+private:
+	struct Entry {
+		long tick;
+		T item;
+	};
+
+	std::vector<std::vector<Entry>> buckets;
+	size_t mask;
+	size_t count;
+
+public:
+	/**
+	 * @param bucket_count the number of buckets, rounded up to a power of 2
+	 */
+	CalendarQueue(size_t bucket_count = 4096);
+
+	void push(long tick, const T& item);
+
+	/**
+	 * Removes the items keyed by the specified tick and puts
+	 * them in the out vector.
+	 */
+	void pop(long tick, std::vector<T>& out);
+
+	size_t size() const {
+		return count;
+	}
+};
+
+template<typename T>
+CalendarQueue<T>::CalendarQueue(size_t bucket_count) :
+		buckets(), mask(0), count(0) {
+	size_t size = 1;
+	while (size < bucket_count) {
+		size <<= 1;
+	}
+	buckets.resize(size);
+	mask = size - 1;
+}
+
+template<typename T>
+void CalendarQueue<T>::push(long tick, const T& item) {
+	buckets[((size_t) tick) & mask].push_back( { tick, item });
+	++count;
+}
+
+template<typename T>
+void CalendarQueue<T>::pop(long tick, std::vector<T>& out) {
+	std::vector<Entry>& bucket = buckets[((size_t) tick) & mask];
+	size_t kept = 0;
+	for (size_t i = 0; i < bucket.size(); ++i) {
+		if (bucket[i].tick == tick) {
+			out.push_back(bucket[i].item);
+		} else {
+			bucket[kept++] = bucket[i];
+		}
+	}
+	count -= bucket.size() - kept;
+	bucket.erase(bucket.begin() + kept, bucket.end());
+}
+
+} /* namespace TransModel */
+
+#endif /* SRC_CALENDARQUEUE_H_ */
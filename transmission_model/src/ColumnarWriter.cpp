@@ -0,0 +1,139 @@
+/*
+ * ColumnarWriter.cpp
+ *
+ *  Created on: May 22, 2017
+ *      Author: nick
+ */
+
+#include <cstdint>
+#include <stdexcept>
+#include <iostream>
+
+#include "boost/filesystem.hpp"
+
+#include "ColumnarWriter.h"
+#include "file_utils.h"
+
+namespace fs = boost::filesystem;
+
+namespace TransModel {
+
+ColumnSchema::ColumnSchema() :
+		columns_() {
+}
+
+ColumnSchema::~ColumnSchema() {
+}
+
+void ColumnSchema::add(const std::string& name, ColumnType type) {
+	columns_.push_back( { name, type });
+}
+
+const std::string& column_type_name(ColumnType type) {
+	static const std::vector<std::string> names { "float64", "float32", "int32", "uint32", "bool", "string" };
+	return names[static_cast<size_t>(type)];
+}
+
+const std::string ColumnarWriter::MAGIC = "BARSCOL1";
+
+ColumnarWriter::ColumnarWriter(const std::string& fname, const ColumnSchema& schema) :
+		defs(schema.columns()), data(schema.columns().size()), out(), data_fname_(), schema_fname_(), col_idx(0), rows(
+				0), open(true) {
+
+	if (defs.empty()) {
+		throw std::invalid_argument("Cannot create columnar output '" + fname + "': schema has no columns");
+	}
+
+	fs::path data_path(unique_file_name(fs::path(fname).replace_extension(".bin").string()));
+	if (!data_path.parent_path().empty() && !fs::exists(data_path.parent_path())) {
+		fs::create_directories(data_path.parent_path());
+	}
+	data_fname_ = data_path.string();
+	schema_fname_ = fs::path(data_path).replace_extension(".schema").string();
+
+	std::ofstream schema_out(schema_fname_.c_str());
+	if (!schema_out.is_open()) {
+		throw std::runtime_error("Cannot open columnar schema file '" + schema_fname_ + "'");
+	}
+	for (auto& def : defs) {
+		schema_out << def.name << "," << column_type_name(def.type) << "\n";
+	}
+	schema_out.close();
+	if (schema_out.fail()) {
+		throw std::runtime_error("Error writing columnar schema file '" + schema_fname_ + "'");
+	}
+
+	out.open(data_fname_.c_str(), std::ios::binary);
+	if (!out.is_open()) {
+		throw std::runtime_error("Cannot open columnar output file '" + data_fname_ + "'");
+	}
+	out.write(MAGIC.c_str(), MAGIC.size());
+	checkWrite();
+}
+
+ColumnarWriter::~ColumnarWriter() {
+	try {
+		close();
+	} catch (std::exception& ex) {
+		std::cerr << "Error writing output: " << ex.what() << std::endl;
+	}
+}
+
+void ColumnarWriter::checkWrite() {
+	if (out.fail()) {
+		throw std::runtime_error("Error writing columnar output file '" + data_fname_ + "'");
+	}
+}
+
+std::vector<char>& ColumnarWriter::next(ColumnType type) {
+	if (col_idx == defs.size() || defs[col_idx].type != type) {
+		throw std::invalid_argument("Columnar output row does not match the schema");
+	}
+	return data[col_idx++];
+}
+
+void ColumnarWriter::operator()(const std::string& name, const std::string& val) {
+	std::vector<char>& column = next(ColumnType::STRING);
+	uint32_t length = val.size();
+	const char* bytes = reinterpret_cast<const char*>(&length);
+	column.insert(column.end(), bytes, bytes + sizeof(uint32_t));
+	column.insert(column.end(), val.begin(), val.end());
+}
+
+void ColumnarWriter::endRow() {
+	if (col_idx != defs.size()) {
+		throw std::invalid_argument("Columnar output row does not match the schema");
+	}
+	col_idx = 0;
+	++rows;
+}
+
+void ColumnarWriter::writeChunk() {
+	if (rows == 0) {
+		return;
+	}
+
+	uint32_t header[] = { rows, (uint32_t) defs.size() };
+	out.write(reinterpret_cast<const char*>(header), sizeof(header));
+	for (size_t i = 0; i < defs.size(); ++i) {
+		unsigned char type = static_cast<unsigned char>(defs[i].type);
+		uint64_t size = data[i].size();
+		out.write(reinterpret_cast<const char*>(&type), 1);
+		out.write(reinterpret_cast<const char*>(&size), sizeof(uint64_t));
+		out.write(data[i].data(), data[i].size());
+		data[i].clear();
+	}
+	rows = 0;
+	checkWrite();
+}
+
+void ColumnarWriter::close() {
+	if (open) {
+		open = false;
+		writeChunk();
+		out.close();
+		checkWrite();
+	}
+}
+
+} /* namespace TransModel */
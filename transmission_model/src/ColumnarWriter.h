@@ -0,0 +1,176 @@
+/*
+ * ColumnarWriter.h
+ *
+ *  Created on: May 22, 2017
+ *      Author: nick
+ */
+
+#ifndef SRC_COLUMNARWRITER_H_
+#define SRC_COLUMNARWRITER_H_
+
+#include <string>
+#include <vector>
+#include <fstream>
+
+namespace TransModel {
+
+enum class ColumnType : unsigned char {
+	FLOAT64, FLOAT32, INT32, UINT32, BOOL, STRING
+};
+
+/**
+ * The names and types of a set of columns. This can be passed to
+ * the visit method of an output struct to collect the struct's columns.
+ */
+class ColumnSchema {
+
+public:
+	struct ColumnDef {
+		std::string name;
+		ColumnType type;
+	};
+
+private:
+	std::vector<ColumnDef> columns_;
+
+public:
+	ColumnSchema();
+	~ColumnSchema();
+
+	void add(const std::string& name, ColumnType type);
+
+	void operator()(const std::string& name, double) {
+		add(name, ColumnType::FLOAT64);
+	}
+
+	void operator()(const std::string& name, float) {
+		add(name, ColumnType::FLOAT32);
+	}
+
+	void operator()(const std::string& name, int) {
+		add(name, ColumnType::INT32);
+	}
+
+	void operator()(const std::string& name, unsigned int) {
+		add(name, ColumnType::UINT32);
+	}
+
+	void operator()(const std::string& name, bool) {
+		add(name, ColumnType::BOOL);
+	}
+
+	void operator()(const std::string& name, const std::string&) {
+		add(name, ColumnType::STRING);
+	}
+
+	const std::vector<ColumnDef>& columns() const {
+		return columns_;
+	}
+};
+
+/**
+ * Gets the name of the column type as used in the schema file.
+ */
+const std::string& column_type_name(ColumnType type);
+
+/**
+ * Writes rows of typed values column-wise in binary chunks.
+ *
+ * The data file starts with the 8 byte magic "BARSCOL1" followed by the chunks.
+ * Each chunk is a header of the uint32 number of rows and the uint32 number of
+ * columns, followed by each column as a uint8 ColumnType, the uint64 number of bytes
+ * of column data and the data itself. Numbers are in native (little endian)
+ * byte order, bools are one byte and strings are a uint32 length followed
+ * by the characters.
+ *
+ * The column names and types are written to a schema file next to the data file,
+ * one "name,type" line per column.
+ *
+ * A row is added by calling operator() for each value in schema order
+ * and then endRow, which is how the visit method of the output structs
+ * calls it.
+ */
+class ColumnarWriter {
+
+private:
+	std::vector<ColumnSchema::ColumnDef> defs;
+	std::vector<std::vector<char>> data;
+	std::ofstream out;
+	std::string data_fname_, schema_fname_;
+	size_t col_idx;
+	unsigned int rows;
+	bool open;
+
+	std::vector<char>& next(ColumnType type);
+	// throws std::runtime_error if a write to out has failed
+	void checkWrite();
+
+	template<typename T>
+	void append(ColumnType type, T val) {
+		std::vector<char>& column = next(type);
+		const char* bytes = reinterpret_cast<const char*>(&val);
+		column.insert(column.end(), bytes, bytes + sizeof(T));
+	}
+
+public:
+	static const std::string MAGIC;
+
+	/**
+	 * @param fname the output file name. Its extension is replaced by .bin for
+	 * the data file and by .schema for the schema file.
+	 * @throws std::runtime_error if either file cannot be opened or written.
+	 */
+	ColumnarWriter(const std::string& fname, const ColumnSchema& schema);
+	~ColumnarWriter();
+
+	void operator()(const std::string& name, double val) {
+		append(ColumnType::FLOAT64, val);
+	}
+
+	void operator()(const std::string& name, float val) {
+		append(ColumnType::FLOAT32, val);
+	}
+
+	void operator()(const std::string& name, int val) {
+		append(ColumnType::INT32, val);
+	}
+
+	void operator()(const std::string& name, unsigned int val) {
+		append(ColumnType::UINT32, val);
+	}
+
+	void operator()(const std::string& name, bool val) {
+		append(ColumnType::BOOL, (unsigned char) val);
+	}
+
+	void operator()(const std::string& name, const std::string& val);
+
+	/**
+	 * Ends the current row.
+	 */
+	void endRow();
+
+	/**
+	 * Writes the rows added since the previous chunk as a chunk.
+	 *
+	 * @throws std::runtime_error if the chunk cannot be written.
+	 */
+	void writeChunk();
+
+	/**
+	 * Writes any remaining rows and closes the file.
+	 */
+	void close();
+
+	const std::string& dataFile() const {
+		return data_fname_;
+	}
+
+	const std::string& schemaFile() const {
+		return schema_fname_;
+	}
+};
+
+} /* namespace TransModel */
+
+#endif /* SRC_COLUMNARWRITER_H_ */
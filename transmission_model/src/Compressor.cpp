@@ -0,0 +1,127 @@
+/*
+ * Compressor.cpp
+ *
+ *  Created on: May 24, 2017
+ *      Author: nick
+ */
+
+#include <stdexcept>
+
+#include "zlib.h"
+#ifdef HAVE_ZSTD
+#include "zstd.h"
+#endif
+
+#include "Compressor.h"
+
+namespace TransModel {
+
+const size_t CHUNK_SIZE = 1 << 16;
+
+bool ends_with(const std::string& str, const std::string& suffix) {
+	return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+struct GzipCompressor::Stream {
+	z_stream strm;
+};
+
+GzipCompressor::GzipCompressor(int level) :
+		stream(new Stream()), chunk(CHUNK_SIZE) {
+	stream->strm.zalloc = Z_NULL;
+	stream->strm.zfree = Z_NULL;
+	stream->strm.opaque = Z_NULL;
+	// 15 + 16: the default window size with a gzip header and trailer
+	if (deflateInit2(&stream->strm, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+		throw std::domain_error("Error initializing gzip compression");
+	}
+}
+
+GzipCompressor::~GzipCompressor() {
+	deflateEnd(&stream->strm);
+}
+
+void GzipCompressor::deflate(int flush, std::ostream& out) {
+	z_stream& strm = stream->strm;
+	int ret;
+	do {
+		strm.next_out = reinterpret_cast<Bytef*>(chunk.data());
+		strm.avail_out = chunk.size();
+		ret = ::deflate(&strm, flush);
+		if (ret == Z_STREAM_ERROR) {
+			throw std::domain_error("Error during gzip compression");
+		}
+		out.write(chunk.data(), chunk.size() - strm.avail_out);
+	} while (strm.avail_out == 0 || (flush == Z_FINISH && ret != Z_STREAM_END));
+}
+
+void GzipCompressor::write(const char* data, size_t size, std::ostream& out) {
+	z_stream& strm = stream->strm;
+	strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+	strm.avail_in = size;
+	deflate(Z_NO_FLUSH, out);
+}
+
+void GzipCompressor::finish(std::ostream& out) {
+	stream->strm.avail_in = 0;
+	deflate(Z_FINISH, out);
+}
+
+#ifdef HAVE_ZSTD
+
+struct ZstdCompressor::Stream {
+	ZSTD_CStream* cstream;
+};
+
+ZstdCompressor::ZstdCompressor(int level) :
+		stream(new Stream { ZSTD_createCStream() }), chunk(ZSTD_CStreamOutSize()) {
+	if (stream->cstream == nullptr || ZSTD_isError(ZSTD_initCStream(stream->cstream, level))) {
+		ZSTD_freeCStream(stream->cstream);
+		throw std::domain_error("Error initializing zstd compression");
+	}
+}
+
+ZstdCompressor::~ZstdCompressor() {
+	ZSTD_freeCStream(stream->cstream);
+}
+
+void ZstdCompressor::write(const char* data, size_t size, std::ostream& out) {
+	ZSTD_inBuffer in { data, size, 0 };
+	while (in.pos < in.size) {
+		ZSTD_outBuffer zout { chunk.data(), chunk.size(), 0 };
+		size_t ret = ZSTD_compressStream(stream->cstream, &zout, &in);
+		if (ZSTD_isError(ret)) {
+			throw std::domain_error(std::string("Error during zstd compression: ") + ZSTD_getErrorName(ret));
+		}
+		out.write(chunk.data(), zout.pos);
+	}
+}
+
+void ZstdCompressor::finish(std::ostream& out) {
+	size_t remaining;
+	do {
+		ZSTD_outBuffer zout { chunk.data(), chunk.size(), 0 };
+		remaining = ZSTD_endStream(stream->cstream, &zout);
+		if (ZSTD_isError(remaining)) {
+			throw std::domain_error(std::string("Error during zstd compression: ") + ZSTD_getErrorName(remaining));
+		}
+		out.write(chunk.data(), zout.pos);
+	} while (remaining > 0);
+}
+
+#endif
+
+std::unique_ptr<Compressor> create_compressor(const std::string& fname) {
+	if (ends_with(fname, ".gz")) {
+		return std::unique_ptr<Compressor>(new GzipCompressor());
+	} else if (ends_with(fname, ".zst")) {
+#ifdef HAVE_ZSTD
+		return std::unique_ptr<Compressor>(new ZstdCompressor());
+#else
+		throw std::invalid_argument("Cannot write '" + fname + "': zstd compression requires building with HAVE_ZSTD");
+#endif
+	}
+	return std::unique_ptr<Compressor>();
+}
+
+} /* namespace TransModel */
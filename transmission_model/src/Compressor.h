@@ -0,0 +1,89 @@
+/*
+ * Compressor.h
+ *
+ *  Created on: May 24, 2017
+ *      Author: nick
+ */
+
+#ifndef SRC_COMPRESSOR_H_
+#define SRC_COMPRESSOR_H_
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <ostream>
+
+namespace TransModel {
+
+/**
+ * Streaming compressor that compresses data written to it
+ * in pieces into an ostream.
+ */
+class Compressor {
+
+public:
+	virtual ~Compressor() {
+	}
+
+	/**
+	 * Compresses the data, writing any compressed output to out.
+	 */
+	virtual void write(const char* data, size_t size, std::ostream& out) = 0;
+
+	/**
+	 * Writes the remaining compressed output and ends the compressed stream.
+	 */
+	virtual void finish(std::ostream& out) = 0;
+};
+
+/**
+ * Compresses to the gzip format.
+ */
+class GzipCompressor: public Compressor {
+
+private:
+	struct Stream;
+	std::unique_ptr<Stream> stream;
+	std::vector<char> chunk;
+
+	void deflate(int flush, std::ostream& out);
+
+public:
+	GzipCompressor(int level = 6);
+	virtual ~GzipCompressor();
+
+	void write(const char* data, size_t size, std::ostream& out) override;
+	void finish(std::ostream& out) override;
+};
+
+#ifdef HAVE_ZSTD
+
+/**
+ * Compresses to the zstd format.
+ */
+class ZstdCompressor: public Compressor {
+
+private:
+	struct Stream;
+	std::unique_ptr<Stream> stream;
+	std::vector<char> chunk;
+
+public:
+	ZstdCompressor(int level = 3);
+	virtual ~ZstdCompressor();
+
+	void write(const char* data, size_t size, std::ostream& out) override;
+	void finish(std::ostream& out) override;
+};
+
+#endif
+
+/**
+ * Creates the Compressor for the file name's extension: a GzipCompressor for
+ * .gz and a ZstdCompressor for .zst. Returns nullptr for any other extension.
+ */
+std::unique_ptr<Compressor> create_compressor(const std::string& fname);
+
+} /* namespace TransModel */
+
+#endif /* SRC_COMPRESSOR_H_ */
@@ -6,14 +6,30 @@
  */
 
 #include <cmath>
+#include <algorithm>
 
 #include "CondomUseAssigner.h"
 #include "Person.h"
 
-#include "repast_hpc/Random.h"
+#include "ModelRandom.h"
 
 namespace TransModel {
 
+CondomUseCategories::CondomUseCategories() : categories{}, use_probabilities{} {
+}
+
+CondomUseCategories::CondomUseCategories(const std::vector<CondomUseProbabilities>& vec) : categories{}, use_probabilities{} {
+	std::vector<double> category_probs;
+	double prev = 0;
+	for (auto& probs : vec) {
+		// the final cumulative probability is set to 1 and so may be slightly less than the previous one
+		category_probs.push_back(std::max(0.0, probs.category_probabilty - prev));
+		use_probabilities.push_back(probs.use_probabilty);
+		prev = probs.category_probabilty;
+	}
+	categories = AliasTable(category_probs);
+}
+
 CondomUseAssigner::CondomUseAssigner() : casual_sd_probs{}, casual_sc_probs{}, steady_sd_probs{},
 	steady_sc_probs{} {
 }
@@ -21,14 +37,9 @@ CondomUseAssigner::CondomUseAssigner() : casual_sd_probs{}, casual_sc_probs{}, s
 CondomUseAssigner::~CondomUseAssigner() {
 }
 
-void CondomUseAssigner::updateEdge(std::vector<CondomUseProbabilities>& vec, std::shared_ptr<Edge<Person>> edge) {
-	double draw = repast::Random::instance()->nextDouble();
-	for (auto& probs : vec) {
-		if (draw <= probs.category_probabilty) {
-			edge->setCondomUseProbability(probs.use_probabilty);
-			break;
-		}
-	}
+void CondomUseAssigner::updateEdge(const CondomUseCategories& categories, std::shared_ptr<Edge<Person>> edge) {
+	double draw = ModelRandom::instance().uniform();
+	edge->setCondomUseProbability(categories.drawUseProbability(draw));
 }
 
 void CondomUseAssigner::initEdge(std::shared_ptr<Edge<Person>> edge) {
@@ -65,10 +76,10 @@ CondomUseAssigner CondomUseAssignerFactory::createAssigner() {
 	checkVector(casual_sc_probs);
 
 	CondomUseAssigner assigner;
-	assigner.steady_sd_probs.insert(assigner.steady_sd_probs.end(), steady_sd_probs.begin(), steady_sd_probs.end());
-	assigner.steady_sc_probs.insert(assigner.steady_sc_probs.end(), steady_sc_probs.begin(), steady_sc_probs.end());
-	assigner.casual_sd_probs.insert(assigner.casual_sd_probs.end(), casual_sd_probs.begin(), casual_sd_probs.end());
-	assigner.casual_sc_probs.insert(assigner.casual_sc_probs.end(), casual_sc_probs.begin(), casual_sc_probs.end());
+	assigner.steady_sd_probs = CondomUseCategories(steady_sd_probs);
+	assigner.steady_sc_probs = CondomUseCategories(steady_sc_probs);
+	assigner.casual_sd_probs = CondomUseCategories(casual_sd_probs);
+	assigner.casual_sc_probs = CondomUseCategories(casual_sc_probs);
 
 	return assigner;
 }
@@ -13,6 +13,7 @@
 
 #include "Edge.h"
 #include "common.h"
+#include "AliasTable.h"
 
 namespace TransModel {
 
@@ -22,15 +23,33 @@ struct CondomUseProbabilities {
 	double category_probabilty, use_probabilty;
 };
 
+/**
+ * Condom use categories, drawn with an AliasTable, and each
+ * category's condom use probability.
+ */
+struct CondomUseCategories {
+	AliasTable categories;
+	std::vector<double> use_probabilities;
+
+	CondomUseCategories();
+	/**
+	 * @param vec the categories with cumulative category probabilities
+	 */
+	CondomUseCategories(const std::vector<CondomUseProbabilities>& vec);
+
+	double drawUseProbability(double draw) const {
+		return use_probabilities[categories.draw(draw)];
+	}
+};
 
 class CondomUseAssigner {
 
 private:
 	friend class CondomUseAssignerFactory;
-	std::vector<CondomUseProbabilities> casual_sd_probs, casual_sc_probs;
-	std::vector<CondomUseProbabilities> steady_sd_probs, steady_sc_probs;
+	CondomUseCategories casual_sd_probs, casual_sc_probs;
+	CondomUseCategories steady_sd_probs, steady_sc_probs;
 
-	void updateEdge(std::vector<CondomUseProbabilities>& vec, std::shared_ptr<Edge<Person>> edge);
+	void updateEdge(const CondomUseCategories& categories, std::shared_ptr<Edge<Person>> edge);
 
 public:
 	CondomUseAssigner();
@@ -8,8 +8,6 @@
 #ifndef SRC_DIAGNOSER_H_
 #define SRC_DIAGNOSER_H_
 
-#include <memory>
-
 #include "repast_hpc/Random.h"
 
 #include "common.h"
@@ -19,24 +17,37 @@ namespace TransModel {
 
 enum class Result {POSITIVE, NEGATIVE, NO_TEST};
 
+/**
+ * Tests for infection at intervals drawn from a generator. The generator
+ * is shared by all Diagnosers and is not owned by them, so it must outlive
+ * them.
+ */
 template<typename G>
 class Diagnoser {
 
 private:
-	float detection_window_;
 	double next_test_at_, last_test_at_;
+	G* next_test_generator_;
+	float detection_window_;
 	unsigned int test_count_;
-	std::shared_ptr<G> next_test_generator_;
 
 public:
-	Diagnoser(float detection_window, float next_test_at, unsigned int test_count, std::shared_ptr<G> generator);
-	Diagnoser(double tick, float detection_window, std::shared_ptr<G> generator);
-	virtual ~Diagnoser();
+	Diagnoser(float detection_window, float next_test_at, unsigned int test_count, G* generator);
+	Diagnoser(double tick, float detection_window, G* generator);
+	~Diagnoser();
 
 	Result test(double tick, const InfectionParameters& inf_params);
 
 	double timeUntilNextTest(double current_tick) const;
 
+	/**
+	 * Gets the time of the next test. A call to test with a tick
+	 * earlier than this will always return NO_TEST.
+	 */
+	double nextTestAt() const {
+		return next_test_at_;
+	}
+
 	unsigned int testCount() const;
 
 	double lastTestAt() const;
@@ -44,14 +55,14 @@ public:
 };
 
 template<typename G>
-Diagnoser<G>::Diagnoser(float detection_window, float next_test_at, unsigned int test_count, std::shared_ptr<G> generator) :
-		detection_window_ { detection_window }, next_test_at_ { next_test_at }, last_test_at_{-1}, test_count_ { test_count }, next_test_generator_ {
-				generator } {
+Diagnoser<G>::Diagnoser(float detection_window, float next_test_at, unsigned int test_count, G* generator) :
+		next_test_at_ { next_test_at }, last_test_at_{-1}, next_test_generator_ { generator }, detection_window_ {
+				detection_window }, test_count_ { test_count } {
 }
 
 template<typename G>
-Diagnoser<G>::Diagnoser(double tick, float detection_window, std::shared_ptr<G> generator) : detection_window_{detection_window},
-	next_test_at_{tick + generator->next()}, last_test_at_{-1}, test_count_{0}, next_test_generator_ {generator } {
+Diagnoser<G>::Diagnoser(double tick, float detection_window, G* generator) : next_test_at_{tick + generator->next()},
+	last_test_at_{-1}, next_test_generator_ {generator }, detection_window_{detection_window}, test_count_{0} {
 }
 
 template<typename G>
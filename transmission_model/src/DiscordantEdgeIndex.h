@@ -0,0 +1,103 @@
+/*
+ * DiscordantEdgeIndex.h
+ *
+ *  Created on: May 4, 2017
+ *      Author: nick
+ */
+
+#ifndef SRC_DISCORDANTEDGEINDEX_H_
+#define SRC_DISCORDANTEDGEINDEX_H_
+
+#include <vector>
+
+#include "Network.h"
+#include "IndexedSet.h"
+
+namespace TransModel {
+
+/**
+ * Partitions a network's edges by type into serodiscordant edges (exactly one
+ * vertex infected) and seroconcordant edges. The index listens to the network for
+ * edge additions and removals, but a change in a vertex's infection status
+ * must be passed to update for each of that vertex's edges.
+ *
+ * V is expected to have an isInfected() method.
+ */
+template<typename V>
+class DiscordantEdgeIndex: public NetworkListener<V> {
+
+private:
+	// indexed by edge type
+	std::vector<IndexedSet<EdgePtr<V>>> discordant, concordant;
+	IndexedSet<EdgePtr<V>> empty;
+
+	void ensureType(int type) {
+		if ((size_t) type >= discordant.size()) {
+			discordant.resize(type + 1);
+			concordant.resize(type + 1);
+		}
+	}
+
+public:
+	DiscordantEdgeIndex() :
+			discordant(), concordant(), empty() {
+	}
+
+	virtual ~DiscordantEdgeIndex() {
+	}
+
+	static bool isDiscordant(const EdgePtr<V>& edge) {
+		return edge->v1()->isInfected() != edge->v2()->isInfected();
+	}
+
+	void edgeAdded(const EdgePtr<V>& edge) override {
+		ensureType(edge->type());
+		if (isDiscordant(edge)) {
+			discordant[edge->type()].add(edge->id(), edge);
+		} else {
+			concordant[edge->type()].add(edge->id(), edge);
+		}
+	}
+
+	void edgeRemoved(const EdgePtr<V>& edge) override {
+		ensureType(edge->type());
+		if (!discordant[edge->type()].remove(edge->id())) {
+			concordant[edge->type()].remove(edge->id());
+		}
+	}
+
+	void edgesCleared() override {
+		discordant.clear();
+		concordant.clear();
+	}
+
+	/**
+	 * Reclassifies the specified edge after a change in the infection status
+	 * of one of its vertices.
+	 */
+	void update(const EdgePtr<V>& edge) {
+		edgeRemoved(edge);
+		edgeAdded(edge);
+	}
+
+	const IndexedSet<EdgePtr<V>>& discordantEdges(int type) const {
+		return (size_t) type < discordant.size() ? discordant[type] : empty;
+	}
+
+	/**
+	 * Gets the seroconcordant edges of the specified type. This is mutable so
+	 * that subsets of the edges can be sampled in place.
+	 */
+	IndexedSet<EdgePtr<V>>& concordantEdges(int type) {
+		ensureType(type);
+		return concordant[type];
+	}
+
+	size_t typeCount() const {
+		return discordant.size();
+	}
+};
+
+} /* namespace TransModel */
+
+#endif /* SRC_DISCORDANTEDGEINDEX_H_ */
@@ -28,17 +28,26 @@ struct InfectionParameters {
 	bool infection_status, art_status;
 	float time_since_infection, time_since_art_init; //time_since_art_cessation;
 	float dur_inf_by_age, viral_load, vl_art_traj_slope, cd4_count;
-	float time_of_infection, age_at_infection, time_of_art_init, cd4_at_art_init,
-		vl_at_art_init;
+	float time_of_infection, age_at_infection;
 
 	InfectionParameters() : infection_status(false), art_status(false),
 			time_since_infection(NAN), time_since_art_init(NAN), /*time_since_art_cessation(NAN),*/
 			dur_inf_by_age(NAN), viral_load(0), vl_art_traj_slope(NAN), cd4_count(0),
-			time_of_infection(NAN), age_at_infection(NAN), time_of_art_init(NAN), cd4_at_art_init(NAN),
-			vl_at_art_init(NAN){}
+			time_of_infection(NAN), age_at_infection(NAN) {}
 
 };
 
+/**
+ * The time, CD4 count and viral load at ART initiation. These are only
+ * read when writing output.
+ */
+struct ARTInitParameters {
+
+	float time_of_art_init, cd4_at_art_init, vl_at_art_init;
+
+	ARTInitParameters() : time_of_art_init(NAN), cd4_at_art_init(NAN), vl_at_art_init(NAN) {}
+};
+
 
 } /* namespace TransModel */
 
@@ -30,11 +30,11 @@ public:
 	Edge(unsigned int id, std::shared_ptr<V> v1, std::shared_ptr<V>, int type = 0);
 	virtual ~Edge();
 
-	std::shared_ptr<V> v1() const {
+	const std::shared_ptr<V>& v1() const {
 		return v1_;
 	}
 
-	std::shared_ptr<V> v2() const {
+	const std::shared_ptr<V>& v2() const {
 		return v2_;
 	}
 
@@ -0,0 +1,51 @@
+/*
+ * EdgeRandomStream.h
+ *
+ *  Created on: May 2, 2017
+ *      Author: nick
+ */
+
+#ifndef SRC_EDGERANDOMSTREAM_H_
+#define SRC_EDGERANDOMSTREAM_H_
+
+#include <cstdint>
+
+namespace TransModel {
+
+/**
+ * Small counter based random stream (splitmix64) whose sequence depends only on
+ * a per tick seed and an edge id. The draws for an edge are therefore independent
+ * of the order in which edges are visited and of which thread visits them.
+ */
+class EdgeRandomStream {
+
+private:
+	uint64_t state;
+
+	static uint64_t mix(uint64_t z) {
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		return z ^ (z >> 31);
+	}
+
+public:
+	EdgeRandomStream(uint64_t tick_seed, unsigned int edge_id) :
+			state(mix(tick_seed ^ mix(edge_id + 0x9E3779B97F4A7C15ULL))) {
+	}
+
+	uint64_t next() {
+		state += 0x9E3779B97F4A7C15ULL;
+		return mix(state);
+	}
+
+	/**
+	 * Gets the next double in [0, 1).
+	 */
+	double nextDouble() {
+		return (next() >> 11) * (1.0 / 9007199254740992.0);
+	}
+};
+
+} /* namespace TransModel */
+
+#endif /* SRC_EDGERANDOMSTREAM_H_ */
@@ -0,0 +1,48 @@
+/*
+ * EventStream.cpp
+ *
+ *  Created on: May 26, 2017
+ *      Author: nick
+ */
+
+#include <stdexcept>
+
+#include "EventStream.h"
+
+namespace TransModel {
+
+OutputLevel parse_output_level(const std::string& name) {
+	if (name == "off") {
+		return OutputLevel::OFF;
+	} else if (name == "aggregate") {
+		return OutputLevel::AGGREGATE;
+	} else if (name == "sampled") {
+		return OutputLevel::SAMPLED;
+	} else if (name == "full") {
+		return OutputLevel::FULL;
+	}
+	throw std::invalid_argument("Unknown output level: '" + name + "'");
+}
+
+OutputControl::OutputControl(OutputLevel output_level, double fraction) :
+		level(output_level), sample_fraction(fraction) {
+	if (fraction < 0 || fraction > 1) {
+		throw std::invalid_argument("Output sample fraction must be between 0 and 1");
+	}
+}
+
+IdSampler::IdSampler(double fraction) :
+		threshold(0), all(fraction >= 1) {
+	if (!all && fraction > 0) {
+		// fraction of 2^64
+		threshold = (uint64_t) (fraction * 18446744073709551616.0);
+	}
+}
+
+const std::string EventCount::header("\"tick\",\"type\",\"count\"");
+
+void EventCount::writeTo(FileOutput& out) {
+	out << tick << "," << type << "," << count << "\n";
+}
+
+} /* namespace TransModel */
@@ -0,0 +1,204 @@
+/*
+ * EventStream.h
+ *
+ *  Created on: May 26, 2017
+ *      Author: nick
+ */
+
+#ifndef SRC_EVENTSTREAM_H_
+#define SRC_EVENTSTREAM_H_
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include "StatsWriter.h"
+#include "FileOutput.h"
+
+namespace TransModel {
+
+/**
+ * How much of an output stream is recorded.
+ */
+enum class OutputLevel {
+	// nothing is recorded
+	OFF,
+	// only the number of events of each type per time step
+	AGGREGATE,
+	// the events of a fraction of the persons or edges
+	SAMPLED,
+	// every event
+	FULL
+};
+
+/**
+ * Parses an output level name: "off", "aggregate", "sampled" or "full".
+ */
+OutputLevel parse_output_level(const std::string& name);
+
+/**
+ * The output level of a stream and, for the SAMPLED level, the
+ * fraction of ids whose events are recorded.
+ */
+struct OutputControl {
+	OutputLevel level;
+	double sample_fraction;
+
+	OutputControl(OutputLevel level = OutputLevel::FULL, double sample_fraction = 1);
+};
+
+/**
+ * Selects a fraction of ids by hashing them. The selection doesn't use the
+ * model's random number generators and so doesn't change the model's results,
+ * and the same ids are selected by every sampler with the same fraction, so the
+ * sampled streams record the events of the same persons.
+ */
+class IdSampler {
+
+private:
+	uint64_t threshold;
+	bool all;
+
+public:
+	IdSampler(double fraction);
+
+	bool isSelected(long id) const {
+		if (all) {
+			return true;
+		}
+		// splitmix64 finalizer
+		uint64_t z = (uint64_t) id + 0x9E3779B97F4A7C15ULL;
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		z = z ^ (z >> 31);
+		return z < threshold;
+	}
+};
+
+/**
+ * The number of events of a type in a time step. This is what
+ * is written for a stream at the AGGREGATE level.
+ */
+struct EventCount {
+
+	static const std::string header;
+
+	double tick;
+	int type;
+	unsigned int count;
+
+	void writeTo(FileOutput& out);
+
+	template<typename V>
+	void visit(V& visitor) const {
+		visitor("tick", tick);
+		visitor("type", type);
+		visitor("count", count);
+	}
+};
+
+/**
+ * An output stream of T events, recorded according to the stream's OutputLevel.
+ */
+template<typename T>
+class EventStream {
+
+private:
+	OutputLevel level;
+	IdSampler sampler;
+	std::shared_ptr<StatsWriter<T>> writer;
+	std::shared_ptr<StatsWriter<EventCount>> count_writer;
+	// indexed by type + 1, as the type of entry infection events is -1
+	std::vector<unsigned int> counts;
+
+public:
+	/**
+	 * Creates an OFF stream.
+	 */
+	EventStream() :
+			level(OutputLevel::OFF), sampler(0), writer(), count_writer(), counts() {
+	}
+
+	/**
+	 * Creates a FULL or SAMPLED stream that writes the events to the writer.
+	 */
+	EventStream(std::shared_ptr<StatsWriter<T>> event_writer, const OutputControl& control) :
+			level(control.level), sampler(control.level == OutputLevel::SAMPLED ? control.sample_fraction : 1), writer(
+					event_writer), count_writer(), counts() {
+	}
+
+	/**
+	 * Creates an AGGREGATE stream that writes the per time step event counts to the writer.
+	 */
+	EventStream(std::shared_ptr<StatsWriter<EventCount>> event_count_writer) :
+			level(OutputLevel::AGGREGATE), sampler(1), writer(), count_writer(event_count_writer), counts() {
+	}
+
+	OutputLevel outputLevel() const {
+		return level;
+	}
+
+	/**
+	 * Records an event of the specified type for the specified person or edge id.
+	 * make is only called to create the event if the event is to be written.
+	 */
+	template<typename F>
+	void record(long id, int type, F make) {
+		if (level == OutputLevel::OFF) {
+			return;
+		} else if (level == OutputLevel::AGGREGATE) {
+			size_t idx = (size_t) (type + 1);
+			if (idx >= counts.size()) {
+				counts.resize(idx + 1, 0);
+			}
+			++counts[idx];
+		} else if (sampler.isSelected(id)) {
+			writer->addOutput(make());
+		}
+	}
+
+	/**
+	 * Writes the event counts of an AGGREGATE stream for the specified
+	 * tick in type order, and resets them.
+	 */
+	void endTick(double tick) {
+		if (level == OutputLevel::AGGREGATE) {
+			for (size_t i = 0; i < counts.size(); ++i) {
+				if (counts[i] > 0) {
+					count_writer->addOutput(EventCount { tick, (int) i - 1, counts[i] });
+					counts[i] = 0;
+				}
+			}
+		}
+	}
+
+	void flush() {
+		if (writer) {
+			writer->flush();
+		}
+		if (count_writer) {
+			count_writer->flush();
+		}
+	}
+};
+
+/**
+ * Creates an EventStream of T events to the specified file. An OFF stream has no
+ * file and an AGGREGATE stream writes EventCounts to the file. event_writer is only
+ * called, to get the EventWriter for HDF5 output, if the stream has a file.
+ */
+template<typename T, typename F>
+std::shared_ptr<EventStream<T>> create_event_stream(const std::string& fname, OutputFormat format, unsigned int buffer,
+		const OutputControl& control, std::shared_ptr<AsyncWriter> io, F event_writer) {
+	if (control.level == OutputLevel::OFF) {
+		return std::make_shared<EventStream<T>>();
+	} else if (control.level == OutputLevel::AGGREGATE) {
+		return std::make_shared<EventStream<T>>(create_stats_writer<EventCount>(fname, format, buffer, io, event_writer()));
+	}
+	return std::make_shared<EventStream<T>>(create_stats_writer<T>(fname, format, buffer, io, event_writer()), control);
+}
+
+} /* namespace TransModel */
+
+#endif /* SRC_EVENTSTREAM_H_ */
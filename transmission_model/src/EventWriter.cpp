@@ -5,98 +5,201 @@
  *      Author: nick
  */
 
+#include <stdexcept>
+#include <iostream>
+#include <algorithm>
+#include <cstdint>
+
+#include "boost/filesystem.hpp"
+#include "H5Cpp.h"
+
 #include "EventWriter.h"
+#include "file_utils.h"
 
 using namespace H5;
 
-namespace TransModel {
+namespace fs = boost::filesystem;
 
-EventWriter* EventWriter::instance_ = 0;
+namespace TransModel {
 
+const size_t EventDataSet::CHUNK_BYTES;
+
+namespace {
+
+size_t column_size(ColumnType type) {
+	switch (type) {
+	case ColumnType::FLOAT64:
+		return sizeof(double);
+	case ColumnType::FLOAT32:
+		return sizeof(float);
+	case ColumnType::INT32:
+		return sizeof(int32_t);
+	case ColumnType::UINT32:
+		return sizeof(uint32_t);
+	case ColumnType::BOOL:
+		return sizeof(unsigned char);
+	case ColumnType::STRING:
+		return sizeof(const char*);
+	}
+	throw std::invalid_argument("Unknown column type");
+}
 
-void EventWriter::initialize(const std::string& file_name, unsigned int buffer_size) {
-	if (instance_ != 0) {
-		delete instance_;
+void insert_member(CompType& comp_type, const std::string& name, size_t offset, ColumnType type) {
+	switch (type) {
+	case ColumnType::FLOAT64:
+		comp_type.insertMember(name, offset, PredType::NATIVE_DOUBLE);
+		break;
+	case ColumnType::FLOAT32:
+		comp_type.insertMember(name, offset, PredType::NATIVE_FLOAT);
+		break;
+	case ColumnType::INT32:
+		comp_type.insertMember(name, offset, PredType::NATIVE_INT32);
+		break;
+	case ColumnType::UINT32:
+		comp_type.insertMember(name, offset, PredType::NATIVE_UINT32);
+		break;
+	case ColumnType::BOOL:
+		comp_type.insertMember(name, offset, PredType::NATIVE_UINT8);
+		break;
+	case ColumnType::STRING:
+		comp_type.insertMember(name, offset, StrType(PredType::C_S1, H5T_VARIABLE));
+		break;
 	}
-	instance_ = new EventWriter(file_name, buffer_size);
 }
 
-EventWriter* EventWriter::instance() {
-	if (instance_ == 0)
-		throw std::domain_error("EventWriter must be initialized before instance() is called");
+}
+
+EventDataSet::EventDataSet(std::shared_ptr<H5::H5File> h5file, const std::string& name, const ColumnSchema& schema) :
+		file(h5file), type(), dataset(), defs(schema.columns()), offsets(), row_size(0), row(), rows(), strings(), col_idx(
+				0), row_count(0), written(0) {
 
-	return instance_;
+	if (defs.empty()) {
+		throw std::invalid_argument("Cannot create event dataset '" + name + "': schema has no columns");
+	}
+
+	for (auto& def : defs) {
+		offsets.push_back(row_size);
+		row_size += column_size(def.type);
+	}
+	row.resize(row_size);
+
+	try {
+		type.reset(new CompType(row_size));
+		for (size_t i = 0; i < defs.size(); ++i) {
+			insert_member(*type, defs[i].name, offsets[i], defs[i].type);
+		}
+
+		hsize_t dims[] = { 0 };
+		hsize_t max_dims[] = { H5S_UNLIMITED };
+		DataSpace space(1, dims, max_dims);
+
+		// chunking makes the dataset extendible
+		DSetCreatPropList cparms;
+		hsize_t chunk_dims[] = { std::max<hsize_t>(64, CHUNK_BYTES / row_size) };
+		cparms.setChunk(1, chunk_dims);
+		if (H5Zfilter_avail(H5Z_FILTER_DEFLATE)) {
+			cparms.setShuffle();
+			cparms.setDeflate(4);
+		}
+		dataset.reset(new DataSet(file->createDataSet(name, *type, space, cparms)));
+	} catch (Exception& ex) {
+		throw std::domain_error("Error creating event dataset '" + name + "': " + ex.getDetailMsg());
+	}
 }
 
+EventDataSet::~EventDataSet() {
+	try {
+		writeRows();
+		dataset->close();
+	} catch (std::exception& ex) {
+		std::cerr << "Error writing output: " << ex.what() << std::endl;
+	} catch (Exception& ex) {
+		std::cerr << "Error writing output: " << ex.getDetailMsg() << std::endl;
+	}
+}
 
-EventWriter::EventWriter(const std::string& fname, unsigned int buffer_size) :
-		file { nullptr }, dataset { nullptr }, event_type(sizeof(Event)), buffer_size_ { buffer_size }, events { }, offset {
-				0 } {
+char* EventDataSet::next(ColumnType col_type) {
+	if (col_idx == defs.size() || defs[col_idx].type != col_type) {
+		// discard the partial row so that the next row starts afresh
+		col_idx = 0;
+		throw std::invalid_argument("Event dataset row does not match the schema");
+	}
+	return row.data() + offsets[col_idx++];
+}
 
-	hsize_t dim[] = { 0 };
-	hsize_t maxdims[] = { H5S_UNLIMITED };
-	// rank is number of dimensions
-	int rank = 1;
-	DataSpace space(rank, dim, maxdims);
-	// delete the data in the old file or create a new one if it doesn't exist
-	file = new H5File(fname, H5F_ACC_TRUNC);
+void EventDataSet::operator()(const std::string& name, const std::string& val) {
+	char* data = next(ColumnType::STRING);
+	// deque elements are not moved by push_back so the pointer stays valid
+	strings.push_back(val);
+	const char* str = strings.back().c_str();
+	std::memcpy(data, &str, sizeof(const char*));
+}
 
-	// enable chunking so dataset will be extendible
+void EventDataSet::endRow() {
+	if (col_idx != defs.size()) {
+		col_idx = 0;
+		throw std::invalid_argument("Event dataset row does not match the schema");
+	}
+	col_idx = 0;
+	rows.insert(rows.end(), row.begin(), row.end());
+	++row_count;
+}
 
-	DSetCreatPropList cparms;
-	hsize_t chunk_dims[] = { buffer_size_ };
-	cparms.setChunk(rank, chunk_dims);
-	//cparms.setFillValue(event_type, &fill_event);
+void EventDataSet::writeRows() {
+	if (row_count == 0) {
+		return;
+	}
 
-	event_type.insertMember("tick", HOFFSET(Event, tick), PredType::NATIVE_DOUBLE);
-	event_type.insertMember("id", HOFFSET(Event, person_id), PredType::NATIVE_INT);
-	event_type.insertMember("time_of_infection", HOFFSET(Event, time_of_infection), PredType::NATIVE_FLOAT);
-	event_type.insertMember("time_of_art_init", HOFFSET(Event, time_of_art_init), PredType::NATIVE_FLOAT);
+	try {
+		hsize_t size[] = { written + row_count };
+		dataset->extend(size);
 
-	StrType str_type(PredType::C_S1);
-	str_type.setSize(H5T_VARIABLE);
-	event_type.insertMember("event", HOFFSET(Event, event_type), str_type);
+		DataSpace fspace = dataset->getSpace();
+		hsize_t offset[] = { written };
+		hsize_t dims[] = { row_count };
+		fspace.selectHyperslab(H5S_SELECT_SET, dims, offset);
+		DataSpace memspace(1, dims, NULL);
+		dataset->write(rows.data(), *type, memspace, fspace);
+	} catch (Exception& ex) {
+		throw std::domain_error("Error writing event dataset: " + ex.getDetailMsg());
+	}
 
-	dataset = new DataSet(file->createDataSet("events", event_type, space, cparms));
+	written += row_count;
+	row_count = 0;
+	rows.clear();
+	strings.clear();
 }
 
-EventWriter::~EventWriter() {
-	writeEvents();
-	dataset->close();
-	file->close();
-	delete dataset;
-	delete file;
-}
+EventWriter::EventWriter(const std::string& fname) :
+		file(), fname_(unique_file_name(fname)) {
 
-void EventWriter::addEvent(double t, const PersonPtr& person, const std::string& event) {
-	events.push_back( Event{ t, person->id(),
-		person->infectionParameters().time_of_infection,
-		person->infectionParameters().time_of_art_init,
-		event.c_str() });
+	// errors are rethrown with the HDF5 message
+	Exception::dontPrint();
+	fs::path filepath(fname_);
+	if (!filepath.parent_path().empty() && !fs::exists(filepath.parent_path())) {
+		fs::create_directories(filepath.parent_path());
+	}
 
-	if (events.size() == buffer_size_) {
-		writeEvents();
+	try {
+		file = std::make_shared<H5File>(fname_, H5F_ACC_EXCL);
+	} catch (Exception& ex) {
+		throw std::domain_error("Error creating HDF5 file '" + fname_ + "': " + ex.getDetailMsg());
 	}
 }
 
-void EventWriter::writeEvents() {
-	if (events.size() > 0) {
-		hsize_t size[1];
-		// offset is the count of all the events
-		size[0] = events.size() + offset;
-		dataset->extend(size);
+EventWriter::~EventWriter() {
+}
 
-		DataSpace fspace = dataset->getSpace();
-		hsize_t offsets[1];
-		offsets[0] = offset;
-		offset += events.size();
-		hsize_t dims[1];
-		dims[0] = events.size();
-		fspace.selectHyperslab(H5S_SELECT_SET, dims, offsets);
-		DataSpace memspace(1, dims, NULL);
-		dataset->write(events.data(), event_type, memspace, fspace);
-		events.clear();
+std::shared_ptr<EventDataSet> EventWriter::createDataSet(const std::string& name, const ColumnSchema& schema) {
+	if (H5Lexists(file->getId(), name.c_str(), H5P_DEFAULT) > 0) {
+		throw std::invalid_argument("Event dataset '" + name + "' already exists in " + fname_);
 	}
+	return std::make_shared<EventDataSet>(file, name, schema);
+}
+
+std::string dataset_name(const std::string& fname) {
+	std::string name = fs::path(fname).filename().string();
+	return name.substr(0, name.find('.'));
 }
 
 } /* namespace TransModel */
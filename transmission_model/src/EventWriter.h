@@ -9,48 +9,143 @@
 #define SRC_EVENTWRITER_H_
 
 #include <vector>
+#include <deque>
+#include <string>
+#include <memory>
+#include <cstring>
 
-#include "H5Cpp.h"
+#include "ColumnarWriter.h"
 
-#include "common.h"
+namespace H5 {
+class H5File;
+class DataSet;
+class CompType;
+}
 
 namespace TransModel {
 
-struct Event {
+/**
+ * An extendible, chunked and compressed HDF5 dataset of compound type
+ * rows, one member per column of a ColumnSchema.
+ *
+ * A row is added by calling operator() for each value in schema order
+ * and then endRow, which is how the visit method of the output structs
+ * calls it. The rows added since the last call to writeRows are appended
+ * to the dataset by writeRows.
+ */
+class EventDataSet {
 
-	double tick;
-	int person_id;
-	float time_of_infection;
-	float time_of_art_init;
-	const char* event_type;
+private:
+	std::shared_ptr<H5::H5File> file;
+	std::unique_ptr<H5::CompType> type;
+	std::unique_ptr<H5::DataSet> dataset;
+	std::vector<ColumnSchema::ColumnDef> defs;
+	// offset of each column in a packed row
+	std::vector<size_t> offsets;
+	size_t row_size;
+	// the row being added, which is appended to rows when it is ended
+	std::vector<char> row;
+	std::vector<char> rows;
+	// the rows' strings, which are written as pointers to these
+	std::deque<std::string> strings;
+	size_t col_idx, row_count;
+	unsigned long long written;
+
+	char* next(ColumnType type);
+
+	template<typename T>
+	void append(ColumnType type, T val) {
+		std::memcpy(next(type), &val, sizeof(T));
+	}
 
+public:
+	/**
+	 * Chunks are this many bytes, or 64 rows if that is larger.
+	 */
+	static const size_t CHUNK_BYTES = 1 << 16;
+
+	EventDataSet(std::shared_ptr<H5::H5File> file, const std::string& name, const ColumnSchema& schema);
+	~EventDataSet();
+
+	void operator()(const std::string& name, double val) {
+		append(ColumnType::FLOAT64, val);
+	}
+
+	void operator()(const std::string& name, float val) {
+		append(ColumnType::FLOAT32, val);
+	}
+
+	void operator()(const std::string& name, int val) {
+		append(ColumnType::INT32, val);
+	}
+
+	void operator()(const std::string& name, unsigned int val) {
+		append(ColumnType::UINT32, val);
+	}
+
+	void operator()(const std::string& name, bool val) {
+		append(ColumnType::BOOL, (unsigned char) val);
+	}
+
+	void operator()(const std::string& name, const std::string& val);
+
+	/**
+	 * Ends the current row. A row is only added once it is ended, so
+	 * a row left incomplete by an error is never written.
+	 */
+	void endRow();
+
+	/**
+	 * Appends the rows added since the previous call to the dataset.
+	 */
+	void writeRows();
+
+	/**
+	 * Gets the number of rows written to the dataset.
+	 */
+	unsigned long long size() const {
+		return written;
+	}
 };
 
+/**
+ * A single HDF5 file holding each event stream as an EventDataSet.
+ * The file stays open until the writer and all its datasets are destroyed.
+ *
+ * The HDF5 library is not thread safe, so once created all the datasets should
+ * be written from the same thread.
+ */
 class EventWriter {
 
 private:
-	static EventWriter* instance_;
-
-	H5::H5File* file;
-	H5::DataSet* dataset;
-	H5::CompType event_type;
-	unsigned int buffer_size_;
-	std::vector<Event> events;
-	hsize_t offset;
-
-	void writeEvents();
-
-	EventWriter(const std::string& fname, unsigned int buffer_size);
+	std::shared_ptr<H5::H5File> file;
+	std::string fname_;
 
 public:
+	/**
+	 * Creates the file, or a uniquely named one if the file already exists.
+	 */
+	EventWriter(const std::string& fname);
 	~EventWriter();
-	static void initialize(const std::string& file_name, unsigned int buffer_size);
-	static EventWriter* instance();
 
-	void addEvent(double t, const PersonPtr& person, const std::string & event);
+	/**
+	 * Creates the named dataset with the schema's columns.
+	 *
+	 * @throws std::invalid_argument if the dataset already exists.
+	 */
+	std::shared_ptr<EventDataSet> createDataSet(const std::string& name, const ColumnSchema& schema);
 
+	const std::string& fileName() const {
+		return fname_;
+	}
 };
 
+/**
+ * Gets the name of the EventWriter dataset for output to the specified file: the
+ * file name up to its first '.', e.g. partnership_events for
+ * output/partnership_events.csv.
+ */
+std::string dataset_name(const std::string& fname);
 
 } /* namespace TransModel */
 
@@ -41,6 +41,10 @@
 
 #include <boost/filesystem.hpp>
 #include <sstream>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <stdexcept>
 
 #include "FileOutput.h"
 #include "file_utils.h"
@@ -51,18 +55,26 @@ namespace fs = boost::filesystem;
 namespace TransModel {
 
 FileOutput::FileOutput(const std::string& filename) :
-		out(), open(true) {
+		out(), open(true), buffer(new char[BUFFER_SIZE]), pos(0), compressor(create_compressor(filename)) {
 
 	std::string fname = unique_file_name(filename);
 	fs::path filepath(fname);
 	if (!fs::exists(filepath.parent_path()))
 		fs::create_directories(filepath.parent_path());
-	out.open(filepath.string().c_str());
+	if (compressor) {
+		out.open(filepath.string().c_str(), std::ios::out | std::ios::binary);
+	} else {
+		out.open(filepath.string().c_str());
+	}
 }
 
 
 void FileOutput::close() {
 	if (open) {
+		flushBuffer();
+		if (compressor) {
+			compressor->finish(out);
+		}
 		out.flush();
 		out.close();
 		open = false;
@@ -73,56 +85,119 @@ FileOutput::~FileOutput() {
 	close();
 }
 
-std::ostream& FileOutput::ostream() {
+void FileOutput::checkOpen() {
 	if (!open) {
 		throw std::logic_error("Cannot write to closed FileOutput");
 	}
-	return out;
 }
 
-std::ostream& FileOutput::operator<<(const std::string& val) {
-	if (open) {
-		out << val;
+void FileOutput::write(const char* val, size_t size) {
+	if (compressor) {
+		compressor->write(val, size, out);
 	} else {
-		throw std::logic_error("Cannot write to closed FileOutput");
+		out.write(val, size);
 	}
-	return out;
 }
 
-std::ostream& FileOutput::operator<<(unsigned int val) {
-	if (open) {
-		out << val;
-	} else {
-		throw std::logic_error("Cannot write to closed FileOutput");
+void FileOutput::flushBuffer() {
+	if (pos > 0) {
+		write(buffer.get(), pos);
+		pos = 0;
 	}
+}
+
+std::ostream& FileOutput::ostream() {
+	checkOpen();
+	if (compressor) {
+		throw std::logic_error("Cannot get the ostream of compressed FileOutput");
+	}
+	flushBuffer();
 	return out;
 }
 
-std::ostream& FileOutput::operator<<(int val) {
-	if (open) {
-		out << val;
+void FileOutput::append(const char* val, size_t size) {
+	checkOpen();
+	if (size > BUFFER_SIZE) {
+		flushBuffer();
+		write(val, size);
 	} else {
-		throw std::logic_error("Cannot write to closed FileOutput");
+		std::memcpy(reserve(size), val, size);
+		pos += size;
 	}
-	return out;
 }
 
-std::ostream& FileOutput::operator<<(double val) {
-	if (open) {
-		out << val;
+void FileOutput::appendUnsigned(unsigned long val) {
+	checkOpen();
+	char digits[MAX_NUMBER_SIZE];
+	char* end = digits + MAX_NUMBER_SIZE;
+	char* start = end;
+	do {
+		*--start = (char) ('0' + val % 10);
+		val /= 10;
+	} while (val != 0);
+
+	size_t size = end - start;
+	std::memcpy(reserve(size), start, size);
+	pos += size;
+}
+
+void FileOutput::appendSigned(long val) {
+	if (val < 0) {
+		append("-", 1);
+		// negate as unsigned so that the minimum long doesn't overflow
+		appendUnsigned(0UL - (unsigned long) val);
 	} else {
-		throw std::logic_error("Cannot write to closed FileOutput");
+		appendUnsigned((unsigned long) val);
 	}
-	return out;
 }
 
-std::ostream& FileOutput::operator<<(float val) {
-	if (open) {
-		out << val;
+void FileOutput::appendDouble(double val) {
+	// integral values with fewer than 7 digits are formatted the same by %g
+	// as integers. -0 is left to %g, which formats it as "-0".
+	if (val > -1e6 && val < 1e6 && val == (double) (long) val && !(val == 0 && std::signbit(val))) {
+		appendSigned((long) val);
 	} else {
-		throw std::logic_error("Cannot write to closed FileOutput");
+		checkOpen();
+		// snprintf in the "C" locale, as used by a default ostream
+		int size = std::snprintf(reserve(MAX_NUMBER_SIZE), MAX_NUMBER_SIZE, "%g", val);
+		pos += size;
 	}
-	return out;
+}
+
+FileOutput& FileOutput::operator<<(const std::string& val) {
+	append(val.data(), val.size());
+	return *this;
+}
+
+FileOutput& FileOutput::operator<<(const char* val) {
+	append(val, std::strlen(val));
+	return *this;
+}
+
+FileOutput& FileOutput::operator<<(unsigned int val) {
+	appendUnsigned(val);
+	return *this;
+}
+
+FileOutput& FileOutput::operator<<(int val) {
+	appendSigned(val);
+	return *this;
+}
+
+FileOutput& FileOutput::operator<<(bool val) {
+	append(val ? "1" : "0", 1);
+	return *this;
+}
+
+FileOutput& FileOutput::operator<<(double val) {
+	appendDouble(val);
+	return *this;
+}
+
+FileOutput& FileOutput::operator<<(float val) {
+	// an ostream formats floats as doubles
+	appendDouble(val);
+	return *this;
 }
 
 } /* namespace mrsa */
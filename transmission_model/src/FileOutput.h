@@ -43,21 +43,38 @@
 
 #include <fstream>
 #include <string>
+#include <memory>
+
+#include "Compressor.h"
 
 namespace TransModel {
 
 /**
+ * Buffered file output. Values are formatted directly into a fixed size
+ * buffer, without going through an ostream's locale-aware formatting, and the
+ * buffer is written to the file when full. The formatting is the same as
+ * that of a default std::ostream: floating point values are formatted as
+ * with %g.
  *
+ * If the file name ends in .gz or .zst, the output is compressed with gzip or
+ * zstd as the buffer is written.
  */
 class FileOutput {
 public:
 
-	std::ostream& operator<<(const std::string& val);
-	std::ostream& operator<<(double val);
-	std::ostream& operator<<(float val);
-	std::ostream& operator<<(unsigned int val);
-	std::ostream& operator<<(int val);
+	FileOutput& operator<<(const std::string& val);
+	FileOutput& operator<<(const char* val);
+	FileOutput& operator<<(double val);
+	FileOutput& operator<<(float val);
+	FileOutput& operator<<(unsigned int val);
+	FileOutput& operator<<(int val);
+	FileOutput& operator<<(bool val);
 
+	/**
+	 * Gets the underlying ostream, writing any buffered output to it first.
+	 *
+	 * @throws std::logic_error if the output is compressed.
+	 */
 	std::ostream& ostream();
 
 	FileOutput(const std::string& filename);
@@ -69,8 +86,31 @@ public:
 	void close();
 
 private:
+	static const size_t BUFFER_SIZE = 1 << 16;
+	// room for any formatted number
+	static const size_t MAX_NUMBER_SIZE = 32;
+
 	std::ofstream out;
 	bool open;
+	std::unique_ptr<char[]> buffer;
+	size_t pos;
+	std::unique_ptr<Compressor> compressor;
+
+	void checkOpen();
+	void flushBuffer();
+	void write(const char* val, size_t size);
+
+	char* reserve(size_t size) {
+		if (pos + size > BUFFER_SIZE) {
+			flushBuffer();
+		}
+		return buffer.get() + pos;
+	}
+
+	void append(const char* val, size_t size);
+	void appendUnsigned(unsigned long val);
+	void appendSigned(long val);
+	void appendDouble(double val);
 };
 
 } /* namespace mrsa */
@@ -0,0 +1,122 @@
+/*
+ * IndexedSet.h
+ *
+ *  Created on: May 4, 2017
+ *      Author: nick
+ */
+
+#ifndef SRC_INDEXEDSET_H_
+#define SRC_INDEXEDSET_H_
+
+#include <vector>
+#include <unordered_map>
+
+namespace TransModel {
+
+/**
+ * Unordered set of items keyed by unsigned int id with O(1) add, remove,
+ * membership test and random access. Items are stored contiguously
+ * and removal swaps the last item into the removed item's place, so the order
+ * of the items is not preserved across removals.
+ */
+template<typename T>
+class IndexedSet {
+
+private:
+	std::vector<unsigned int> ids;
+	std::vector<T> items;
+	// key: id, value: index into items
+	std::unordered_map<unsigned int, size_t> positions;
+
+public:
+	typedef typename std::vector<T>::const_iterator const_iterator;
+
+	IndexedSet() :
+			ids(), items(), positions() {
+	}
+
+	/**
+	 * Adds the item with the specified id, if an item with that id
+	 * is not already in the set.
+	 *
+	 * @return true if the item was added, otherwise false.
+	 */
+	bool add(unsigned int id, const T& item) {
+		if (positions.emplace(id, items.size()).second) {
+			ids.push_back(id);
+			items.push_back(item);
+			return true;
+		}
+		return false;
+	}
+
+	/**
+	 * Removes the item with the specified id.
+	 *
+	 * @return true if the item was removed, otherwise false.
+	 */
+	bool remove(unsigned int id) {
+		auto iter = positions.find(id);
+		if (iter == positions.end()) {
+			return false;
+		}
+
+		size_t idx = iter->second;
+		size_t last = items.size() - 1;
+		if (idx != last) {
+			ids[idx] = ids[last];
+			items[idx] = items[last];
+			positions[ids[idx]] = idx;
+		}
+		ids.pop_back();
+		items.pop_back();
+		positions.erase(id);
+		return true;
+	}
+
+	bool contains(unsigned int id) const {
+		return positions.find(id) != positions.end();
+	}
+
+	/**
+	 * Swaps the positions of the items at i and j.
+	 */
+	void swap(size_t i, size_t j) {
+		if (i != j) {
+			std::swap(ids[i], ids[j]);
+			std::swap(items[i], items[j]);
+			positions[ids[i]] = i;
+			positions[ids[j]] = j;
+		}
+	}
+
+	const T& operator[](size_t idx) const {
+		return items[idx];
+	}
+
+	size_t size() const {
+		return items.size();
+	}
+
+	bool empty() const {
+		return items.empty();
+	}
+
+	void clear() {
+		ids.clear();
+		items.clear();
+		positions.clear();
+	}
+
+	const_iterator begin() const {
+		return items.begin();
+	}
+
+	const_iterator end() const {
+		return items.end();
+	}
+};
+
+} /* namespace TransModel */
+
+#endif /* SRC_INDEXEDSET_H_ */
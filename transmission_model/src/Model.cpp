@@ -6,30 +6,32 @@
  */
 #include "boost/algorithm/string.hpp"
 #include "boost/filesystem.hpp"
+#include "boost/random/uniform_int_distribution.hpp"
 
 #include "repast_hpc/Random.h"
 #include "repast_hpc/RepastProcess.h"
 #include "repast_hpc/Utilities.h"
 
 #include "Parameters.h"
+#include "ModelConfig.h"
 #include "Model.h"
 #include "network_utils.h"
 #include "common.h"
 #include "TransmissionRunner.h"
 #include "DiseaseParameters.h"
 #include "PersonCreator.h"
-#include "ARTScheduler.h"
 #include "Stats.h"
 #include "StatsBuilder.h"
 #include "file_utils.h"
 #include "utils.h"
-#include "PrepCessationEvent.h"
 #include "art_functions.h"
 #include "CondomUseAssigner.h"
+#include "EdgeRandomStream.h"
+#include "ModelRandom.h"
+#include "PoolAllocator.h"
 
 #include "debug_utils.h"
 
-//#include "EventWriter.h"
 
 using namespace Rcpp;
 using namespace std;
@@ -88,7 +90,7 @@ struct PersonToVAL {
 			vertex["infectivity"] = p->infectivity();
 			vertex["art.status"] = p->isOnART();
 			vertex["inf.status"] = p->isInfected();
-			vertex["time.since.infection"] = p->infectionParameters().time_since_infection;
+			vertex["time.since.infection"] = p->timeSinceInfection();
 			vertex["time.of.infection"] = p->infectionParameters().time_of_infection;
 			vertex["age.at.infection"] = p->infectionParameters().age_at_infection;
 			vertex["viral.load.today"] = p->infectionParameters().viral_load;
@@ -106,11 +108,11 @@ struct PersonToVAL {
 		vertex["adherence.category"] = static_cast<int>(p->adherence().category);
 
 		if (p->isOnART()) {
-			vertex["time.since.art.initiation"] = p->infectionParameters().time_since_art_init;
-			vertex["time.of.art.initiation"] = p->infectionParameters().time_of_art_init;
+			vertex["time.since.art.initiation"] = p->timeSinceARTInit();
+			vertex["time.of.art.initiation"] = p->artInitParameters().time_of_art_init;
 			vertex["vl.art.traj.slope"] = p->infectionParameters().vl_art_traj_slope;
-			vertex["cd4.at.art.initiation"] = p->infectionParameters().cd4_at_art_init;
-			vertex["vl.at.art.initiation"] = p->infectionParameters().vl_at_art_init;
+			vertex["cd4.at.art.initiation"] = p->artInitParameters().cd4_at_art_init;
+			vertex["vl.at.art.initiation"] = p->artInitParameters().vl_at_art_init;
 		} else {
 			vertex["time.since.art.initiation"] = NA_REAL;
 			vertex["time.of.art.initiation"] = NA_REAL;
@@ -217,17 +219,104 @@ void init_generators() {
 	Random::instance()->putGenerator(CIRCUM_STATUS_BINOMIAL, new DefaultNumberGenerator<BinomialGen>(rate));
 }
 
+// the format of the output to the file of the specified file property is
+// set by the property with .file replaced by .format, e.g. partnership.events.format,
+// and otherwise by the output.format property for all the files
+OutputFormat output_format(const std::string& file_prop) {
+	std::string format_prop = file_prop.substr(0, file_prop.rfind(".file")) + ".format";
+	if (Parameters::instance()->contains(format_prop)) {
+		return parse_output_format(Parameters::instance()->getStringParameter(format_prop));
+	} else if (Parameters::instance()->contains(OUTPUT_FORMAT)) {
+		return parse_output_format(Parameters::instance()->getStringParameter(OUTPUT_FORMAT));
+	}
+	return OutputFormat::CSV;
+}
+
+// the output level of the file of the specified file property is set by the
+// property with .file replaced by .level, e.g. partnership.events.level, and
+// defaults to full. The sampled level also needs the fraction of persons or
+// edges to sample, e.g. partnership.events.sample.fraction.
+OutputControl output_control(const std::string& file_prop) {
+	std::string prefix = file_prop.substr(0, file_prop.rfind(".file"));
+	Parameters* params = Parameters::instance();
+	if (!params->contains(prefix + ".level")) {
+		return OutputControl();
+	}
+	OutputLevel level = parse_output_level(params->getStringParameter(prefix + ".level"));
+	if (level == OutputLevel::SAMPLED) {
+		return OutputControl(level, params->getDoubleParameter(prefix + ".sample.fraction"));
+	}
+	return OutputControl(level);
+}
+
+// the csv output to the file of the specified file property is compressed if the
+// property with .file replaced by .compression is gzip or zstd, e.g.
+// partnership.events.compression. The file name is given a .gz or .zst
+// extension and FileOutput compresses by that extension. Only csv output
+// can be compressed, so compression of columnar or HDF5 output is an error.
+std::string output_file(const std::string& file_prop) {
+	std::string fname = Parameters::instance()->getStringParameter(file_prop);
+	std::string compression_prop = file_prop.substr(0, file_prop.rfind(".file")) + ".compression";
+	if (Parameters::instance()->contains(compression_prop)) {
+		std::string compression = Parameters::instance()->getStringParameter(compression_prop);
+		std::string ext;
+		if (compression == "gzip") {
+			ext = ".gz";
+		} else if (compression == "zstd") {
+			ext = ".zst";
+		} else if (compression != "none") {
+			throw std::invalid_argument("Unknown output compression '" + compression + "' for " + file_prop);
+		}
+		if (!boost::algorithm::ends_with(fname, ext)) {
+			fname += ext;
+		}
+	}
+	if ((boost::algorithm::ends_with(fname, ".gz") || boost::algorithm::ends_with(fname, ".zst"))
+			&& output_format(file_prop) != OutputFormat::CSV) {
+		throw std::invalid_argument("Compression of " + file_prop + " is only supported for csv output");
+	}
+	return fname;
+}
+
 void init_stats() {
-	StatsBuilder builder(output_directory(Parameters::instance()));
-	builder.countsWriter(Parameters::instance()->getStringParameter(COUNTS_PER_TIMESTEP_OUTPUT_FILE));
-	builder.partnershipEventWriter(Parameters::instance()->getStringParameter(PARTNERSHIP_EVENTS_FILE));
-	builder.infectionEventWriter(Parameters::instance()->getStringParameter(INFECTION_EVENTS_FILE));
-	builder.biomarkerWriter(Parameters::instance()->getStringParameter(BIOMARKER_FILE));
-	builder.deathEventWriter(Parameters::instance()->getStringParameter(DEATH_EVENT_FILE));
-	builder.personDataRecorder(Parameters::instance()->getStringParameter(PERSON_DATA_FILE));
-	builder.testingEventWriter(Parameters::instance()->getStringParameter(TESTING_EVENT_FILE));
-	builder.artEventWriter(Parameters::instance()->getStringParameter(ART_EVENT_FILE));
-	builder.prepEventWriter(Parameters::instance()->getStringParameter(PREP_EVENT_FILE));
+	Parameters* params = Parameters::instance();
+	StatsBuilder builder(output_directory(params));
+	if (params->contains(EVENT_FILE)) {
+		builder.hdf5File(params->getStringParameter(EVENT_FILE));
+	}
+	if (params->contains(SUMMARY_FILE)) {
+		std::vector<WindowedAggregate> aggregates;
+		if (params->contains(SUMMARY_AGGREGATES)) {
+			aggregates = parse_windowed_aggregates(params->getStringParameter(SUMMARY_AGGREGATES));
+		}
+		builder.summaryFile(params->getStringParameter(SUMMARY_FILE), aggregates);
+	}
+	builder.countsWriter(output_file(COUNTS_PER_TIMESTEP_OUTPUT_FILE), output_format(COUNTS_PER_TIMESTEP_OUTPUT_FILE));
+	builder.partnershipEventWriter(output_file(PARTNERSHIP_EVENTS_FILE), output_format(PARTNERSHIP_EVENTS_FILE), 1000,
+			output_control(PARTNERSHIP_EVENTS_FILE));
+	builder.infectionEventWriter(output_file(INFECTION_EVENTS_FILE), output_format(INFECTION_EVENTS_FILE), 1000,
+			output_control(INFECTION_EVENTS_FILE));
+	builder.biomarkerWriter(output_file(BIOMARKER_FILE), output_format(BIOMARKER_FILE), 1000,
+			output_control(BIOMARKER_FILE));
+	builder.deathEventWriter(output_file(DEATH_EVENT_FILE), output_format(DEATH_EVENT_FILE), 1000,
+			output_control(DEATH_EVENT_FILE));
+	builder.personDataRecorder(output_file(PERSON_DATA_FILE), output_control(PERSON_DATA_FILE).level);
+	builder.testingEventWriter(output_file(TESTING_EVENT_FILE), output_format(TESTING_EVENT_FILE), 1000,
+			output_control(TESTING_EVENT_FILE));
+	builder.artEventWriter(output_file(ART_EVENT_FILE), output_format(ART_EVENT_FILE), 1000,
+			output_control(ART_EVENT_FILE));
+	builder.prepEventWriter(output_file(PREP_EVENT_FILE), output_format(PREP_EVENT_FILE), 1000,
+			output_control(PREP_EVENT_FILE));
+	if (params->contains(TRACE_CONTENTS) && !params->contains(TRACE_FILE)) {
+		// only biomarkers are traced without a trace file
+		std::string contents = params->getStringParameter(TRACE_CONTENTS);
+		if ((parse_trace_contents(contents) & ~TRACE_BIOMARKERS) != 0) {
+			throw std::invalid_argument("trace.contents '" + contents + "' requires trace.file to be set");
+		}
+	}
+	if (params->contains(TRACE_FILE)) {
+		builder.traceEventWriter(output_file(TRACE_FILE), output_format(TRACE_FILE), 1000, output_control(TRACE_FILE));
+	}
 
 	builder.createStatsSingleton();
 }
@@ -253,20 +342,30 @@ void init_network_save(Model* model) {
 	}
 }
 
-void init_biomarker_logging(Network<Person>& net, std::set<int>& ids_to_log) {
-	int number_to_log = Parameters::instance()->getIntParameter(BIOMARKER_LOG_COUNT);
+// selects biomarker.number.of.persons.to.log of the initial persons to trace, setting
+// their trace flags to trace.contents, which defaults to biomarkers. The selection is
+// made whatever the contents so that the random draws are the same.
+void init_trace(Network<Person>& net) {
+	Parameters* params = Parameters::instance();
+	int number_to_log = params->getIntParameter(BIOMARKER_LOG_COUNT);
+	unsigned char contents = TRACE_BIOMARKERS;
+	if (params->contains(TRACE_CONTENTS)) {
+		contents = parse_trace_contents(params->getStringParameter(TRACE_CONTENTS));
+	}
 	std::vector<PersonPtr> persons;
 	for (auto iter = net.verticesBegin(); iter != net.verticesEnd(); ++iter) {
 		persons.push_back(*iter);
 	}
 
+	std::vector<bool> selected(persons.size(), false);
 	IntUniformGenerator gen = Random::instance()->createUniIntGenerator(0, persons.size() - 1);
 	for (int i = 0; i < number_to_log; ++i) {
-		int id = (int) gen.next();
-		while (ids_to_log.find(id) != ids_to_log.end()) {
-			id = (int) gen.next();
+		int idx = (int) gen.next();
+		while (selected[idx]) {
+			idx = (int) gen.next();
 		}
-		ids_to_log.emplace(id);
+		selected[idx] = true;
+		persons[idx]->setTrace(contents);
 	}
 }
 
@@ -348,6 +447,27 @@ CondomUseAssigner create_condom_use_assigner() {
 	return factory.createAssigner();
 }
 
+std::shared_ptr<SexActSampler> create_sex_act_sampler() {
+	std::string name = BERNOULLI_SAMPLER;
+	if (Parameters::instance()->contains(SEX_ACTS_SAMPLER)) {
+		name = Parameters::instance()->getStringParameter(SEX_ACTS_SAMPLER);
+	}
+	return create_sex_act_sampler(name);
+}
+
+std::shared_ptr<ThreadPool> create_transmission_pool() {
+	if (Parameters::instance()->contains(TRANSMISSION_THREADS)) {
+		int threads = Parameters::instance()->getIntParameter(TRANSMISSION_THREADS);
+		if (threads < 0) {
+			throw std::invalid_argument("transmission.threads must be >= 0");
+		}
+		if (threads > 0) {
+			return std::make_shared<ThreadPool>((unsigned int) threads);
+		}
+	}
+	return nullptr;
+}
+
 RangeWithProbability create_ASM_runner() {
 	RangeWithProbabilityCreator creator;
 	vector<string> keys;
@@ -359,18 +479,30 @@ RangeWithProbability create_ASM_runner() {
 }
 
 Model::Model(shared_ptr<RInside>& ri, const std::string& net_var, const std::string& cas_net_var) :
-		R(ri), net(false), trans_runner(create_transmission_runner()), cd4_calculator(create_CD4Calculator()), viral_load_calculator(
+		R(ri), trans_runner(create_transmission_runner()), cd4_calculator(create_CD4Calculator()), viral_load_calculator(
 				create_ViralLoadCalculator()), viral_load_slope_calculator(create_ViralLoadSlopeCalculator()), current_pop_size {
-				0 }, previous_pop_size { 0 }, stage_map { }, persons_to_log { }, person_creator { trans_runner,
-				Parameters::instance()->getDoubleParameter(DAILY_TESTING_PROB),
-				Parameters::instance()->getDoubleParameter(DETECTION_WINDOW) }, trans_params { }, art_lag_calculator {
-				create_art_lag_calc() }, cessation_generator { create_cessation_generator() }, condom_assigner {
-				create_condom_use_assigner() }, asm_runner { create_ASM_runner() } {
+				0 }, previous_pop_size { 0 }, stage_map { }, person_creator { trans_runner,
+				ModelConfig::instance().daily_testing_prob,
+				ModelConfig::instance().detection_window }, net(false), trans_params { }, art_lag_calculator {
+				create_art_lag_calc() }, cessation_generator { create_cessation_generator() }, person_events {
+				ModelConfig::instance().partial_art_adher_window_length, [this](const SlotRef& ref) {
+					return person_creator.find(ref);}, [this](const PersonPtr& p) {
+					prep_eligible.update(p);} }, condom_assigner {
+				create_condom_use_assigner() }, asm_sampler { create_ASM_runner() }, edge_index { }, sex_act_sampler { create_sex_act_sampler() }, sex_act_idxs { }, sex_act_batch { }, trans_pool {
+				create_transmission_pool() }, testing_queue { }, max_age {
+				ModelConfig::instance().max_age }, age_out_queue { }, asm_queue { }, due { }, vital_flags { }, prep_eligible { }, prep_starts { }, trans_edges { }, trans_partitions { } {
 
 	// get initial stats
 	init_stats();
 	init_trans_params(trans_params);
 
+	Person::setYearsPerTick(ModelConfig::instance().size_of_timestep / 365.0f);
+	init_adherence_categories();
+	// initial persons are aged from the first step, at tick 1, and
+	// after this the clock is only advanced by updateVitals
+	Person::setClock(1);
+	net.addListener(&edge_index);
+
 	List rnet = as<List>((*R)[net_var]);
 	initialize_network(rnet, net, person_creator, condom_assigner, STEADY_NETWORK_TYPE);
 	rnet = as<List>((*R)[cas_net_var]);
@@ -381,13 +513,20 @@ Model::Model(shared_ptr<RInside>& ri, const std::string& net_var, const std::str
 
 	current_pop_size = net.vertexCount();
 
-	init_biomarker_logging(net, persons_to_log);
+	init_trace(net);
+
 	Stats* stats = TransModel::Stats::instance();
 	stats->currentCounts().main_edge_count = net.edgeCount(STEADY_NETWORK_TYPE);
 	stats->currentCounts().casual_edge_count = net.edgeCount(CASUAL_NETWORK_TYPE);
 	stats->currentCounts().size = net.vertexCount();
 	for (auto iter = net.verticesBegin(); iter != net.verticesEnd(); ++iter) {
 		PersonPtr p = *iter;
+		if (p->isTestable() && !p->isDiagnosed()) {
+			// first step is at tick 1
+			scheduleTest(p, 1);
+		}
+		scheduleDeaths(p, 1);
+		prep_eligible.update(p);
 		stats->personDataRecorder().initRecord(p, 0);
 		if (p->isInfected()) {
 			++stats->currentCounts().internal_infected;
@@ -399,39 +538,56 @@ Model::Model(shared_ptr<RInside>& ri, const std::string& net_var, const std::str
 	init_generators();
 
 	ScheduleRunner& runner = RepastProcess::instance()->getScheduleRunner();
-	runner.scheduleStop(Parameters::instance()->getDoubleParameter("stop.at"));
+	runner.scheduleStop(ModelConfig::instance().stop_at);
 	runner.scheduleEvent(1, 1, Schedule::FunctorPtr(new MethodFunctor<Model>(this, &Model::step)));
 	runner.scheduleEndEvent(Schedule::FunctorPtr(new MethodFunctor<Model>(this, &Model::atEnd)));
 
 	initPrepCessation();
+	initAdherenceChecks();
 
 	//write_edges(net, "./edges_at_1.csv");
 }
 
 void Model::initPrepCessation() {
-	ScheduleRunner& runner = RepastProcess::instance()->getScheduleRunner();
 	for (auto iter = net.verticesBegin(); iter != net.verticesEnd(); ++iter) {
 		PersonPtr person = *iter;
 		if (person->isOnPrep()) {
 			double stop_time = person->prepParameters().stopTime();
-			runner.scheduleEvent(stop_time, Schedule::FunctorPtr(new PrepCessationEvent(person, stop_time)));
+			person_events.schedulePrepCessation(person, stop_time);
 			double start_time = person->prepParameters().startTime();
-			Stats::instance()->recordPREPEvent(start_time, person->id(), static_cast<int>(PrepStatus::ON));
-			Stats::instance()->personDataRecorder().recordPREPStart(person->id(), start_time);
+			Stats::instance()->recordPREPEvent(start_time, person->id(), PrepStatus::ON);
+			Stats::instance()->traceEvent(start_time, *person, TRACE_TREATMENT, TraceEvent::PREP_STARTED, -1, 0);
+			Stats::instance()->personDataRecorder().recordPREPStart(person->slot(), start_time);
+		}
+	}
+}
+
+void Model::initAdherenceChecks() {
+	// initial persons are created at tick 0
+	double check_at = ModelConfig::instance().partial_art_adher_window_length;
+	for (auto iter = net.verticesBegin(); iter != net.verticesEnd(); ++iter) {
+		PersonPtr person = *iter;
+		if (person->isOnART()) {
+			person_events.scheduleAdherenceCheck(person, check_at);
 		}
 	}
 }
 
 void Model::atEnd() {
 	double ts = RepastProcess::instance()->getScheduleRunner().currentTick();
+	person_events.finish(ts);
 	PersonDataRecorder& pdr = Stats::instance()->personDataRecorder();
 	for (auto iter = net.verticesBegin(); iter != net.verticesEnd(); ++iter) {
 		pdr.finalize(*iter, ts);
 	}
 
-	// forces stat writing via destructors
+	// writes the remaining output and waits for the I/O thread to finish writing it
+	Stats::instance()->close();
 	delete Stats::instance();
 
+	std::cout << "person pool: " << PoolAllocator<Person>::stats() << std::endl;
+	std::cout << "edge pool: " << PoolAllocator<Edge<Person>>::stats() << std::endl;
+
 	//write_edges(net, "./edges_at_end.csv");
 }
 
@@ -470,15 +626,18 @@ void Model::step() {
 	double t = RepastProcess::instance()->getScheduleRunner().currentTick();
 	Stats* stats = Stats::instance();
 	stats->currentCounts().tick = t;
+	// the person clock is already t: it is only advanced where
+	// persons are aged, in updateVitals
+	person_events.run(t);
 
 	PersonToVALForSimulate p2val;
-	float max_survival = Parameters::instance()->getFloatParameter(MAX_AGE);
-	float size_of_timestep = Parameters::instance()->getIntParameter(SIZE_OF_TIMESTEP);
+	const ModelConfig& config = ModelConfig::instance();
+	float size_of_timestep = config.size_of_timestep;
 
 	if ((int) t % 100 == 0)
 		std::cout << " ---- " << t << " ---- " << std::endl;
 	simulate(R, net, p2val, condom_assigner, t);
-	if (Parameters::instance()->getBooleanParameter(COUNT_OVERLAPS)) {
+	if (config.count_overlaps) {
 		countOverlap();
 	} else {
 		stats->currentCounts().overlaps = -1;
@@ -486,7 +645,7 @@ void Model::step() {
 	entries(t, size_of_timestep);
 	runTransmission(t);
 	vector<PersonPtr> uninfected;
-	updateVitals(t, size_of_timestep, max_survival, uninfected);
+	updateVitals(t, size_of_timestep, uninfected);
 	runExternalInfections(uninfected, t);
 	previous_pop_size = current_pop_size;
 	current_pop_size = net.vertexCount();
@@ -501,52 +660,82 @@ void Model::step() {
 	stats->resetForNextTimeStep();
 }
 
-void Model::schedulePostDiagnosisART(PersonPtr person, std::map<double, ARTScheduler*>& art_map, double tick,
-		float size_of_timestep) {
+void Model::scheduleTest(const PersonPtr& person, long min_tick) {
+	long at = (long) std::ceil(person->nextTestAt());
+	testing_queue.push(std::max(at, min_tick), person->slot());
+}
+
+void Model::scheduleDeaths(const PersonPtr& person, long min_tick) {
+	// dies at the tick whose step takes the clock to the age out clock
+	long age_out_at = std::max((long) person->ageOutClock(max_age) - 1, min_tick);
+	age_out_queue.push(age_out_at, person->slot());
+
+	// death of old age takes precedence, so no ASM trial at age_out_at
+	long asm_at = asm_sampler.drawDeathTick(*person, min_tick, age_out_at);
+	if (asm_at != -1) {
+		asm_queue.push(asm_at, person->slot());
+	}
+}
+
+void Model::flagDue(CalendarQueue<SlotRef>& queue, long tick, unsigned char flag) {
+	const SlotAllocator& slots = person_creator.slots();
+	due.clear();
+	queue.pop(tick, due);
+	for (auto& ref : due) {
+		// persons who have died since being queued are skipped
+		if (slots.isCurrent(ref)) {
+			vital_flags[ref.slot] |= flag;
+		}
+	}
+}
+
+void Model::schedulePostDiagnosisART(PersonPtr person, double tick, float size_of_timestep) {
 	double lag = art_lag_calculator->calculateLag(size_of_timestep);
 	Stats::instance()->personDataRecorder().recordInitialARTLag(person, lag);
 
-	double art_at_tick = lag + tick;
-	ARTScheduler* scheduler = nullptr;
-	auto iter = art_map.find(art_at_tick);
-	if (iter == art_map.end()) {
-		scheduler = new ARTScheduler((float) art_at_tick);
-		RepastProcess::instance()->getScheduleRunner().scheduleEvent(art_at_tick - 0.1,
-				repast::Schedule::FunctorPtr(scheduler));
-		art_map.emplace(art_at_tick, scheduler);
-	} else {
-		scheduler = iter->second;
-	}
-	scheduler->addPerson(person);
+	float art_at_tick = lag + tick;
+	person_events.scheduleARTInit(person, art_at_tick);
 }
 
-// ASSUMES PERSON IS UNINFECTED
-void Model::updatePREPUse(double tick, double prob, PersonPtr person) {
-	if (!person->isOnPrep() && Random::instance()->nextDouble() <= prob) {
-		ScheduleRunner& runner = RepastProcess::instance()->getScheduleRunner();
+void Model::runPrepUptake(double tick, double prob) {
+	prep_eligible.sample(prob, prep_starts);
+	for (auto& person : prep_starts) {
 		double stop_time = tick + cessation_generator->next();
 		person->goOnPrep(tick, stop_time);
-		Stats::instance()->recordPREPEvent(tick, person->id(), static_cast<int>(PrepStatus::ON));
-		Stats::instance()->personDataRecorder().recordPREPStart(person->id(), tick);
-		runner.scheduleEvent(stop_time, Schedule::FunctorPtr(new PrepCessationEvent(person, stop_time)));
+		prep_eligible.update(person);
+		Stats::instance()->recordPREPEvent(tick, person->id(), PrepStatus::ON);
+		Stats::instance()->traceEvent(tick, *person, TRACE_TREATMENT, TraceEvent::PREP_STARTED, -1, 0);
+		Stats::instance()->personDataRecorder().recordPREPStart(person->slot(), tick);
+		person_events.schedulePrepCessation(person, stop_time);
 	}
 }
 
-void Model::updateVitals(double t, float size_of_timestep, int max_age, vector<PersonPtr>& uninfected) {
+void Model::updateVitals(double t, float size_of_timestep, vector<PersonPtr>& uninfected) {
 	unsigned int dead_count = 0;
 	Stats* stats = Stats::instance();
-	map<double, ARTScheduler*> art_map;
 
-	double p = Parameters::instance()->getDoubleParameter(PREP_DAILY_STOP_PROB);
-	double k = Parameters::instance()->getDoubleParameter(PREP_USE_PROP);
+	double p = ModelConfig::instance().prep_daily_stop_prob;
+	double k = ModelConfig::instance().prep_use_prop;
 	double on_prep_prob = (p * k) / (1 - k);
 
 	uninfected.reserve(net.vertexCount());
-
+	runPrepUptake(t, on_prep_prob);
+
+	vital_flags.resize(person_creator.slots().capacity(), 0);
+	flagDue(testing_queue, (long) t, TEST_DUE);
+	flagDue(age_out_queue, (long) t, AGED_OUT);
+	flagDue(asm_queue, (long) t, ASM_DEATH);
+
+	// persons are aged by this step, so the vitals calculated below use
+	// their age and times since infection and ART initiation at t. This
+	// is the only place the clock is advanced during a run, so it is
+	// t from the start of step t until here and t + 1 after.
+	Person::setClock(t + 1);
 	for (auto iter = net.verticesBegin(); iter != net.verticesEnd();) {
 		PersonPtr person = (*iter);
 		// update viral load
 		if (person->isInfected()) {
+			person->updateTimeSince(t);
 			if (person->isOnART()) {
 				float slope = viral_load_slope_calculator.calculateSlope(person->infectionParameters());
 				person->setViralLoadARTSlope(slope);
@@ -555,29 +744,33 @@ void Model::updateVitals(double t, float size_of_timestep, int max_age, vector<P
 			float viral_load = viral_load_calculator.calculateViralLoad(person->infectionParameters());
 			person->setViralLoad(viral_load);
 			// update cd4
-			float cd4 = cd4_calculator.calculateCD4(person->age(), person->infectionParameters());
+			float cd4 = cd4_calculator.calculateCD4(person->ageAt(t), person->infectionParameters());
 			person->setCD4Count(cd4);
 
 			// select stage, and use it
-			float infectivity = stage_map.upper_bound(person->timeSinceInfection())->second->calculateInfectivity(
+			float infectivity = stage_map.upper_bound(person->infectionParameters().time_since_infection)->second->calculateInfectivity(
 					person->infectionParameters());
 			person->setInfectivity(infectivity);
-		} else {
-			updatePREPUse(t, on_prep_prob, person);
 		}
 
-		if (persons_to_log.find(person->id()) != persons_to_log.end()) {
+		if (person->isTraced(TRACE_BIOMARKERS)) {
 			stats->recordBiomarker(t, person);
 		}
 
-		if (person->isTestable() && !person->isDiagnosed()) {
+		unsigned char& flags = vital_flags[person->slot().slot];
+		if (flags & TEST_DUE) {
 			if (person->diagnose(t)) {
-				schedulePostDiagnosisART(person, art_map, t, size_of_timestep);
+				schedulePostDiagnosisART(person, t, size_of_timestep);
+			} else {
+				scheduleTest(person, (long) t + 1);
 			}
 		}
 
-		person->step(size_of_timestep);
-		CauseOfDeath cod = dead(t, person, max_age);
+		bool aged_out = flags & AGED_OUT;
+		bool asm_death = flags & ASM_DEATH;
+		flags = 0;
+
+		CauseOfDeath cod = dead(t, person, aged_out, asm_death);
 		if (cod != CauseOfDeath::NONE) {
 			vector<EdgePtr<Person>> edges;
 			PartnershipEvent::PEventType pevent_type = cod_to_PEvent(cod);
@@ -585,7 +778,10 @@ void Model::updateVitals(double t, float size_of_timestep, int max_age, vector<P
 			for (auto edge : edges) {
 				//cout << edge->id() << "," << static_cast<int>(cod) << "," << static_cast<int>(pevent_type) << endl;
 				Stats::instance()->recordPartnershipEvent(t, edge->id(), edge->v1()->id(), edge->v2()->id(), pevent_type, edge->type());
+				trace_partnership_event(t, edge, TraceEvent::PARTNERSHIP_ENDED);
 			}
+			prep_eligible.remove(*person);
+			person_creator.release(person);
 			iter = net.removeVertex(iter);
 			++dead_count;
 		} else {
@@ -600,18 +796,24 @@ void Model::updateVitals(double t, float size_of_timestep, int max_age, vector<P
 }
 
 void Model::runExternalInfections(vector<PersonPtr>& uninfected, double t) {
-	double min = Parameters::instance()->getDoubleParameter(EXTERNAL_INFECTION_RATE_MIN);
-	double max = Parameters::instance()->getDoubleParameter(EXTERNAL_INFECTION_RATE_MAX);
-	double val = Random::instance()->createUniDoubleGenerator(min, max).next();
+	if (uninfected.empty()) {
+		return;
+	}
+
+	double min = ModelConfig::instance().external_infection_rate_min;
+	double max = ModelConfig::instance().external_infection_rate_max;
+	ModelRandom& rng = ModelRandom::instance();
+	double val = min + (max - min) * rng.uniform();
 	// std::cout << val << std::endl;
 	double prob = uninfected.size() * val;
 	//std::cout << uninfected.size() << ", " << prob << std::endl;
-	if (Random::instance()->nextDouble() <= prob) {
+	if (rng.bernoulli(prob)) {
 		Stats* stats = Stats::instance();
-		PersonPtr p = uninfected[(int)Random::instance()->createUniIntGenerator(0, uninfected.size() - 1).next()];
+		PersonPtr p = uninfected[rng.uniformInt(0, uninfected.size() - 1)];
 		infectPerson(p, t);
 		++stats->currentCounts().external_infected;
 		stats->personDataRecorder().recordInfection(p, t, InfectionSource::EXTERNAL);
+		stats->traceEvent(t, *p, TRACE_INFECTION, TraceEvent::INFECTED, -1, -1);
 	}
 }
 
@@ -622,27 +824,28 @@ void Model::infectPerson(PersonPtr& person, double time_stamp) {
 	net.getEdges(person, edges);
 	for (EdgePtr<Person> ptr : edges) {
 		condom_assigner.initEdge(ptr);
+		edge_index.update(ptr);
 	}
+	prep_eligible.update(person);
 }
 
 void Model::entries(double tick, float size_of_timestep) {
-	float min_age = Parameters::instance()->getFloatParameter(MIN_AGE);
+	const ModelConfig& config = ModelConfig::instance();
+	float min_age = config.min_age;
 	size_t pop_size = net.vertexCount();
 	if (pop_size > 0) {
-		double births_prob = Parameters::instance()->getDoubleParameter(DAILY_ENTRY_RATE);
-		PoissonGen birth_gen(Random::instance()->engine(),
-				boost::random::poisson_distribution<>(births_prob));
-		DefaultNumberGenerator<PoissonGen> gen(birth_gen);
-		int entries = (int) gen.next();
+		double births_prob = config.daily_entry_rate;
+		ModelRandom& rng = ModelRandom::instance();
+		int entries = (int) rng.poisson(births_prob);
 		Stats* stats = Stats::instance();
 		stats->currentCounts().entries = entries;
 		//std::cout << "entries: " << entries << std::endl;
 
-		double infected_prob = Parameters::instance()->getDoubleParameter(INIT_HIV_PREV_ENTRIES);
+		double infected_prob = config.init_hiv_prev_entries;
 
 		for (int i = 0; i < entries; ++i) {
 			VertexPtr<Person> p = person_creator(tick, min_age);
-			if (Random::instance()->nextDouble() <= infected_prob) {
+			if (rng.bernoulli(infected_prob)) {
 				// as if infected at previous timestep
 				float infected_at = tick - (size_of_timestep * 1);
 				trans_runner->infect(p, infected_at);
@@ -655,6 +858,11 @@ void Model::entries(double tick, float size_of_timestep) {
 				stats->recordInfectionEvent(infected_at, p);
 			}
 			net.addVertex(p);
+			if (p->isTestable()) {
+				scheduleTest(p, (long) tick);
+			}
+			scheduleDeaths(p, (long) tick);
+			prep_eligible.update(p);
 			Stats::instance()->personDataRecorder().initRecord(p, tick);
 		}
 	}
@@ -693,11 +901,11 @@ void Model::saveRNetwork() {
 	}
 }
 
-CauseOfDeath Model::dead(double tick, PersonPtr person, int max_age) {
+CauseOfDeath Model::dead(double tick, PersonPtr person, bool aged_out, bool asm_death) {
 	int death_count = 0;
 	CauseOfDeath cod = CauseOfDeath::NONE;
 	// dead of old age
-	if (person->deadOfAge(max_age)) {
+	if (aged_out) {
 		++death_count;
 		++Stats::instance()->currentCounts().age_deaths;
 		Stats::instance()->recordDeathEvent(tick, person, DeathEvent::AGE);
@@ -714,7 +922,7 @@ CauseOfDeath Model::dead(double tick, PersonPtr person, int max_age) {
 		cod = CauseOfDeath::INFECTION;
 	}
 
-	if (cod == CauseOfDeath::NONE && asm_runner.run(person->age(), Random::instance()->nextDouble())) {
+	if (cod == CauseOfDeath::NONE && asm_death) {
 		// asm deaths
 		++death_count;
 		++Stats::instance()->currentCounts().asm_deaths;
@@ -727,85 +935,162 @@ CauseOfDeath Model::dead(double tick, PersonPtr person, int max_age) {
 	return cod;
 }
 
-bool Model::hasSex(int edge_type) {
-	double prob;
+double Model::sexActProbability(int edge_type) const {
 	if (edge_type == STEADY_NETWORK_TYPE) {
-		prob = trans_params.prop_steady_sex_acts;
-	} else {
-		prob = trans_params.prop_casual_sex_acts;
+		return trans_params.prop_steady_sex_acts;
 	}
+	return trans_params.prop_casual_sex_acts;
+}
 
-	return Random::instance()->nextDouble() <= prob;
+bool Model::hasSex(int edge_type, double draw) const {
+	return draw <= sexActProbability(edge_type);
 }
 
-void record_sex_act(int edge_type, bool condom_used, bool discordant, Stats* stats) {
-	++stats->currentCounts().sex_acts;
+void record_sex_act(int edge_type, bool condom_used, bool discordant, Counts& counts) {
+	++counts.sex_acts;
 	if (edge_type == STEADY_NETWORK_TYPE) {
 
-		++stats->currentCounts().steady_sex_acts;
+		++counts.steady_sex_acts;
 		if (condom_used) {
 			if (discordant) {
-				++stats->currentCounts().sd_steady_sex_with_condom;
+				++counts.sd_steady_sex_with_condom;
 			} else {
-				++stats->currentCounts().sc_steady_sex_with_condom;
+				++counts.sc_steady_sex_with_condom;
 			}
 		} else {
 			if (discordant) {
-				++stats->currentCounts().sd_steady_sex_without_condom;
+				++counts.sd_steady_sex_without_condom;
 			} else {
-				++stats->currentCounts().sc_steady_sex_without_condom;
+				++counts.sc_steady_sex_without_condom;
 			}
 		}
 	} else {
-		++stats->currentCounts().casual_sex_acts;
+		++counts.casual_sex_acts;
 		if (condom_used) {
 			if (discordant) {
-				++stats->currentCounts().sd_casual_sex_with_condom;
+				++counts.sd_casual_sex_with_condom;
 			} else {
-				++stats->currentCounts().sc_casual_sex_with_condom;
+				++counts.sc_casual_sex_with_condom;
 			}
 		} else {
 			if (discordant) {
-				++stats->currentCounts().sd_casual_sex_without_condom;
+				++counts.sd_casual_sex_without_condom;
 			} else {
-				++stats->currentCounts().sc_casual_sex_without_condom;
+				++counts.sc_casual_sex_without_condom;
 			}
 		}
 	}
 }
 
+void Model::runConcordantSexActs(int edge_type, Counts& counts) {
+	IndexedSet<EdgePtr<Person>>& edges = edge_index.concordantEdges(edge_type);
+	if (edges.empty()) {
+		return;
+	}
+
+	ModelRandom& rng = ModelRandom::instance();
+	size_t acts = (size_t) rng.binomial((long) edges.size(), sexActProbability(edge_type));
+
+	// partial Fisher-Yates: after i iterations the first i edges
+	// are a uniform random subset of size i.
+	for (size_t i = 0; i < acts; ++i) {
+		edges.swap(i, rng.uniformInt(i, edges.size() - 1));
+		bool condom_used = edges[i]->useCondom(rng.uniform());
+		record_sex_act(edge_type, condom_used, false, counts);
+	}
+}
+
 void Model::runTransmission(double time_stamp) {
-	vector<PersonPtr> infecteds;
+	if (trans_pool) {
+		runPartitionedTransmission(time_stamp);
+		return;
+	}
 
-	//std::cout << sex_acts_per_time_step << ", " << node_count << ", " << edge_count << ", " << prob << std::endl;
+	vector<PersonPtr> infecteds;
 	Stats* stats = Stats::instance();
-	for (auto iter = net.edgesBegin(); iter != net.edgesEnd(); ++iter) {
-		int type = (*iter)->type();
-		if (hasSex(type)) {
-			bool condom_used = (*iter)->useCondom(Random::instance()->nextDouble());
-			bool discordant = false;
-			PersonPtr out_p = (*iter)->v1();
-			PersonPtr in_p = (*iter)->v2();
-			if (out_p->isInfected() && !in_p->isInfected()) {
-				discordant = true;
-
-				if (trans_runner->determineInfection(out_p, in_p, condom_used, type)) {
-					infecteds.push_back(in_p);
-					Stats::instance()->recordInfectionEvent(time_stamp, out_p, in_p, false, (*iter)->type());
-				}
-			} else if (!out_p->isInfected() && in_p->isInfected()) {
-				discordant = true;
+	ModelRandom& rng = ModelRandom::instance();
+	for (int type = 0; type < (int) edge_index.typeCount(); ++type) {
+		runConcordantSexActs(type, stats->currentCounts());
+
+		const IndexedSet<EdgePtr<Person>>& discordant = edge_index.discordantEdges(type);
+		sex_act_sampler->sample(discordant.size(), sexActProbability(type), sex_act_idxs);
+		sex_act_batch.clear();
+		for (size_t idx : sex_act_idxs) {
+			const EdgePtr<Person>& edge = discordant[idx];
+			bool condom_used = edge->useCondom(rng.uniform());
+			bool v1_infected = edge->v1()->isInfected();
+			const PersonPtr& infector = v1_infected ? edge->v1() : edge->v2();
+			const PersonPtr& infectee = v1_infected ? edge->v2() : edge->v1();
+
+			sex_act_batch.infectivities.push_back(infector->infectivity());
+			sex_act_batch.keys.push_back(trans_runner->multiplierKey(infector, infectee, condom_used, type));
+			sex_act_batch.draws.push_back(rng.uniform());
+			record_sex_act(type, condom_used, true, stats->currentCounts());
+		}
 
-				if (trans_runner->determineInfection(in_p, out_p, condom_used, type)) {
-					infecteds.push_back(out_p);
-					Stats::instance()->recordInfectionEvent(time_stamp, in_p, out_p, false, (*iter)->type());
-				}
+		trans_runner->determineInfections(sex_act_batch.infectivities, sex_act_batch.keys, sex_act_batch.draws,
+				sex_act_batch.infected);
+		for (size_t i = 0; i < sex_act_idxs.size(); ++i) {
+			if (sex_act_batch.infected[i]) {
+				const EdgePtr<Person>& edge = discordant[sex_act_idxs[i]];
+				bool v1_infected = edge->v1()->isInfected();
+				const PersonPtr& infector = v1_infected ? edge->v1() : edge->v2();
+				const PersonPtr& infectee = v1_infected ? edge->v2() : edge->v1();
+				infecteds.push_back(infectee);
+				stats->recordInfectionEvent(time_stamp, infector, infectee, false, type);
 			}
+		}
+	}
+
+	applyInfections(infecteds, time_stamp);
+}
 
-			record_sex_act(type, condom_used, discordant, stats);
+void Model::runPartitionedTransmission(double time_stamp) {
+	// one seed per tick from the model's generator so that a run is reproducible
+	// for a given random seed, independent of the number of threads.
+	uint64_t tick_seed = ModelRandom::instance().engine()();
+
+	Stats* stats = Stats::instance();
+	trans_edges.clear();
+	for (int type = 0; type < (int) edge_index.typeCount(); ++type) {
+		runConcordantSexActs(type, stats->currentCounts());
+		for (auto& edge : edge_index.discordantEdges(type)) {
+			trans_edges.push_back(edge.get());
 		}
 	}
 
+	vector<TransmissionCandidate> candidates;
+	run_partitioned(*trans_pool, trans_edges, trans_partitions,
+			[this, tick_seed](Edge<Person>* edge, TransmissionPartition& partition) {
+				EdgeRandomStream stream(tick_seed, edge->id());
+				int type = edge->type();
+				if (hasSex(type, stream.nextDouble())) {
+					bool condom_used = edge->useCondom(stream.nextDouble());
+					bool v1_infected = edge->v1()->isInfected();
+					const PersonPtr& infector = v1_infected ? edge->v1() : edge->v2();
+					const PersonPtr& infectee = v1_infected ? edge->v2() : edge->v1();
+					if (trans_runner->determineInfection(infector, infectee, condom_used, type, stream.nextDouble())) {
+						partition.candidates.push_back( { edge->id(), type, infector, infectee });
+					}
+
+					record_sex_act(type, condom_used, true, partition.counts);
+				}
+			}, candidates);
+	for (auto& partition : trans_partitions) {
+		stats->currentCounts().addSexActs(partition.counts);
+	}
+
+	vector<PersonPtr> infecteds;
+	for (auto& candidate : candidates) {
+		infecteds.push_back(candidate.infectee);
+		stats->recordInfectionEvent(time_stamp, candidate.infector, candidate.infectee, false, candidate.edge_type);
+	}
+
+	applyInfections(infecteds, time_stamp);
+}
+
+void Model::applyInfections(vector<PersonPtr>& infecteds, double time_stamp) {
+	Stats* stats = Stats::instance();
 	for (auto& person : infecteds) {
 		// if person has multiple partners who are infected,
 		// person gets multiple chances to become infected from them
@@ -23,9 +23,18 @@
 #include "ViralLoadSlopeCalculator.h"
 #include "PersonCreator.h"
 #include "DayRangeCalculator.h"
-#include "ARTScheduler.h"
+#include "PersonEventScheduler.h"
 #include "CondomUseAssigner.h"
 #include "RangeWithProbability.h"
+#include "ASMSampler.h"
+#include "Stats.h"
+#include "ThreadPool.h"
+#include "TransmissionPartition.h"
+#include "DiscordantEdgeIndex.h"
+#include "SexActSampler.h"
+#include "CalendarQueue.h"
+#include "SlotAllocator.h"
+#include "PrepEligibleSet.h"
 
 namespace TransModel {
 
@@ -34,44 +43,124 @@ struct TransmissionParameters {
 };
 
 
+/**
+ * The discordant sex acts of a time step whose outcomes are
+ * determined in a single TransmissionRunner::determineInfections call.
+ */
+struct SexActBatch {
+	std::vector<float> infectivities;
+	std::vector<unsigned int> keys;
+	std::vector<double> draws;
+	std::vector<unsigned char> infected;
+
+	void clear() {
+		infectivities.clear();
+		keys.clear();
+		draws.clear();
+	}
+};
+
 enum class CauseOfDeath { NONE, AGE, INFECTION, ASM};
 
+enum VitalFlags : unsigned char {
+	TEST_DUE = 1, AGED_OUT = 2, ASM_DEATH = 4
+};
+
 class Model {
 
 private:
 	std::shared_ptr<RInside> R;
-	Network<Person> net;
 	std::shared_ptr<TransmissionRunner> trans_runner;
 	CD4Calculator cd4_calculator;
 	ViralLoadCalculator viral_load_calculator;
 	ViralLoadSlopeCalculator viral_load_slope_calculator;
 	unsigned int current_pop_size, previous_pop_size;
 	std::map<float, std::shared_ptr<Stage>> stage_map;
-	std::set<int> persons_to_log;
+	// declared before net and everything else that holds persons so that
+	// it is destroyed after them: their Diagnosers use its generator
 	PersonCreator person_creator;
+	Network<Person> net;
 	TransmissionParameters trans_params;
 	std::shared_ptr<DayRangeCalculator> art_lag_calculator;
 	std::shared_ptr<GeometricDistribution> cessation_generator;
+	PersonEventScheduler person_events;
 	CondomUseAssigner condom_assigner;
-	RangeWithProbability asm_runner;
+	ASMSampler asm_sampler;
+	DiscordantEdgeIndex<Person> edge_index;
+	std::shared_ptr<SexActSampler> sex_act_sampler;
+	std::vector<size_t> sex_act_idxs;
+	SexActBatch sex_act_batch;
+	std::shared_ptr<ThreadPool> trans_pool;
+	// slots of the testable, undiagnosed persons keyed by the tick of their next test
+	CalendarQueue<SlotRef> testing_queue;
+	int max_age;
+	// slots of persons keyed by the tick at which they will be older than max_age
+	CalendarQueue<SlotRef> age_out_queue;
+	// slots of persons keyed by the tick of their ASM death
+	CalendarQueue<SlotRef> asm_queue;
+	std::vector<SlotRef> due;
+	// VitalFlags of the persons due a test or death this tick, indexed by slot
+	std::vector<unsigned char> vital_flags;
+	// the uninfected persons who are not on PrEP
+	PrepEligibleSet prep_eligible;
+	std::vector<PersonPtr> prep_starts;
+	std::vector<Edge<Person>*> trans_edges;
+	std::vector<TransmissionPartition> trans_partitions;
 
 	void runTransmission(double timestamp);
-	CauseOfDeath dead(double tick, PersonPtr person, int max_survival);
+
+	/**
+	 * Runs transmission over the discordant edges split into contiguous partitions,
+	 * one per thread in the trans_pool. Each edge draws from its own
+	 * EdgeRandomStream so the results are the same for any number of threads.
+	 */
+	void runPartitionedTransmission(double timestamp);
+
+	/**
+	 * Records the sex acts on the seroconcordant edges of the specified type.
+	 * These cannot transmit, so rather than drawing for each edge the number of acts
+	 * is drawn from a binomial distribution and the condom use drawn for a
+	 * random subset of that size.
+	 */
+	void runConcordantSexActs(int edge_type, Counts& counts);
+	void applyInfections(std::vector<PersonPtr>& infecteds, double timestamp);
+	CauseOfDeath dead(double tick, PersonPtr person, bool aged_out, bool asm_death);
 	void entries(double tick, float size_of_time_step);
 	void deactivateEdges(int id, double time);
 
 	/**
 	 * @param uninfected empty vector into which the uninfected are placed
 	 */
-	void updateVitals(double time, float size_of_time_step, int max_survival,std::vector<PersonPtr>& uninfected);
+	void updateVitals(double time, float size_of_time_step, std::vector<PersonPtr>& uninfected);
 	void runExternalInfections(std::vector<PersonPtr>& uninfected, double time);
 
 	void infectPerson(PersonPtr& person, double time_stamp);
 	void updateThetaForm(const std::string& var_name);
 	void countOverlap();
 
-	bool hasSex(int type);
-	void schedulePostDiagnosisART(PersonPtr person, std::map<double, ARTScheduler*>& art_map, double tick, float size_of_timestep);
+	double sexActProbability(int edge_type) const;
+	bool hasSex(int type, double draw) const;
+	/**
+	 * Adds the person to the testing queue at the first tick >= min_tick
+	 * at which the person's Diagnoser will run a test.
+	 */
+	void scheduleTest(const PersonPtr& person, long min_tick);
+
+	/**
+	 * Adds the person to the age out queue at the tick whose step
+	 * takes the person's age past max_age, or min_tick if that is later, and
+	 * to the ASM queue at the tick of their ASM death if that is before
+	 * they age out.
+	 */
+	void scheduleDeaths(const PersonPtr& person, long min_tick);
+
+	/**
+	 * Pops the persons queued for the specified tick and sets the flag for those
+	 * still alive in vital_flags.
+	 */
+	void flagDue(CalendarQueue<SlotRef>& queue, long tick, unsigned char flag);
+
+	void schedulePostDiagnosisART(PersonPtr person, double tick, float size_of_timestep);
 
 	/**
 	 * Initializes PrEP cessation events for the initial set of persons.
@@ -79,9 +168,14 @@ private:
 	void initPrepCessation();
 
 	/**
-	 * Put prep with the specified probability.
+	 * Schedules the first ART adherence check for the initial set of persons on ART.
+	 */
+	void initAdherenceChecks();
+
+	/**
+	 * Puts each person in prep_eligible on PrEP with the specified probability.
 	 */
-	void updatePREPUse(double tick, double prob, PersonPtr person);
+	void runPrepUptake(double tick, double prob);
 
 public:
 	Model(std::shared_ptr<RInside>& r_ptr, const std::string& net_var, const std::string& cas_net_var);
@@ -0,0 +1,153 @@
+/*
+ * ModelConfig.cpp
+ *
+ *  Created on: May 15, 2017
+ *      Author: nick
+ */
+
+#include <cmath>
+#include <vector>
+#include <stdexcept>
+
+#include "ModelConfig.h"
+
+namespace TransModel {
+
+ModelConfig* ModelConfig::instance_ = 0;
+
+namespace {
+
+/**
+ * Reads typed parameter values, collecting the errors rather than
+ * throwing on the first one.
+ */
+class ConfigReader {
+
+private:
+	const Parameters& params;
+	std::vector<std::string> errors;
+
+	bool parse(const std::string& key, double& val) {
+		if (!params.contains(key)) {
+			errors.push_back("'" + key + "' is missing");
+			return false;
+		}
+
+		std::string str = params.getStringParameter(key);
+		size_t pos = 0;
+		try {
+			val = std::stod(str, &pos);
+		} catch (std::exception& ex) {
+			pos = 0;
+		}
+		if (pos == 0 || str.find_first_not_of(" \t", pos) != std::string::npos) {
+			errors.push_back("'" + key + "' is not a number: '" + str + "'");
+			return false;
+		}
+		return true;
+	}
+
+public:
+	ConfigReader(const Parameters& parameters) :
+			params(parameters), errors() {
+	}
+
+	double getDouble(const std::string& key) {
+		double val = 0;
+		parse(key, val);
+		return val;
+	}
+
+	int getInt(const std::string& key) {
+		double val = 0;
+		if (parse(key, val) && val != std::floor(val)) {
+			errors.push_back("'" + key + "' is not an integer: '" + params.getStringParameter(key) + "'");
+		}
+		return (int) val;
+	}
+
+	bool getBoolean(const std::string& key) {
+		if (!params.contains(key)) {
+			errors.push_back("'" + key + "' is missing");
+			return false;
+		}
+
+		std::string val = params.getStringParameter(key);
+		if (val == "true" || val == "TRUE") {
+			return true;
+		} else if (val != "false" && val != "FALSE") {
+			errors.push_back("'" + key + "' is not a boolean: '" + val + "'");
+		}
+		return false;
+	}
+
+	void check() {
+		if (errors.size() > 0) {
+			std::string msg = "Invalid model parameters:";
+			for (auto& error : errors) {
+				msg += "\n\t" + error;
+			}
+			throw std::invalid_argument(msg);
+		}
+	}
+};
+
+}
+
+ModelConfig ModelConfig::create(const Parameters& params) {
+	ConfigReader reader(params);
+	ModelConfig config;
+
+	config.stop_at = reader.getDouble(STOP_AT);
+	config.size_of_timestep = reader.getInt(SIZE_OF_TIMESTEP);
+	config.count_overlaps = reader.getBoolean(COUNT_OVERLAPS);
+
+	config.min_age = (float) reader.getDouble(MIN_AGE);
+	// truncated as in the previous (int) getFloatParameter(MAX_AGE)
+	config.max_age = (int) (float) reader.getDouble(MAX_AGE);
+	config.daily_entry_rate = reader.getDouble(DAILY_ENTRY_RATE);
+	config.init_hiv_prev_entries = reader.getDouble(INIT_HIV_PREV_ENTRIES);
+	config.external_infection_rate_min = reader.getDouble(EXTERNAL_INFECTION_RATE_MIN);
+	config.external_infection_rate_max = reader.getDouble(EXTERNAL_INFECTION_RATE_MAX);
+
+	config.pr_insertive_main = reader.getDouble(PR_INSERTIVE_MAIN);
+	config.pr_receptive_main = reader.getDouble(PR_RECEPTIVE_MAIN);
+	config.pr_insertive_casual = reader.getDouble(PR_INSERTIVE_CASUAL);
+	config.pr_receptive_casual = reader.getDouble(PR_RECEPTIVE_CASUAL);
+
+	config.daily_testing_prob = reader.getDouble(DAILY_TESTING_PROB);
+	config.detection_window = reader.getDouble(DETECTION_WINDOW);
+
+	config.prep_daily_stop_prob = reader.getDouble(PREP_DAILY_STOP_PROB);
+	config.prep_use_prop = reader.getDouble(PREP_USE_PROP);
+
+	config.partial_art_adher_window_length = reader.getDouble(PARTIAL_ART_ADHER_WINDOW_LENGTH);
+	config.prop_always_adherent = reader.getDouble(PROP_ALWAYS_ADHERENT);
+	config.prop_never_adherent = reader.getDouble(PROP_NEVER_ADHERENT);
+	config.prop_partial_pos_adherent = reader.getDouble(PROP_PARTIAL_POS_ADHERENT);
+	config.prop_partial_neg_adherent = reader.getDouble(PROP_PARTIAL_NEG_ADHERENT);
+	config.always_adherent_prob = reader.getDouble(ALWAYS_ADHERENT_PROB);
+	config.never_adherent_prob = reader.getDouble(NEVER_ADHERENT_PROB);
+	config.partial_pos_adherent_prob = reader.getDouble(PARTIAL_POS_ADHERENT_PROB);
+	config.partial_neg_adherent_prob = reader.getDouble(PARTIAL_NEG_ADHERENT_PROB);
+
+	reader.check();
+	return config;
+}
+
+void ModelConfig::initialize(const Parameters& params) {
+	ModelConfig config = create(params);
+	if (instance_ != 0) {
+		delete instance_;
+	}
+	instance_ = new ModelConfig(config);
+}
+
+const ModelConfig& ModelConfig::instance() {
+	if (instance_ == 0)
+		throw std::domain_error("ModelConfig must be initialized before instance() is called");
+
+	return *instance_;
+}
+
+} /* namespace TransModel */
@@ -0,0 +1,79 @@
+/*
+ * ModelConfig.h
+ *
+ *  Created on: May 15, 2017
+ *      Author: nick
+ */
+
+#ifndef SRC_MODELCONFIG_H_
+#define SRC_MODELCONFIG_H_
+
+#include "Parameters.h"
+
+namespace TransModel {
+
+/**
+ * Typed, immutable copy of the model parameters that are read while
+ * the model runs. This is filled once from the Parameters after the R
+ * parameters have been added to them, so that the per tick and per person code
+ * doesn't look up and parse the string properties each time they are used.
+ */
+struct ModelConfig {
+
+	double stop_at;
+	int size_of_timestep;
+	bool count_overlaps;
+
+	// entries and exits
+	float min_age;
+	int max_age;
+	double daily_entry_rate;
+	double init_hiv_prev_entries;
+	double external_infection_rate_min, external_infection_rate_max;
+
+	// sex roles
+	double pr_insertive_main, pr_receptive_main;
+	double pr_insertive_casual, pr_receptive_casual;
+
+	// testing
+	double daily_testing_prob;
+	double detection_window;
+
+	// PrEP
+	double prep_daily_stop_prob;
+	double prep_use_prop;
+
+	// ART adherence
+	double partial_art_adher_window_length;
+	double prop_always_adherent, prop_never_adherent;
+	double prop_partial_pos_adherent, prop_partial_neg_adherent;
+	double always_adherent_prob, never_adherent_prob;
+	double partial_pos_adherent_prob, partial_neg_adherent_prob;
+
+	/**
+	 * Creates a ModelConfig from the specified parameters. All the missing
+	 * parameters and those whose values are not of the expected type are
+	 * reported together in the message of the invalid_argument that is thrown.
+	 */
+	static ModelConfig create(const Parameters& params);
+
+	/**
+	 * Initializes the ModelConfig singleton from the specified parameters.
+	 *
+	 * @throws invalid_argument if any parameters are missing or mistyped.
+	 */
+	static void initialize(const Parameters& params);
+
+	/**
+	 * Gets the singleton instance. If it has not been initialized, an
+	 * exception is thrown.
+	 */
+	static const ModelConfig& instance();
+
+private:
+	static ModelConfig* instance_;
+};
+
+} /* namespace TransModel */
+
+#endif /* SRC_MODELCONFIG_H_ */
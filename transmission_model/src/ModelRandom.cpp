@@ -0,0 +1,97 @@
+/*
+ * ModelRandom.cpp
+ *
+ *  Created on: May 17, 2017
+ *      Author: nick
+ */
+
+#include <cmath>
+#include <stdexcept>
+
+#include "boost/random/binomial_distribution.hpp"
+#include "boost/random/poisson_distribution.hpp"
+#include "boost/random/uniform_int_distribution.hpp"
+
+#include "ModelRandom.h"
+
+namespace TransModel {
+
+Xoshiro256::Xoshiro256(uint64_t seed) {
+	// splitmix64
+	uint64_t x = seed;
+	for (int i = 0; i < 4; ++i) {
+		x += 0x9E3779B97F4A7C15ULL;
+		uint64_t z = x;
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		s[i] = z ^ (z >> 31);
+	}
+}
+
+ModelRandom* ModelRandom::instance_ = 0;
+
+ModelRandom::ModelRandom(uint64_t seed) :
+		engine_(seed), buffer(BUFFER_SIZE), next_idx(BUFFER_SIZE) {
+}
+
+ModelRandom::~ModelRandom() {
+}
+
+void ModelRandom::initialize(uint64_t seed) {
+	if (instance_ != 0) {
+		delete instance_;
+	}
+	instance_ = new ModelRandom(seed);
+}
+
+ModelRandom& ModelRandom::instance() {
+	if (instance_ == 0)
+		throw std::domain_error("ModelRandom must be initialized before instance() is called");
+
+	return *instance_;
+}
+
+void ModelRandom::refill() {
+	for (size_t i = 0; i < BUFFER_SIZE; ++i) {
+		// top 53 bits as a double in [0, 1)
+		buffer[i] = (engine_() >> 11) * (1.0 / 9007199254740992.0);
+	}
+	next_idx = 0;
+}
+
+long ModelRandom::binomial(long n, double p) {
+	if (n <= 0 || p <= 0) {
+		return 0;
+	}
+	if (p >= 1) {
+		return n;
+	}
+	boost::random::binomial_distribution<long> dist(n, p);
+	return dist(engine_);
+}
+
+long ModelRandom::poisson(double lambda) {
+	if (lambda <= 0) {
+		return 0;
+	}
+	boost::random::poisson_distribution<long> dist(lambda);
+	return dist(engine_);
+}
+
+long ModelRandom::geometric(double p) {
+	if (p >= 1) {
+		return 0;
+	}
+	if (p <= 0) {
+		return std::numeric_limits<long>::max();
+	}
+	double val = std::floor(std::log1p(-uniform()) / std::log1p(-p));
+	return val >= (double) std::numeric_limits<long>::max() ? std::numeric_limits<long>::max() : (long) val;
+}
+
+size_t ModelRandom::uniformInt(size_t min, size_t max) {
+	boost::random::uniform_int_distribution<size_t> dist(min, max);
+	return dist(engine_);
+}
+
+} /* namespace TransModel */
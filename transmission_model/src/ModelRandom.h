@@ -0,0 +1,147 @@
+/*
+ * ModelRandom.h
+ *
+ *  Created on: May 17, 2017
+ *      Author: nick
+ */
+
+#ifndef SRC_MODELRANDOM_H_
+#define SRC_MODELRANDOM_H_
+
+#include <cstdint>
+#include <vector>
+#include <limits>
+
+namespace TransModel {
+
+/**
+ * xoshiro256++ generator. This satisfies the requirements of a
+ * uniform random number generator, so it can be used with the boost
+ * and std distributions.
+ */
+class Xoshiro256 {
+
+private:
+	uint64_t s[4];
+
+	static uint64_t rotl(uint64_t x, int k) {
+		return (x << k) | (x >> (64 - k));
+	}
+
+public:
+	typedef uint64_t result_type;
+
+	/**
+	 * Seeds the state with splitmix64 applied to the seed, as recommended
+	 * by the generator's authors.
+	 */
+	explicit Xoshiro256(uint64_t seed);
+
+	static constexpr result_type min() {
+		return 0;
+	}
+
+	static constexpr result_type max() {
+		return std::numeric_limits<uint64_t>::max();
+	}
+
+	result_type operator()() {
+		const uint64_t result = rotl(s[0] + s[3], 23) + s[0];
+		const uint64_t t = s[1] << 17;
+		s[2] ^= s[0];
+		s[3] ^= s[1];
+		s[1] ^= s[2];
+		s[0] ^= s[3];
+		s[2] ^= t;
+		s[3] = rotl(s[3], 45);
+		return result;
+	}
+};
+
+/**
+ * The model's random number stream. Uniform draws are taken from a buffer that
+ * is refilled in bulk from a Xoshiro256 generator, so a draw is an inlined
+ * load rather than a virtual call through repast's generators.
+ *
+ * The singleton is seeded from the repast random seed (global.random.seed),
+ * which is also the seed passed to R's set.seed, so a run is reproducible
+ * from that seed alone.
+ */
+class ModelRandom {
+
+private:
+	static const size_t BUFFER_SIZE = 1024;
+	static ModelRandom* instance_;
+
+	Xoshiro256 engine_;
+	std::vector<double> buffer;
+	size_t next_idx;
+
+	void refill();
+
+public:
+	explicit ModelRandom(uint64_t seed);
+	virtual ~ModelRandom();
+
+	/**
+	 * Initializes the singleton with the specified seed.
+	 */
+	static void initialize(uint64_t seed);
+
+	/**
+	 * Gets the singleton instance. If it has not been initialized, an exception
+	 * is thrown.
+	 */
+	static ModelRandom& instance();
+
+	/**
+	 * Gets a uniform double in [0, 1).
+	 */
+	double uniform() {
+		if (next_idx == BUFFER_SIZE) {
+			refill();
+		}
+		return buffer[next_idx++];
+	}
+
+	/**
+	 * Gets whether a trial with success probability p succeeds. As uniform() is
+	 * in [0, 1), a p of 0 never succeeds and a p of 1 always does.
+	 */
+	bool bernoulli(double p) {
+		return uniform() < p;
+	}
+
+	/**
+	 * Gets a draw from Binomial(n, p).
+	 */
+	long binomial(long n, double p);
+
+	/**
+	 * Gets a draw from Poisson(lambda).
+	 */
+	long poisson(double lambda);
+
+	/**
+	 * Gets the number of failures before the first success in trials with success
+	 * probability p, that is a draw from the geometric distribution on {0, 1, ...}.
+	 * If p <= 0, this returns the maximum long value.
+	 */
+	long geometric(double p);
+
+	/**
+	 * Gets a uniform integer in [min, max].
+	 */
+	size_t uniformInt(size_t min, size_t max);
+
+	/**
+	 * Gets the underlying generator, for use with other distributions.
+	 */
+	Xoshiro256& engine() {
+		return engine_;
+	}
+};
+
+} /* namespace TransModel */
+
+#endif /* SRC_MODELRANDOM_H_ */
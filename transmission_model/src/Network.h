@@ -16,6 +16,7 @@
 #include "boost/iterator/transform_iterator.hpp"
 
 #include "Edge.h"
+#include "PoolAllocator.h"
 
 namespace TransModel {
 
@@ -57,6 +58,21 @@ struct EdgeListData {
 
 using EdgeList = std::map<unsigned int, EdgeListData>;
 
+/**
+ * Notified by a Network when edges are added to or removed from it.
+ */
+template<typename V>
+class NetworkListener {
+
+public:
+	virtual ~NetworkListener() {
+	}
+
+	virtual void edgeAdded(const EdgePtr<V>& edge) = 0;
+	virtual void edgeRemoved(const EdgePtr<V>& edge) = 0;
+	virtual void edgesCleared() = 0;
+};
+
 template<typename V>
 class Network {
 
@@ -71,6 +87,7 @@ private:
 	// oel: outgoing edge list, iel: incoming edge list
 	EdgeList oel, iel;
 	std::map<int, unsigned int> edge_counts;
+	std::vector<NetworkListener<V>*> listeners;
 
 	EdgePtr<V> doAddEdge(const std::shared_ptr<V>& source, const std::shared_ptr<V>& target, int type);
 	void removeEdges(unsigned int idx, EdgeList& el, std::vector<EdgePtr<V>>& removed_edges);
@@ -80,6 +97,14 @@ public:
 	Network(bool directed);
 	virtual ~Network();
 
+	/**
+	 * Adds a listener that is notified of edge additions and removals. The
+	 * network does not take ownership of the listener.
+	 */
+	void addListener(NetworkListener<V>* listener) {
+		listeners.push_back(listener);
+	}
+
 	void addVertex(const std::shared_ptr<V>& vertex);
 	bool removeVertex(const std::shared_ptr<V>& vertex);
 	bool removeVertex(unsigned int id);
@@ -140,12 +165,15 @@ public:
 		edges.clear();
 		oel.clear();
 		iel.clear();
+		for (auto listener : listeners) {
+			listener->edgesCleared();
+		}
 	}
 };
 
 template<typename V>
 Network<V>::Network(bool directed) :
-		directed_(directed), edge_idx(0), vertices(), edges(), oel(), iel(), edge_counts() {
+		directed_(directed), edge_idx(0), vertices(), edges(), oel(), iel(), edge_counts(), listeners() {
 }
 
 template<typename V>
@@ -266,7 +294,7 @@ EdgePtr<V> Network<V>::removeEdge(unsigned int v1_idx, unsigned int v2_idx, int
 		EdgePtr<V> edge = edge_iter->second;
 		if (edge->v2()->id() == v2_idx && edge->type() == type) {
 			edges.erase(edge_iter);
-			--edge_counts[edge_iter->second->type()];
+			--edge_counts[type];
 			EdgeListData& data = iter->second;
 			data.edge_idxs.erase(edge_idx);
 			--data.edge_counts[type];
@@ -274,6 +302,9 @@ EdgePtr<V> Network<V>::removeEdge(unsigned int v1_idx, unsigned int v2_idx, int
 			EdgeListData& d2 = iel.at(v2_idx);
 			d2.edge_idxs.erase(edge_idx);
 			--d2.edge_counts[type];
+			for (auto listener : listeners) {
+				listener->edgeRemoved(edge);
+			}
 			return edge;
 		}
 	}
@@ -294,6 +325,9 @@ void Network<V>::removeEdges(unsigned int idx, EdgeList& el, std::vector<EdgePtr
 				throw std::invalid_argument(
 						"Unable to delete edge: edge " + std::to_string(*edge_idx_iter) + " does not exist.");
 			removed_edges.push_back(mel_iter->second);
+			for (auto listener : listeners) {
+				listener->edgeRemoved(mel_iter->second);
+			}
 			--edge_counts[mel_iter->second->type()];
 			--(iter->second.edge_counts[mel_iter->second->type()]);
 			// erase that edge
@@ -350,7 +384,7 @@ VertexIter<V> Network<V>::removeVertex(VertexIter<V> iter) {
 template<typename V>
 EdgePtr<V> Network<V>::doAddEdge(const std::shared_ptr<V>& source, const std::shared_ptr<V>& target, int type) {
 	// assumes sanity checks have already occured
-	EdgePtr<V> edge = std::make_shared<Edge<V>>(edge_idx, source, target, type);
+	EdgePtr<V> edge = std::allocate_shared<Edge<V>>(PoolAllocator<Edge<V>>(), edge_idx, source, target, type);
 	edges.emplace(edge_idx, edge);
 
 	auto out_iter = Network<V>::oel.find(source->id());
@@ -372,6 +406,9 @@ EdgePtr<V> Network<V>::doAddEdge(const std::shared_ptr<V>& source, const std::sh
 	}
 	++edge_idx;
 	++edge_counts[type];
+	for (auto listener : listeners) {
+		listener->edgeAdded(edge);
+	}
 	return edge;
 }
 
@@ -32,19 +32,26 @@ const std::string EVENT_FILE = "event.file";
 const std::string EVENT_FILE_BUFFER_SIZE = "event.file.buffer.size";
 const std::string COUNTS_PER_TIMESTEP_OUTPUT_FILE= "per.tick.counts.output.file";
 const std::string OUTPUT_DIR = "output.directory";
+const std::string OUTPUT_FORMAT = "output.format";
 const std::string PARTNERSHIP_EVENTS_FILE = "partnership.events.file";
 const std::string INFECTION_EVENTS_FILE =  "infection.events.file";
 const std::string BIOMARKER_FILE = "biomarker.log.file";
 const std::string BIOMARKER_LOG_COUNT = "biomarker.number.of.persons.to.log";
+const std::string TRACE_FILE = "trace.file";
+const std::string TRACE_CONTENTS = "trace.contents";
 const std::string DEATH_EVENT_FILE = "death.events.file";
 const std::string TESTING_EVENT_FILE = "testing.events.file";
 const std::string ART_EVENT_FILE = "art.events.file";
 const std::string PREP_EVENT_FILE = "prep.events.file";
 const std::string PERSON_DATA_FILE = "person.data.file";
+const std::string SUMMARY_FILE = "summary.file";
+const std::string SUMMARY_AGGREGATES = "summary.aggregates";
 const std::string NET_SAVE_FILE = "net.save.file";
 const std::string CASUAL_NET_SAVE_FILE = "casual.net.save.file";
 const std::string NET_SAVE_AT = "save.network.at";
 const std::string COUNT_OVERLAPS = "count.overlaps";
+const std::string TRANSMISSION_THREADS = "transmission.threads";
+const std::string SEX_ACTS_SAMPLER = "sex.acts.sampler";
 
 //const std::string PREP_MULT = "prep.mult";
 
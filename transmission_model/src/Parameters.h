@@ -17,20 +17,27 @@ extern const std::string R_FILE;
 extern const std::string MAIN_NETWORK_FILE;
 extern const std::string CASUAL_NETWORK_FILE;
 extern const std::string OUTPUT_DIR;
+extern const std::string OUTPUT_FORMAT;
 extern const std::string COUNTS_PER_TIMESTEP_OUTPUT_FILE;
 extern const std::string PARTNERSHIP_EVENTS_FILE;
 extern const std::string INFECTION_EVENTS_FILE;
 extern const std::string BIOMARKER_FILE;
 extern const std::string BIOMARKER_LOG_COUNT;
+extern const std::string TRACE_FILE;
+extern const std::string TRACE_CONTENTS;
 extern const std::string DEATH_EVENT_FILE;
 extern const std::string TESTING_EVENT_FILE;
 extern const std::string ART_EVENT_FILE;
 extern const std::string PREP_EVENT_FILE;
 extern const std::string PERSON_DATA_FILE;
+extern const std::string SUMMARY_FILE;
+extern const std::string SUMMARY_AGGREGATES;
 extern const std::string NET_SAVE_FILE;
 extern const std::string CASUAL_NET_SAVE_FILE;
 extern const std::string NET_SAVE_AT;
 extern const std::string COUNT_OVERLAPS;
+extern const std::string TRANSMISSION_THREADS;
+extern const std::string SEX_ACTS_SAMPLER;
 
 extern const std::string EVENT_FILE;
 extern const std::string EVENT_FILE_BUFFER_SIZE;
@@ -5,6 +5,9 @@
  *      Author: nick
  */
 
+#include <cmath>
+#include <algorithm>
+
 #include "Person.h"
 #include "Stats.h"
 
@@ -12,10 +15,14 @@ using namespace Rcpp;
 
 namespace TransModel {
 
+double Person::clock_ = 0;
+float Person::years_per_tick_ = 1 / 365.0f;
+
 Person::Person(int id, float age, bool circum_status, int steady_role, int casual_role, Diagnoser<GeometricDistribution>& diagnoser) :
-		id_(id), steady_role_(steady_role), casual_role_(casual_role), age_(age), circum_status_(circum_status),
-		infection_parameters_(), infectivity_(0), prep_(PrepStatus::OFF, -1, -1), dead_(false), diagnosed_(false), testable_(false),
-		diagnoser_(diagnoser), adherence_{0, AdherenceCategory::NA} {
+		entry_clock_(clock_), infection_clock_(0), art_clock_(0), id_(id), steady_role_(steady_role), casual_role_(
+				casual_role), slot_ { 0, 0 }, age_(age), infectivity_(0), circum_status_(circum_status), dead_(false), diagnosed_(
+				false), testable_(false), trace_(TRACE_NONE), infection_parameters_(), diagnoser_(diagnoser), prep_(PrepStatus::OFF, -1,
+				-1), adherence_ { 0, AdherenceCategory::NA }, art_init_() {
 }
 
 //Person::Person(int id, std::shared_ptr<RNetwork> network, double timeOfBirth) : net(network), id_(id) {
@@ -31,13 +38,39 @@ void Person::infect(float duration_of_infection, float time) {
 	infection_parameters_.dur_inf_by_age = duration_of_infection;
 	infection_parameters_.infection_status = true;
 	infection_parameters_.time_since_infection = 0;
-	infection_parameters_.age_at_infection = age_;
+	infection_clock_ = clock_;
+	infection_parameters_.age_at_infection = age();
 	infection_parameters_.time_of_infection = time;
 }
 
 
 void Person::setAge(float age) {
 	age_ = age;
+	entry_clock_ = clock_;
+}
+
+// earliest clock from entry_clock at which older(ageAt(clock)) is true where older
+// is monotonic in age
+template<typename F>
+double first_clock(const Person& person, double entry_clock, float entry_age, float years_per_tick, float age, F older) {
+	// first guess and then correct for any float rounding
+	// so that this is consistent with ageAt
+	double clock = entry_clock + std::max(0.0, std::floor((double) (age - entry_age) / years_per_tick));
+	while (clock > entry_clock && older(person.ageAt(clock - 1))) {
+		--clock;
+	}
+	while (!older(person.ageAt(clock))) {
+		++clock;
+	}
+	return clock;
+}
+
+double Person::ageOutClock(int max_age) const {
+	return first_clock(*this, entry_clock_, age_, years_per_tick_, max_age, [max_age](float a) {return a > max_age;});
+}
+
+double Person::clockAtAge(float age) const {
+	return first_clock(*this, entry_clock_, age_, years_per_tick_, age, [age](float a) {return a >= age;});
 }
 
 void Person::setCD4Count(float cd4_count) {
@@ -63,9 +96,18 @@ void Person::goOffART() {
 void Person::goOnART(float time_stamp) {
 	infection_parameters_.art_status = true;
 	infection_parameters_.time_since_art_init = 0;
-	infection_parameters_.time_of_art_init = time_stamp;
-	infection_parameters_.cd4_at_art_init = infection_parameters_.cd4_count;
-	infection_parameters_.vl_at_art_init = infection_parameters_.viral_load;
+	art_clock_ = clock_;
+	if (!art_init_) {
+		art_init_.reset(new ARTInitParameters());
+	}
+	art_init_->time_of_art_init = time_stamp;
+	art_init_->cd4_at_art_init = infection_parameters_.cd4_count;
+	art_init_->vl_at_art_init = infection_parameters_.viral_load;
+}
+
+const ARTInitParameters& Person::artInitParameters() const {
+	static const ARTInitParameters never_on_art;
+	return art_init_ ? *art_init_ : never_on_art;
 }
 
 
@@ -77,24 +119,13 @@ void Person::goOnPrep(double start_time, double stop_time) {
 	prep_.on(start_time, stop_time);
 }
 
-void Person::step(float size_of_timestep) {
-	age_ += size_of_timestep / 365;
-	if (infection_parameters_.infection_status) {
-		++infection_parameters_.time_since_infection;
-	}
-
-	if (infection_parameters_.art_status) {
-		++infection_parameters_.time_since_art_init;
-	}
-}
-
 bool Person::deadOfAge(int max_age) {
-	return age_ > max_age;
+	return age() > max_age;
 }
 
 bool Person::deadOfInfection() {
 	return infection_parameters_.infection_status && !infection_parameters_.art_status &&
-			infection_parameters_.time_since_infection >= infection_parameters_.dur_inf_by_age;
+			timeSinceInfection() >= infection_parameters_.dur_inf_by_age;
 }
 
 bool Person::diagnose(double tick) {
@@ -102,10 +133,13 @@ bool Person::diagnose(double tick) {
 	diagnosed_ = result == Result::POSITIVE;
 	if (result != Result::NO_TEST) {
 		Stats::instance()->recordTestingEvent(tick, id_, diagnosed_);
+		Stats::instance()->traceEvent(tick, *this, TRACE_TESTING, TraceEvent::TESTED, -1, diagnosed_);
 		if (diagnosed_ && prep_.status() == PrepStatus::ON) {
 			prep_.offInfected();
-			Stats::instance()->recordPREPEvent(tick, id(), static_cast<int>(PrepStatus::OFF_INFECTED));
-			Stats::instance()->personDataRecorder().recordPREPStop(id(), tick, PrepStatus::OFF_INFECTED);
+			Stats::instance()->recordPREPEvent(tick, id(), PrepStatus::OFF_INFECTED);
+			Stats::instance()->traceEvent(tick, *this, TRACE_TREATMENT, TraceEvent::PREP_STOPPED, -1,
+					static_cast<int>(PrepStatus::OFF_INFECTED));
+			Stats::instance()->personDataRecorder().recordPREPStop(slot(), tick, PrepStatus::OFF_INFECTED);
 		}
 	}
 	return diagnosed_;
@@ -8,12 +8,16 @@
 #ifndef SRC_PERSON_H_
 #define SRC_PERSON_H_
 
+#include <memory>
+
 #include "Rcpp.h"
 #include "DiseaseParameters.h"
 #include "Diagnoser.h"
 #include "GeometricDistribution.h"
 #include "AdherenceCategory.h"
 #include "PrepParameters.h"
+#include "SlotAllocator.h"
+#include "Trace.h"
 
 namespace TransModel {
 
@@ -24,29 +28,63 @@ class Person {
 private:
 	friend PersonCreator;
 
+	static double clock_;
+	static float years_per_tick_;
+
+	// fields read every tick first
+	double entry_clock_, infection_clock_, art_clock_;
 	int id_, steady_role_, casual_role_;
+	SlotRef slot_;
+	// age at entry_clock_, the age at other times is derived from that
 	float age_;
-	bool circum_status_;
-	InfectionParameters infection_parameters_;
 	float infectivity_;
-	PrepParameters prep_;
-	bool dead_, diagnosed_, testable_;
+	bool circum_status_ :1, dead_ :1, diagnosed_ :1, testable_ :1;
+	// TraceContent flags
+	unsigned char trace_;
+	InfectionParameters infection_parameters_;
 	Diagnoser<GeometricDistribution> diagnoser_;
+	PrepParameters prep_;
 	AdherenceData adherence_;
+	// only allocated once this person goes on ART
+	std::unique_ptr<ARTInitParameters> art_init_;
 
 public:
 	Person(int id, float age, bool circum_status, int steady_role, int casual_role, Diagnoser<GeometricDistribution>& diagnoser);
 
-	virtual ~Person();
+	~Person();
 
 	/**
-	 * Gets the id of this person.
+	 * Gets the id of this person. Ids are never reused and so identify
+	 * the person in the output.
 	 */
 
 	int id() const {
 		return id_;
 	}
 
+	/**
+	 * Gets the dense slot of this person. A slot is reused once its person
+	 * has died and the generation in the reference distinguishes the persons
+	 * that have held it.
+	 */
+	const SlotRef& slot() const {
+		return slot_;
+	}
+
+	/**
+	 * Sets what is traced for this person, as a combination of TraceContent flags.
+	 */
+	void setTrace(unsigned char contents) {
+		trace_ = contents;
+	}
+
+	/**
+	 * Gets whether any of the specified TraceContent is traced for this person.
+	 */
+	bool isTraced(unsigned char content = TRACE_ALL) const {
+		return (trace_ & content) != 0;
+	}
+
 	int steady_role() const {
 		return steady_role_;
 	}
@@ -55,13 +93,55 @@ public:
 		return casual_role_;
 	}
 
+	/**
+	 * Sets the age clock. The age and the time since infection and ART initiation of
+	 * all persons are derived from this. The clock is the number of completed
+	 * time steps, such that a person who enters at clock c has been aged by one time step
+	 * once the clock has been advanced to c + 1. The Model sets it once at
+	 * initialization and then advances it once per time step, when the
+	 * persons are aged in Model::updateVitals.
+	 */
+	static void setClock(double clock) {
+		clock_ = clock;
+	}
+
+	static double clock() {
+		return clock_;
+	}
+
+	/**
+	 * Sets the amount of years a person ages per time step.
+	 */
+	static void setYearsPerTick(float years) {
+		years_per_tick_ = years;
+	}
+
 	/**
 	 * Gets the age of this Person.
 	 */
 	float age() const {
-		return age_;
+		return ageAt(clock_);
 	}
 
+	/**
+	 * Gets the age of this Person at the specified clock.
+	 */
+	float ageAt(double clock) const {
+		return age_ + (float) (clock - entry_clock_) * years_per_tick_;
+	}
+
+	/**
+	 * Gets the earliest clock at which this Person's age
+	 * will be greater than max_age.
+	 */
+	double ageOutClock(int max_age) const;
+
+	/**
+	 * Gets the earliest clock, not before the clock at which this Person
+	 * entered, at which this Person's age will be greater than or equal to age.
+	 */
+	double clockAtAge(float age) const;
+
 	bool isOnPrep() const {
 		return prep_.status() == PrepStatus::ON;
 	}
@@ -74,6 +154,12 @@ public:
 		return infection_parameters_;
 	}
 
+	/**
+	 * Gets the time, CD4 count and viral load at ART initiation. These are NaN
+	 * if this Person has never been on ART.
+	 */
+	const ARTInitParameters& artInitParameters() const;
+
 	bool isCircumcised() const {
 		return circum_status_;
 	}
@@ -91,10 +177,25 @@ public:
 	}
 
 	float timeSinceInfection() const {
-		return infection_parameters_.time_since_infection;
+		return (float) (clock_ - infection_clock_);
+	}
+
+	float timeSinceARTInit() const {
+		return (float) (clock_ - art_clock_);
 	}
 
-	const Diagnoser<GeometricDistribution> diagnoser() const {
+	/**
+	 * Updates the time since infection and the time since ART initiation
+	 * in this Person's infection parameters to their values at the specified clock.
+	 */
+	void updateTimeSince(double clock) {
+		infection_parameters_.time_since_infection = (float) (clock - infection_clock_);
+		if (infection_parameters_.art_status) {
+			infection_parameters_.time_since_art_init = (float) (clock - art_clock_);
+		}
+	}
+
+	const Diagnoser<GeometricDistribution>& diagnoser() const {
 		return diagnoser_;
 	}
 
@@ -102,7 +203,7 @@ public:
 		adherence_ = data;
 	}
 
-	const AdherenceData adherence() const {
+	const AdherenceData& adherence() const {
 		return adherence_;
 	}
 
@@ -143,11 +244,6 @@ public:
 	 */
 	void infect(float duration_of_infection, float time);
 
-	/**
-	 * Updates age, etc. of person., to be called each iteration of the model.
-	 */
-	void step(float size_of_timestep);
-
 	/**
 	 * Checks if person is dead of old age. This doesn't kill
 	 * the person, it just checks.
@@ -176,7 +272,7 @@ public:
 		return testable_;
 	}
 
-	const PrepParameters prepParameters() const {
+	const PrepParameters& prepParameters() const {
 		return prep_;
 	}
 
@@ -184,6 +280,10 @@ public:
 
 	double timeUntilNextTest(double tick) const;
 
+	double nextTestAt() const {
+		return diagnoser_.nextTestAt();
+	}
+
 };
 
 } /* namespace TransModel */
@@ -5,11 +5,16 @@
  *      Author: nick
  */
 
+#include <cassert>
+
 #include "Parameters.h"
+#include "ModelConfig.h"
 
 #include "PersonCreator.h"
 #include "Diagnoser.h"
 #include "art_functions.h"
+#include "ModelRandom.h"
+#include "PoolAllocator.h"
 
 
 using namespace Rcpp;
@@ -17,19 +22,27 @@ using namespace Rcpp;
 namespace TransModel {
 
 PersonCreator::PersonCreator(std::shared_ptr<TransmissionRunner>& trans_runner, double daily_testing_prob, double detection_window) :
-		id(0), trans_runner_(trans_runner), dist{std::make_shared<GeometricDistribution>(daily_testing_prob, 1)}, detection_window_(detection_window) {
+		id(0), trans_runner_(trans_runner), dist{std::make_shared<GeometricDistribution>(daily_testing_prob, 1)}, detection_window_(detection_window), slots_(), persons() {
 }
 
 PersonCreator::~PersonCreator() {
+	// the Diagnosers of the created persons point to dist, so
+	// no created person may outlive this PersonCreator
+	persons.forEach([](const PersonPtr& person) {assert(person.use_count() == 1);});
+}
+
+void PersonCreator::release(const PersonPtr& person) {
+	persons.erase(person->slot());
+	slots_.release(person->slot());
 }
 
 int calculate_role(int network_type) {
-	double insertive = network_type == STEADY_NETWORK_TYPE ? Parameters::instance()->getDoubleParameter(PR_INSERTIVE_MAIN) :
-			Parameters::instance()->getDoubleParameter(PR_INSERTIVE_CASUAL);
-	double receptive = (network_type == STEADY_NETWORK_TYPE ? Parameters::instance()->getDoubleParameter(PR_RECEPTIVE_MAIN) :
-			Parameters::instance()->getDoubleParameter(PR_RECEPTIVE_CASUAL)) + insertive;
+	const ModelConfig& config = ModelConfig::instance();
+	double insertive = network_type == STEADY_NETWORK_TYPE ? config.pr_insertive_main : config.pr_insertive_casual;
+	double receptive = (network_type == STEADY_NETWORK_TYPE ? config.pr_receptive_main : config.pr_receptive_casual)
+			+ insertive;
 
-	double draw = repast::Random::instance()->nextDouble();
+	double draw = ModelRandom::instance().uniform();
 	if (draw <= insertive) {
 		return INSERTIVE;
 	} else if (draw <= receptive) {
@@ -41,10 +54,12 @@ int calculate_role(int network_type) {
 
 PersonPtr PersonCreator::operator()(double tick, float age) {
 	int status = (int) repast::Random::instance()->getGenerator(CIRCUM_STATUS_BINOMIAL)->next();
-	Diagnoser<GeometricDistribution> diagnoser(tick, detection_window_, dist);
-	PersonPtr person = std::make_shared<Person>(id++, age, status == 1, calculate_role(STEADY_NETWORK_TYPE), calculate_role(CASUAL_NETWORK_TYPE),
+	Diagnoser<GeometricDistribution> diagnoser(tick, detection_window_, dist.get());
+	PersonPtr person = std::allocate_shared<Person>(PoolAllocator<Person>(), id++, age, status == 1, calculate_role(STEADY_NETWORK_TYPE), calculate_role(CASUAL_NETWORK_TYPE),
 			diagnoser);
 	person->testable_= ((int) repast::Random::instance()->getGenerator(NON_TESTERS_BINOMIAL)->next()) == 0;
+	person->slot_ = slots_.allocate();
+	persons.put(person->slot_, person);
 
 	return person;
 }
@@ -61,9 +76,11 @@ PersonPtr PersonCreator::operator()(Rcpp::List& val, double tick) {
 	}
 
 	float next_test_at = tick + as<double>(val["time.until.next.test"]);
-	// float detection_window, float next_test_at, unsigned int test_count, std::shared_ptr<G> generator
-	Diagnoser<GeometricDistribution> diagnoser(detection_window_, next_test_at, as<unsigned int>(val["number.of.tests"]), dist);
-	PersonPtr person = std::make_shared<Person>(id++, age, circum_status, role_main, role_casual, diagnoser);
+	// float detection_window, float next_test_at, unsigned int test_count, G* generator
+	Diagnoser<GeometricDistribution> diagnoser(detection_window_, next_test_at, as<unsigned int>(val["number.of.tests"]), dist.get());
+	PersonPtr person = std::allocate_shared<Person>(PoolAllocator<Person>(), id++, age, circum_status, role_main, role_casual, diagnoser);
+	person->slot_ = slots_.allocate();
+	persons.put(person->slot_, person);
 	person->diagnosed_ = as<bool>(val["diagnosed"]);
 	person->testable_ = !(as<bool>(val["non.testers"]));
 	person->infection_parameters_.cd4_count = as<float>(val["cd4.count.today"]);
@@ -72,6 +89,7 @@ PersonPtr PersonCreator::operator()(Rcpp::List& val, double tick) {
 	if (infected) {
 		person->infection_parameters_.infection_status = true;
 		person->infection_parameters_.time_since_infection = as<float>(val["time.since.infection"]);
+		person->infection_clock_ = Person::clock() - person->infection_parameters_.time_since_infection;
 		person->infection_parameters_.time_of_infection = as<float>(val["time.of.infection"]);
 		person->infection_parameters_.age_at_infection = as<float>(val["age.at.infection"]);
 		person->infection_parameters_.dur_inf_by_age =
@@ -79,10 +97,12 @@ PersonPtr PersonCreator::operator()(Rcpp::List& val, double tick) {
 		person->infection_parameters_.art_status = as<bool>(val["art.status"]);
 		if (person->infection_parameters_.art_status) {
 			person->infection_parameters_.time_since_art_init = as<float>(val["time.since.art.initiation"]);
-			person->infection_parameters_.time_of_art_init = as<float>(val["time.of.art.initiation"]);
+			person->art_clock_ = Person::clock() - person->infection_parameters_.time_since_art_init;
 			person->infection_parameters_.vl_art_traj_slope = as<float>(val["vl.art.traj.slope"]);
-			person->infection_parameters_.cd4_at_art_init = as<float>(val["cd4.at.art.initiation"]);
-			person->infection_parameters_.vl_at_art_init = as<float>(val["vl.at.art.initiation"]);
+			person->art_init_.reset(new ARTInitParameters());
+			person->art_init_->time_of_art_init = as<float>(val["time.of.art.initiation"]);
+			person->art_init_->cd4_at_art_init = as<float>(val["cd4.at.art.initiation"]);
+			person->art_init_->vl_at_art_init = as<float>(val["vl.at.art.initiation"]);
 
 			if (val.containsElementNamed("adherence.category")) {
 				initialize_adherence(person, tick, static_cast<AdherenceCategory>(as<int>(val["adherence.category"])));
@@ -16,6 +16,7 @@
 #include "TransmissionRunner.h"
 #include "common.h"
 #include "GeometricDistribution.h"
+#include "SlotAllocator.h"
 
 namespace TransModel {
 
@@ -25,8 +26,12 @@ class PersonCreator {
 private:
 	int id;
 	std::shared_ptr<TransmissionRunner> trans_runner_;
+	// shared by the Diagnosers of all the created persons
 	std::shared_ptr<GeometricDistribution> dist;
 	double detection_window_;
+	SlotAllocator slots_;
+	// the created persons by slot, until they are released
+	SlotMap<PersonPtr> persons;
 
 public:
 	PersonCreator(std::shared_ptr<TransmissionRunner>& trans_runner, double daily_testing_prob, double detection_window);
@@ -34,6 +39,24 @@ public:
 
 	PersonPtr operator()(Rcpp::List& val, double tick);
 	PersonPtr operator()(double tick, float age);
+
+	/**
+	 * Releases the slot of the specified dead person for reuse.
+	 */
+	void release(const PersonPtr& person);
+
+	/**
+	 * Gets the person currently holding the referenced slot, or an empty pointer
+	 * if that person has since been released.
+	 */
+	PersonPtr find(const SlotRef& ref) const {
+		const PersonPtr* person = persons.find(ref);
+		return person ? *person : PersonPtr();
+	}
+
+	const SlotAllocator& slots() const {
+		return slots_;
+	}
 };
 
 } /* namespace TransModel */
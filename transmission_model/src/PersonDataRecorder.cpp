@@ -5,6 +5,10 @@
  *      Author: nick
  */
 
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
 #include "PersonDataRecorder.h"
 
 namespace TransModel {
@@ -14,10 +18,18 @@ const std::string PersonData::header("id,time_of_entry,time_of_death,infection_s
 		"time_of_prep_cessation,number_of_tests,time_since_last_test,diagnosis_status,init_art_lag,adherence_category,"
 		"adhered_interval_count,non_adhered_interval_count,infection_source");
 
+PersonData::PersonData() :
+		id_(-1), birth_ts(-1), death_ts(-1), infection_ts(-1), art_init_ts(-1), art_stop_ts(-1), prep_init_ts(-1), prep_stop_ts(
+				-1), prep_status(PrepStatus::OFF), infection_status(false), art_status(false), diagnosed(false), number_of_tests(
+				0), time_since_last_test(-1), adherence_category(static_cast<int>(AdherenceCategory::NA)), adhered_interval_count(
+				0), non_adhered_interval_count(0), init_art_lag(-1), infection_source(
+				static_cast<unsigned int>(InfectionSource::NONE)) {
+}
+
 PersonData::PersonData(PersonPtr p, double time_of_birth) :
 		id_(p->id()), birth_ts(time_of_birth), death_ts(-1), infection_ts(
 				p->isInfected() ? p->infectionParameters().time_of_infection : -1), art_init_ts(
-				p->isOnART() ? p->infectionParameters().time_of_art_init : -1), art_stop_ts(-1), prep_init_ts(
+				p->isOnART() ? p->artInitParameters().time_of_art_init : -1), art_stop_ts(-1), prep_init_ts(
 				p->isOnPrep() ? -1 : -1), prep_stop_ts(-1), prep_status(p->prepStatus()), infection_status(
 				p->isInfected()), art_status(p->isOnART()), diagnosed(p->isDiagnosed()), number_of_tests(
 				p->diagnoser().testCount()), time_since_last_test { -1 }, adherence_category(static_cast<int>(AdherenceCategory::NA)),
@@ -32,48 +44,101 @@ void PersonData::writeTo(FileOutput& out) {
 }
 
 
-PersonDataRecorder::PersonDataRecorder(const std::string& fname, unsigned int buffer) : data{},
-		writer{fname, PersonData::header, buffer} {}
+PersonDataRecorder::PersonDataRecorder(const std::string& fname, unsigned int buffer, std::shared_ptr<AsyncWriter> io,
+		OutputLevel level) : data{}, writer{nullptr} {
+	if (level == OutputLevel::FULL) {
+		writer = std::make_shared<StatsWriter<PersonData>>(fname, PersonData::header, buffer, io);
+	} else if (level != OutputLevel::OFF) {
+		throw std::invalid_argument("Person data output level must be off or full");
+	}
+}
 
 PersonDataRecorder::~PersonDataRecorder() {
-	for (auto& item : data) {
-		writer.addOutput(item.second);
+	close();
+}
+
+void PersonDataRecorder::close() {
+	if (!writer) {
+		return;
+	}
+	// written in id order as they were when kept in a map by id
+	std::vector<PersonData*> alive;
+	alive.reserve(data.size());
+	data.forEach([&alive](PersonData& pd) {alive.push_back(&pd);});
+	std::sort(alive.begin(), alive.end(), [](const PersonData* pd1, const PersonData* pd2) {return pd1->id_ < pd2->id_;});
+	for (auto pd : alive) {
+		writer->addOutput(*pd);
+	}
+	data.clear();
+	writer->flush();
+}
+
+PersonData& PersonDataRecorder::record(const SlotRef& slot) {
+	PersonData* pd = data.find(slot);
+	if (pd == nullptr) {
+		throw std::out_of_range("No person data recorded for the person's slot");
 	}
+	return *pd;
 }
 
 void PersonDataRecorder::recordInitialARTLag(PersonPtr& p, double lag) {
-	data.at(p->id()).init_art_lag = lag;
+	if (!writer) {
+		return;
+	}
+	record(p->slot()).init_art_lag = lag;
 }
 
 void PersonDataRecorder::recordARTStart(PersonPtr& p, double ts) {
-	data.at(p->id()).art_status = true;
-	data.at(p->id()).art_init_ts = ts;
+	if (!writer) {
+		return;
+	}
+	PersonData& pd = record(p->slot());
+	pd.art_status = true;
+	pd.art_init_ts = ts;
 }
 
 void PersonDataRecorder::recordARTStop(PersonPtr& p, double ts) {
-	data.at(p->id()).art_status = false;
-	data.at(p->id()).art_stop_ts = ts;
+	if (!writer) {
+		return;
+	}
+	PersonData& pd = record(p->slot());
+	pd.art_status = false;
+	pd.art_stop_ts = ts;
 }
 
-void PersonDataRecorder::recordPREPStart(int id, double ts) {
-	data.at(id).prep_status = PrepStatus::ON;
-	data.at(id).prep_init_ts = ts;
+void PersonDataRecorder::recordPREPStart(const SlotRef& slot, double ts) {
+	if (!writer) {
+		return;
+	}
+	PersonData& pd = record(slot);
+	pd.prep_status = PrepStatus::ON;
+	pd.prep_init_ts = ts;
 }
 
-void PersonDataRecorder::recordPREPStop(int id, double ts, PrepStatus status) {
-	data.at(id).prep_status = status;
-	data.at(id).prep_stop_ts = ts;
+void PersonDataRecorder::recordPREPStop(const SlotRef& slot, double ts, PrepStatus status) {
+	if (!writer) {
+		return;
+	}
+	PersonData& pd = record(slot);
+	pd.prep_status = status;
+	pd.prep_stop_ts = ts;
 }
 
 void PersonDataRecorder::recordInfection(PersonPtr& p, double ts, InfectionSource source) {
-	PersonData& pd = data.at(p->id());
+	if (!writer) {
+		return;
+	}
+	PersonData& pd = record(p->slot());
 	pd.infection_status = true;
 	pd.infection_ts = ts;
 	pd.infection_source = static_cast<unsigned int>(source);
 }
 
 void PersonDataRecorder::finalize(const PersonPtr& p, double ts) {
-	PersonData& pd = data.at(p->id());
+	if (!writer) {
+		return;
+	}
+	PersonData& pd = record(p->slot());
 	pd.number_of_tests = p->diagnoser().testCount();
 	double lt =  p->diagnoser().lastTestAt();
 	pd.time_since_last_test = lt == -1.0 ? -1.0 : ts - lt;
@@ -83,26 +148,35 @@ void PersonDataRecorder::finalize(const PersonPtr& p, double ts) {
 }
 
 void PersonDataRecorder::recordDeath(PersonPtr& p, double ts) {
-	PersonData& pd = data.at(p->id());
+	if (!writer) {
+		return;
+	}
+	PersonData& pd = record(p->slot());
 	pd.death_ts = ts;
 	finalize(p, ts);
-	writer.addOutput(pd);
-	data.erase(p->id());
+	writer->addOutput(pd);
+	data.erase(p->slot());
 }
 
 void PersonDataRecorder::initRecord(PersonPtr& person, double time_of_entry) {
-	PersonData pd(person, time_of_entry);
-	data.emplace(person->id(), pd);
+	if (!writer) {
+		return;
+	}
+	data.put(person->slot(), PersonData(person, time_of_entry));
 }
 
 void PersonDataRecorder::incrementNonAdheredIntervals(PersonPtr& p) {
-	PersonData& pd = data.at(p->id());
-	++pd.non_adhered_interval_count;
+	if (!writer) {
+		return;
+	}
+	++record(p->slot()).non_adhered_interval_count;
 }
 
 void PersonDataRecorder::incrementAdheredIntervals(PersonPtr& p) {
-	PersonData& pd = data.at(p->id());
-	++pd.adhered_interval_count;
+	if (!writer) {
+		return;
+	}
+	++record(p->slot()).adhered_interval_count;
 }
 
 } /* namespace TransModel */
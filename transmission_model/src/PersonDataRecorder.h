@@ -8,10 +8,10 @@
 #ifndef SRC_PERSONDATARECORDER_H_
 #define SRC_PERSONDATARECORDER_H_
 
-#include <map>
-
 #include "StatsWriter.h"
+#include "EventStream.h"
 #include "Person.h"
+#include "SlotAllocator.h"
 #include "common.h"
 
 namespace TransModel {
@@ -34,28 +34,44 @@ struct PersonData {
 	double init_art_lag;
 	unsigned int infection_source;
 
+	PersonData();
 	PersonData(PersonPtr p, double time_of_birth);
 	void writeTo(FileOutput& out);
 
 };
 
+/**
+ * Records the PersonData of each person in the model, writing it when the
+ * person dies or when the recorder is closed. The data is kept by the
+ * person's slot, so the storage of dead persons is reused. If the recorder's
+ * output level is OFF nothing is recorded or written.
+ */
 class PersonDataRecorder {
 
-	std::map<int, PersonData> data;
-	StatsWriter<PersonData> writer;
+	SlotMap<PersonData> data;
+	// null if the output is OFF
+	std::shared_ptr<StatsWriter<PersonData>> writer;
 
 private:
+	/**
+	 * @throws std::out_of_range if there is no record for the slot.
+	 */
+	PersonData& record(const SlotRef& slot);
 
 public:
-	PersonDataRecorder(const std::string& fname, unsigned int buffer);
+	/**
+	 * @param level OFF or FULL. Person data can't be sampled or aggregated.
+	 */
+	PersonDataRecorder(const std::string& fname, unsigned int buffer, std::shared_ptr<AsyncWriter> io = nullptr,
+			OutputLevel level = OutputLevel::FULL);
 
 	virtual ~PersonDataRecorder();
 
 	void initRecord(PersonPtr& person, double time_of_entry);
 	void recordARTStart(PersonPtr& p, double ts);
 	void recordARTStop(PersonPtr& p, double ts);
-	void recordPREPStart(int id, double ts);
-	void recordPREPStop(int id, double ts, PrepStatus status);
+	void recordPREPStart(const SlotRef& slot, double ts);
+	void recordPREPStop(const SlotRef& slot, double ts, PrepStatus status);
 	void recordInfection(PersonPtr& p, double ts, InfectionSource source);
 	void recordDeath(PersonPtr& p, double ts);
 	void recordInitialARTLag(PersonPtr& p, double lag);
@@ -63,6 +79,12 @@ public:
 	void incrementAdheredIntervals(PersonPtr& p);
 	void finalize(const PersonPtr& p, double ts);
 
+	/**
+	 * Writes the data of the persons still alive, in id order, and flushes the writer.
+	 * This is intended to be called at the end of the model run.
+	 */
+	void close();
+
 };
 
 } /* namespace TransModel */
@@ -0,0 +1,125 @@
+/*
+ * PersonEventScheduler.cpp
+ *
+ *  Created on: May 10, 2017
+ *      Author: nick
+ */
+
+#include <cmath>
+#include <algorithm>
+
+#include "PersonEventScheduler.h"
+#include "ModelRandom.h"
+#include "Person.h"
+#include "Stats.h"
+#include "art_functions.h"
+
+namespace TransModel {
+
+PersonEventScheduler::PersonEventScheduler(double adherence_window, std::function<PersonPtr(const SlotRef&)> resolver,
+		std::function<void(const PersonPtr&)> on_prep_stop) :
+		wheel(0), due(), adherence_window_length(adherence_window), resolve(resolver), prep_stopped(on_prep_stop) {
+}
+
+PersonEventScheduler::~PersonEventScheduler() {
+}
+
+void PersonEventScheduler::schedule(PersonEventType type, const PersonPtr& person, double timestamp) {
+	PersonEvent evt { type, person->slot(), timestamp };
+	// runs at the start of the first step after it occurs
+	wheel.push((long) std::floor(evt.occursAt()) + 1, evt);
+}
+
+void PersonEventScheduler::scheduleARTInit(const PersonPtr& person, double art_at) {
+	schedule(PersonEventType::ART_INIT, person, art_at);
+}
+
+void PersonEventScheduler::scheduleAdherenceCheck(const PersonPtr& person, double check_at) {
+	schedule(PersonEventType::ADHERENCE_CHECK, person, check_at);
+}
+
+void PersonEventScheduler::schedulePrepCessation(const PersonPtr& person, double stop_at) {
+	schedule(PersonEventType::PREP_CESSATION, person, stop_at);
+}
+
+void PersonEventScheduler::run(double tick) {
+	wheel.pop((long) tick, due);
+	runDue();
+}
+
+void PersonEventScheduler::finish(double tick) {
+	wheel.pop((long) tick + 1, due);
+	due.erase(std::remove_if(due.begin(), due.end(), [tick](const PersonEvent& evt) {return evt.occursAt() > tick;}),
+			due.end());
+	runDue();
+}
+
+void PersonEventScheduler::runDue() {
+	std::stable_sort(due.begin(), due.end(),
+			[](const PersonEvent& e1, const PersonEvent& e2) {return e1.occursAt() < e2.occursAt();});
+
+	for (auto& evt : due) {
+		// person might have died in between the event being
+		// scheduled and it occurring, in which case the slot
+		// is no longer theirs
+		PersonPtr p = resolve(evt.person);
+		if (!p || p->isDead()) {
+			continue;
+		}
+
+		if (evt.type == PersonEventType::ART_INIT) {
+			initART(evt, p);
+		} else if (evt.type == PersonEventType::ADHERENCE_CHECK) {
+			checkAdherence(evt, p);
+		} else {
+			stopPrep(evt, p);
+		}
+	}
+	due.clear();
+}
+
+void PersonEventScheduler::initART(PersonEvent& evt, PersonPtr& p) {
+	initialize_adherence(p, evt.timestamp);
+	p->goOnART(evt.timestamp);
+	Stats::instance()->personDataRecorder().recordARTStart(p, evt.timestamp);
+	Stats::instance()->recordARTEvent(evt.timestamp, p->id(), true);
+	Stats::instance()->traceEvent(evt.timestamp, *p, TRACE_TREATMENT, TraceEvent::ART_STARTED, -1, 0);
+	scheduleAdherenceCheck(p, evt.timestamp + adherence_window_length);
+}
+
+void PersonEventScheduler::checkAdherence(PersonEvent& evt, PersonPtr& p) {
+	bool go_on_art = ModelRandom::instance().bernoulli(p->adherence().probability);
+	if (p->isOnART() && !go_on_art) {
+		// go off art when already on
+		p->goOffART();
+		Stats::instance()->personDataRecorder().recordARTStop(p, evt.timestamp);
+		Stats::instance()->personDataRecorder().incrementNonAdheredIntervals(p);
+		Stats::instance()->recordARTEvent(evt.timestamp, p->id(), false);
+		Stats::instance()->traceEvent(evt.timestamp, *p, TRACE_TREATMENT, TraceEvent::ART_STOPPED, -1, 0);
+	} else if (!p->isOnART() && go_on_art) {
+		p->goOnART(evt.timestamp);
+		Stats::instance()->personDataRecorder().recordARTStart(p, evt.timestamp);
+		Stats::instance()->recordARTEvent(evt.timestamp, p->id(), true);
+		Stats::instance()->traceEvent(evt.timestamp, *p, TRACE_TREATMENT, TraceEvent::ART_STARTED, -1, 0);
+		Stats::instance()->personDataRecorder().incrementAdheredIntervals(p);
+	}
+
+	scheduleAdherenceCheck(p, evt.timestamp + adherence_window_length);
+}
+
+void PersonEventScheduler::stopPrep(PersonEvent& evt, PersonPtr& p) {
+	// may have gone off prep by becoming infected
+	// prior to this event occurring
+	if (p->isOnPrep()) {
+		p->goOffPrep();
+		Stats::instance()->personDataRecorder().recordPREPStop(p->slot(), evt.timestamp, PrepStatus::OFF);
+		Stats::instance()->recordPREPEvent(evt.timestamp, p->id(), PrepStatus::OFF);
+		Stats::instance()->traceEvent(evt.timestamp, *p, TRACE_TREATMENT, TraceEvent::PREP_STOPPED, -1,
+				static_cast<int>(PrepStatus::OFF));
+		if (prep_stopped) {
+			prep_stopped(p);
+		}
+	}
+}
+
+} /* namespace TransModel */
@@ -0,0 +1,109 @@
+/*
+ * PersonEventScheduler.h
+ *
+ *  Created on: May 10, 2017
+ *      Author: nick
+ */
+
+#ifndef SRC_PERSONEVENTSCHEDULER_H_
+#define SRC_PERSONEVENTSCHEDULER_H_
+
+#include <vector>
+#include <functional>
+
+#include "common.h"
+#include "TimingWheel.h"
+#include "SlotAllocator.h"
+
+namespace TransModel {
+
+enum class PersonEventType : unsigned char {
+	ART_INIT, ADHERENCE_CHECK, PREP_CESSATION
+};
+
+struct PersonEvent {
+	PersonEventType type;
+	// resolved when the event runs, so pending events don't keep dead persons alive
+	SlotRef person;
+	double timestamp;
+
+	/**
+	 * Gets when the event occurs relative to the model's steps. ART initialization
+	 * and adherence checks occur just before the step at their timestamp, PrEP
+	 * cessation after it.
+	 */
+	double occursAt() const {
+		return type == PersonEventType::PREP_CESSATION ? timestamp : timestamp - 0.1;
+	}
+};
+
+/**
+ * Schedules and runs the per person ART initialization, ART adherence check and
+ * PrEP cessation events. Events are kept in a TimingWheel and those that occur between
+ * two steps are run as a batch at the start of the later step, in the order of when they
+ * occur and then the order in which they were scheduled. Events for persons who have
+ * died since the event was scheduled are dropped.
+ */
+class PersonEventScheduler {
+
+private:
+	TimingWheel<PersonEvent> wheel;
+	std::vector<PersonEvent> due;
+	double adherence_window_length;
+	std::function<PersonPtr(const SlotRef&)> resolve;
+	std::function<void(const PersonPtr&)> prep_stopped;
+
+	void schedule(PersonEventType type, const PersonPtr& person, double timestamp);
+	void runDue();
+
+	void initART(PersonEvent& evt, PersonPtr& p);
+	void checkAdherence(PersonEvent& evt, PersonPtr& p);
+	void stopPrep(PersonEvent& evt, PersonPtr& p);
+
+public:
+	/**
+	 * @param resolve gets the person currently holding a slot, or an empty pointer
+	 * if the slot's holder has died
+	 * @param prep_stopped if not empty, called with each person that
+	 * goes off PrEP in a PrEP cessation event
+	 */
+	PersonEventScheduler(double adherence_window_length, std::function<PersonPtr(const SlotRef&)> resolve,
+			std::function<void(const PersonPtr&)> prep_stopped = std::function<void(const PersonPtr&)>());
+	virtual ~PersonEventScheduler();
+
+	/**
+	 * Schedules the person to go on ART at the specified tick.
+	 */
+	void scheduleARTInit(const PersonPtr& person, double art_at);
+
+	/**
+	 * Schedules an ART adherence check for the person at the specified tick. Each check
+	 * schedules the next one a adherence window length later.
+	 */
+	void scheduleAdherenceCheck(const PersonPtr& person, double check_at);
+
+	/**
+	 * Schedules the person to stop PrEP at the specified tick.
+	 */
+	void schedulePrepCessation(const PersonPtr& person, double stop_at);
+
+	/**
+	 * Runs the events that occur after the previous step and before
+	 * the step at the specified tick.
+	 */
+	void run(double tick);
+
+	/**
+	 * Runs the events that occur after the step at the specified tick but no later than
+	 * that tick. This is intended to be called at the end of the model run.
+	 */
+	void finish(double tick);
+
+	size_t size() const {
+		return wheel.size();
+	}
+};
+
+} /* namespace TransModel */
+
+#endif /* SRC_PERSONEVENTSCHEDULER_H_ */
@@ -0,0 +1,71 @@
+/*
+ * PoolAllocator.cpp
+ *
+ *  Created on: May 18, 2017
+ *      Author: nick
+ */
+
+#include <algorithm>
+
+#include "PoolAllocator.h"
+
+namespace TransModel {
+
+std::ostream& operator<<(std::ostream& os, const PoolStats& stats) {
+	os << "block size: " << stats.block_size << ", chunks: " << stats.chunks << ", capacity: " << stats.capacity
+			<< ", in use: " << stats.in_use << ", peak in use: " << stats.peak_in_use << ", allocations: "
+			<< stats.allocations << ", deallocations: " << stats.deallocations;
+	return os;
+}
+
+FixedSizePool::FixedSizePool() :
+		chunks(), free_list(nullptr), stats_ { 0, 0, 0, 0, 0, 0, 0 } {
+}
+
+FixedSizePool::~FixedSizePool() {
+}
+
+void FixedSizePool::addChunk() {
+	std::unique_ptr<char[]> chunk(new char[stats_.block_size * BLOCKS_PER_CHUNK]);
+	// push in reverse so blocks are handed out in address order
+	for (size_t i = BLOCKS_PER_CHUNK; i > 0; --i) {
+		FreeBlock* block = reinterpret_cast<FreeBlock*>(chunk.get() + (i - 1) * stats_.block_size);
+		block->next = free_list;
+		free_list = block;
+	}
+	chunks.push_back(std::move(chunk));
+	++stats_.chunks;
+	stats_.capacity += BLOCKS_PER_CHUNK;
+}
+
+void* FixedSizePool::allocate(size_t size) {
+	if (stats_.block_size == 0) {
+		// room for the free list link and aligned for any type
+		size_t align = alignof(std::max_align_t);
+		size_t block_size = std::max(size, sizeof(FreeBlock));
+		stats_.block_size = (block_size + align - 1) / align * align;
+	} else if (size > stats_.block_size) {
+		return nullptr;
+	}
+
+	if (!free_list) {
+		addChunk();
+	}
+
+	FreeBlock* block = free_list;
+	free_list = block->next;
+	++stats_.allocations;
+	++stats_.in_use;
+	stats_.peak_in_use = std::max(stats_.peak_in_use, stats_.in_use);
+	return block;
+}
+
+void FixedSizePool::deallocate(void* ptr) {
+	FreeBlock* block = static_cast<FreeBlock*>(ptr);
+	block->next = free_list;
+	free_list = block;
+	++stats_.deallocations;
+	--stats_.in_use;
+}
+
+} /* namespace TransModel */
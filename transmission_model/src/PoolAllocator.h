@@ -0,0 +1,143 @@
+/*
+ * PoolAllocator.h
+ *
+ *  Created on: May 18, 2017
+ *      Author: nick
+ */
+
+#ifndef SRC_POOLALLOCATOR_H_
+#define SRC_POOLALLOCATOR_H_
+
+#include <cstddef>
+#include <vector>
+#include <memory>
+#include <new>
+#include <ostream>
+
+namespace TransModel {
+
+struct PoolStats {
+	size_t block_size, chunks, capacity, in_use, peak_in_use;
+	unsigned long allocations, deallocations;
+};
+
+std::ostream& operator<<(std::ostream& os, const PoolStats& stats);
+
+/**
+ * Pool of fixed size memory blocks. Blocks are carved out of chunks of
+ * contiguous memory and freed blocks are put on a free list for reuse, so
+ * the pool only grows when more blocks are in use at once than ever before.
+ * The block size is set by the first allocation.
+ *
+ * This is not thread safe.
+ */
+class FixedSizePool {
+
+private:
+	static const size_t BLOCKS_PER_CHUNK = 4096;
+
+	struct FreeBlock {
+		FreeBlock* next;
+	};
+
+	std::vector<std::unique_ptr<char[]>> chunks;
+	FreeBlock* free_list;
+	PoolStats stats_;
+
+	void addChunk();
+
+public:
+	FixedSizePool();
+	virtual ~FixedSizePool();
+
+	/**
+	 * Allocates a block of at least the specified size. Returns nullptr if the
+	 * size is larger than the pool's block size.
+	 */
+	void* allocate(size_t size);
+
+	/**
+	 * Returns true if memory of the specified size would have come from this pool.
+	 */
+	bool fits(size_t size) const {
+		return size <= stats_.block_size;
+	}
+
+	void deallocate(void* ptr);
+
+	const PoolStats& stats() const {
+		return stats_;
+	}
+};
+
+/**
+ * Gets the pool for the specified tag type. The pool is never destroyed
+ * so that it outlives any static objects that hold pooled objects.
+ */
+template<typename Tag>
+FixedSizePool& pool_for() {
+	static FixedSizePool* pool = new FixedSizePool();
+	return *pool;
+}
+
+/**
+ * Allocator that allocates single objects from the FixedSizePool for Tag, and
+ * arrays with operator new. Rebinding keeps the Tag, so with std::allocate_shared
+ * the object and its shared_ptr control block come from the same pool:
+ *
+ * std::allocate_shared<Person>(PoolAllocator<Person>(), ...)
+ */
+template<typename T, typename Tag = T>
+class PoolAllocator {
+
+public:
+	typedef T value_type;
+
+	template<typename U>
+	struct rebind {
+		typedef PoolAllocator<U, Tag> other;
+	};
+
+	PoolAllocator() noexcept {
+	}
+
+	template<typename U>
+	PoolAllocator(const PoolAllocator<U, Tag>&) noexcept {
+	}
+
+	T* allocate(size_t n) {
+		if (n == 1) {
+			void* ptr = pool_for<Tag>().allocate(sizeof(T));
+			if (ptr) {
+				return static_cast<T*>(ptr);
+			}
+		}
+		return static_cast<T*>(::operator new(n * sizeof(T)));
+	}
+
+	void deallocate(T* ptr, size_t n) {
+		if (n == 1 && pool_for<Tag>().fits(sizeof(T))) {
+			pool_for<Tag>().deallocate(ptr);
+		} else {
+			::operator delete(ptr);
+		}
+	}
+
+	static const PoolStats& stats() {
+		return pool_for<Tag>().stats();
+	}
+};
+
+template<typename T, typename U, typename Tag>
+bool operator==(const PoolAllocator<T, Tag>&, const PoolAllocator<U, Tag>&) {
+	return true;
+}
+
+template<typename T, typename U, typename Tag>
+bool operator!=(const PoolAllocator<T, Tag>&, const PoolAllocator<U, Tag>&) {
+	return false;
+}
+
+} /* namespace TransModel */
+
+#endif /* SRC_POOLALLOCATOR_H_ */
@@ -0,0 +1,55 @@
+/*
+ * PrepEligibleSet.cpp
+ *
+ *  Created on: May 30, 2017
+ *      Author: nick
+ */
+
+#include <algorithm>
+
+#include "PrepEligibleSet.h"
+#include "ModelRandom.h"
+
+namespace TransModel {
+
+PrepEligibleSet::PrepEligibleSet() :
+		persons() {
+}
+
+PrepEligibleSet::~PrepEligibleSet() {
+}
+
+void PrepEligibleSet::update(const PersonPtr& person) {
+	if (isEligible(*person)) {
+		persons.add(person->slot().slot, person);
+	} else {
+		persons.remove(person->slot().slot);
+	}
+}
+
+void PrepEligibleSet::remove(const Person& person) {
+	persons.remove(person.slot().slot);
+}
+
+void PrepEligibleSet::sample(double prob, std::vector<PersonPtr>& out) {
+	out.clear();
+	if (persons.empty() || prob <= 0) {
+		return;
+	}
+
+	ModelRandom& rng = ModelRandom::instance();
+	size_t count = (size_t) rng.binomial((long) persons.size(), prob);
+
+	// partial Fisher-Yates: after i iterations the first i persons
+	// are a uniform random subset of size i.
+	for (size_t i = 0; i < count; ++i) {
+		persons.swap(i, rng.uniformInt(i, persons.size() - 1));
+		out.push_back(persons[i]);
+	}
+
+	// in id order, the order in which persons were drawn for
+	// when this was done in the vitals loop
+	std::sort(out.begin(), out.end(), [](const PersonPtr& p1, const PersonPtr& p2) {return p1->id() < p2->id();});
+}
+
+} /* namespace TransModel */
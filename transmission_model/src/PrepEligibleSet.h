@@ -0,0 +1,74 @@
+/*
+ * PrepEligibleSet.h
+ *
+ *  Created on: May 30, 2017
+ *      Author: nick
+ */
+
+#ifndef SRC_PREPELIGIBLESET_H_
+#define SRC_PREPELIGIBLESET_H_
+
+#include <vector>
+
+#include "common.h"
+#include "Person.h"
+#include "IndexedSet.h"
+
+namespace TransModel {
+
+/**
+ * The living persons who are eligible to go on PrEP, that is those who
+ * are uninfected and not already on PrEP, indexed by slot so that
+ * they can be sampled without iterating over the whole population.
+ */
+class PrepEligibleSet {
+
+private:
+	IndexedSet<PersonPtr> persons;
+
+public:
+	PrepEligibleSet();
+	~PrepEligibleSet();
+
+	/**
+	 * Gets whether the specified person is eligible to go on PrEP.
+	 */
+	static bool isEligible(const Person& person) {
+		return !person.isInfected() && !person.isOnPrep();
+	}
+
+	/**
+	 * Adds the person if they are eligible, otherwise removes them. This
+	 * should be called whenever a person's infection or PrEP status changes.
+	 */
+	void update(const PersonPtr& person);
+
+	/**
+	 * Removes the person, whether eligible or not, when they die.
+	 */
+	void remove(const Person& person);
+
+	/**
+	 * Selects each eligible person with the specified probability, putting the
+	 * selected persons into out in id order. The number selected is drawn from
+	 * a binomial distribution and that many are then sampled without replacement.
+	 * The selected persons stay in this set until they are updated.
+	 */
+	void sample(double prob, std::vector<PersonPtr>& out);
+
+	bool contains(const Person& person) const {
+		return persons.contains(person.slot().slot);
+	}
+
+	size_t size() const {
+		return persons.size();
+	}
+
+	bool empty() const {
+		return persons.empty();
+	}
+};
+
+} /* namespace TransModel */
+
+#endif /* SRC_PREPELIGIBLESET_H_ */
@@ -19,7 +19,7 @@ private:
 	double start_time_, stop_time_;
 public:
 	PrepParameters(PrepStatus status, double start_time, double stop_time);
-	virtual ~PrepParameters();
+	~PrepParameters();
 
 	const PrepStatus status() const {
 		return status_;
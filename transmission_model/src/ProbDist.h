@@ -10,6 +10,10 @@
 
 #include <vector>
 #include <utility>
+#include <memory>
+#include <stdexcept>
+
+#include "AliasTable.h"
 
 namespace TransModel {
 
@@ -18,6 +22,10 @@ const double EPSILON = .00001;
 template<typename T>
 class ProbDistCreator;
 
+/**
+ * Discrete probability distribution over a set of items. Items are drawn
+ * in constant time using an AliasTable.
+ */
 template<typename T>
 class ProbDist {
 private:
@@ -25,13 +33,18 @@ private:
 
 	using PtrT = std::shared_ptr<T>;
 
-	std::vector<std::pair<double, PtrT>> bins;
-	ProbDist(std::vector<std::pair<double, PtrT>> items);
+	std::vector<PtrT> items;
+	AliasTable table;
+	ProbDist(const std::vector<std::pair<double, PtrT>>& bins);
 
 public:
 
 	~ProbDist();
-	PtrT draw(double val);
+
+	/**
+	 * Draws an item using the specified uniform [0, 1) draw.
+	 */
+	const PtrT& draw(double val) const;
 };
 
 template<typename T>
@@ -65,32 +78,32 @@ ProbDist<T> ProbDistCreator<T>::createProbDist() {
 	double sum = 0;
 	for (auto& bin : bins) {
 		sum += bin.first;
-		bin.first = sum;
 	}
 
 	if (sum < 1.0 - EPSILON || sum > 1.0 + EPSILON) {
 		//std::cout << sum << std::endl;
 		throw std::domain_error("Invalid value used to initialize ProbDist. Sum of probabilities must equal 1.");
 	}
-	bins[bins.size() - 1].first = 1.0;
 
 	return ProbDist<T>(bins);
 }
 
 template<typename T>
-ProbDist<T>::ProbDist(std::vector<std::pair<double, PtrT>> items) : bins{items} {}
+ProbDist<T>::ProbDist(const std::vector<std::pair<double, PtrT>>& bins) : items{}, table{} {
+	std::vector<double> probs;
+	for (auto& bin : bins) {
+		probs.push_back(bin.first);
+		items.push_back(bin.second);
+	}
+	table = AliasTable(probs);
+}
 
 template<typename T>
 ProbDist<T>::~ProbDist() {}
 
 template<typename T>
-std::shared_ptr<T> ProbDist<T>::draw(double val) {
-	for (auto& bin : bins) {
-		if (bin.first <= val) {
-			return bin.second;
-		}
-	}
-	return bins[bins.size() - 1].second;
+const std::shared_ptr<T>& ProbDist<T>::draw(double val) const {
+	return items[table.draw(val)];
 }
 
 
@@ -6,6 +6,9 @@
  */
 
 #include <exception>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
 
 #include "boost/algorithm/string.hpp"
 
@@ -17,16 +20,30 @@ using namespace std;
 
 RangeWithProbability::RangeWithProbability(std::vector<RangeBin> range_bins) :
 		bins { range_bins } {
+	// sorted so that the bin can be found with a binary search
+	std::stable_sort(bins.begin(), bins.end(), [](const RangeBin& b1, const RangeBin& b2) {return b1.min < b2.min;});
+	for (size_t i = 1; i < bins.size(); ++i) {
+		if (bins[i].min < bins[i - 1].max) {
+			throw std::invalid_argument("Overlapping bins in RangeWithProbability: " + std::to_string(bins[i - 1].min) + "-"
+					+ std::to_string(bins[i - 1].max) + " and " + std::to_string(bins[i].min) + "-" + std::to_string(bins[i].max));
+		}
+	}
 }
 
 RangeWithProbability::~RangeWithProbability() {
 }
 
 bool RangeWithProbability::run(float rangeValue, double draw) {
-	for (auto& bin : bins) {
-		if (bin.min <= rangeValue && bin.max > rangeValue) {
-			return draw <= bin.prob;
-		}
+	return draw <= findBin(rangeValue).prob;
+}
+
+const RangeBin& RangeWithProbability::findBin(float rangeValue) const {
+	// first bin whose min is > rangeValue, so the bin before it is the
+	// last whose min is <= rangeValue
+	auto iter = std::upper_bound(bins.begin(), bins.end(), rangeValue,
+			[](float val, const RangeBin& bin) {return val < bin.min;});
+	if (iter != bins.begin() && (iter - 1)->max > rangeValue) {
+		return *(iter - 1);
 	}
 	throw std::domain_error("Error in RangeWithProbabilty::run: rangeValue " + std::to_string(rangeValue) + " is not within any bin range");
 }
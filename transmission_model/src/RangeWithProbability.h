@@ -9,6 +9,7 @@
 #define SRC_RANGEWITHPROBABILITY_H_
 
 #include <vector>
+#include <string>
 
 namespace TransModel {
 
@@ -30,6 +31,12 @@ private:
 public:
 	virtual ~RangeWithProbability();
 	bool run(float rangeValue, double draw);
+
+	/**
+	 * Gets the bin whose range contains rangeValue. Throws a domain_error
+	 * if there is no such bin.
+	 */
+	const RangeBin& findBin(float rangeValue) const;
 };
 
 class RangeWithProbabilityCreator {
@@ -0,0 +1,96 @@
+/*
+ * SexActSampler.cpp
+ *
+ *  Created on: May 5, 2017
+ *      Author: nick
+ */
+
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+#include "SexActSampler.h"
+#include "ModelRandom.h"
+
+namespace TransModel {
+
+const std::string BERNOULLI_SAMPLER = "bernoulli";
+const std::string SKIP_AHEAD_SAMPLER = "skip_ahead";
+const std::string BINOMIAL_SAMPLER = "binomial";
+
+void BernoulliSexActSampler::sample(size_t n, double p, std::vector<size_t>& selected) {
+	selected.clear();
+	ModelRandom& rng = ModelRandom::instance();
+	for (size_t i = 0; i < n; ++i) {
+		if (rng.bernoulli(p)) {
+			selected.push_back(i);
+		}
+	}
+}
+
+void SkipAheadSexActSampler::sample(size_t n, double p, std::vector<size_t>& selected) {
+	selected.clear();
+	if (n == 0 || p <= 0) {
+		return;
+	}
+
+	if (p >= 1) {
+		for (size_t i = 0; i < n; ++i) {
+			selected.push_back(i);
+		}
+		return;
+	}
+
+	ModelRandom& rng = ModelRandom::instance();
+	// index of the next edge with a sex act is previous + 1 + gap where
+	// gap, the number of edges without a sex act, is Geometric(p) on {0, 1, ...}
+	double next = -1;
+	while (true) {
+		next += 1 + (double) rng.geometric(p);
+		if (next >= (double) n) {
+			break;
+		}
+		selected.push_back((size_t) next);
+	}
+}
+
+BinomialSexActSampler::BinomialSexActSampler() :
+		chosen() {
+}
+
+void BinomialSexActSampler::sample(size_t n, double p, std::vector<size_t>& selected) {
+	selected.clear();
+	if (n == 0 || p <= 0) {
+		return;
+	}
+
+	ModelRandom& rng = ModelRandom::instance();
+	size_t k = (size_t) rng.binomial((long) n, p);
+
+	// Floyd's algorithm: k draws for a uniform k subset of [0, n)
+	chosen.clear();
+	for (size_t j = n - k; j < n; ++j) {
+		size_t t = rng.uniformInt(0, j);
+		if (!chosen.insert(t).second) {
+			chosen.insert(j);
+			selected.push_back(j);
+		} else {
+			selected.push_back(t);
+		}
+	}
+	std::sort(selected.begin(), selected.end());
+}
+
+std::shared_ptr<SexActSampler> create_sex_act_sampler(const std::string& name) {
+	if (name == BERNOULLI_SAMPLER) {
+		return std::make_shared<BernoulliSexActSampler>();
+	} else if (name == SKIP_AHEAD_SAMPLER) {
+		return std::make_shared<SkipAheadSexActSampler>();
+	} else if (name == BINOMIAL_SAMPLER) {
+		return std::make_shared<BinomialSexActSampler>();
+	}
+
+	throw std::invalid_argument("Unknown sex act sampler: '" + name + "'");
+}
+
+} /* namespace TransModel */
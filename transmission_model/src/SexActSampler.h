@@ -0,0 +1,88 @@
+/*
+ * SexActSampler.h
+ *
+ *  Created on: May 5, 2017
+ *      Author: nick
+ */
+
+#ifndef SRC_SEXACTSAMPLER_H_
+#define SRC_SEXACTSAMPLER_H_
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <unordered_set>
+
+namespace TransModel {
+
+/**
+ * Selects which of n edges have a sex act in a time step, where each edge
+ * independently has a sex act with probability p.
+ */
+class SexActSampler {
+
+public:
+	virtual ~SexActSampler() {
+	}
+
+	/**
+	 * Puts the indices in [0, n) of the edges that have a sex act into selected
+	 * in increasing order. selected is cleared first.
+	 */
+	virtual void sample(size_t n, double p, std::vector<size_t>& selected) = 0;
+};
+
+/**
+ * Draws once per edge.
+ */
+class BernoulliSexActSampler: public SexActSampler {
+
+public:
+	virtual ~BernoulliSexActSampler() {
+	}
+
+	void sample(size_t n, double p, std::vector<size_t>& selected) override;
+};
+
+/**
+ * Draws the geometrically distributed gaps between edges with sex acts,
+ * so there is one draw per sex act rather than one per edge.
+ */
+class SkipAheadSexActSampler: public SexActSampler {
+
+public:
+	virtual ~SkipAheadSexActSampler() {
+	}
+
+	void sample(size_t n, double p, std::vector<size_t>& selected) override;
+};
+
+/**
+ * Draws the number of sex acts k from a binomial distribution and then
+ * picks a uniform random subset of k edges (Floyd's algorithm).
+ */
+class BinomialSexActSampler: public SexActSampler {
+
+private:
+	std::unordered_set<size_t> chosen;
+
+public:
+	BinomialSexActSampler();
+	virtual ~BinomialSexActSampler() {
+	}
+
+	void sample(size_t n, double p, std::vector<size_t>& selected) override;
+};
+
+extern const std::string BERNOULLI_SAMPLER;
+extern const std::string SKIP_AHEAD_SAMPLER;
+extern const std::string BINOMIAL_SAMPLER;
+
+/**
+ * Creates the named SexActSampler: one of "bernoulli", "skip_ahead" or "binomial".
+ */
+std::shared_ptr<SexActSampler> create_sex_act_sampler(const std::string& name);
+
+} /* namespace TransModel */
+
+#endif /* SRC_SEXACTSAMPLER_H_ */
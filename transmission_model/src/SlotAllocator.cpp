@@ -0,0 +1,40 @@
+/*
+ * SlotAllocator.cpp
+ *
+ *  Created on: May 19, 2017
+ *      Author: nick
+ */
+
+#include <stdexcept>
+
+#include "SlotAllocator.h"
+
+namespace TransModel {
+
+SlotAllocator::SlotAllocator() :
+		generations(), free_slots() {
+}
+
+SlotAllocator::~SlotAllocator() {
+}
+
+SlotRef SlotAllocator::allocate() {
+	if (free_slots.empty()) {
+		generations.push_back(0);
+		return {(unsigned int) generations.size() - 1, 0};
+	}
+
+	unsigned int slot = free_slots.back();
+	free_slots.pop_back();
+	return {slot, generations[slot]};
+}
+
+void SlotAllocator::release(const SlotRef& ref) {
+	if (!isCurrent(ref)) {
+		throw std::invalid_argument("Cannot release slot: slot reference is not current");
+	}
+	++generations[ref.slot];
+	free_slots.push_back(ref.slot);
+}
+
+} /* namespace TransModel */
@@ -0,0 +1,183 @@
+/*
+ * SlotAllocator.h
+ *
+ *  Created on: May 19, 2017
+ *      Author: nick
+ */
+
+#ifndef SRC_SLOTALLOCATOR_H_
+#define SRC_SLOTALLOCATOR_H_
+
+#include <vector>
+
+namespace TransModel {
+
+/**
+ * Reference to an allocated slot. The generation distinguishes the
+ * successive holders of a reused slot.
+ */
+struct SlotRef {
+	unsigned int slot, generation;
+};
+
+/**
+ * Allocates dense slot indices, reusing released slots, so that per slot
+ * data can be kept in vectors whose size is bounded by the peak number of
+ * slots in use at once.
+ */
+class SlotAllocator {
+
+private:
+	std::vector<unsigned int> generations;
+	std::vector<unsigned int> free_slots;
+
+public:
+	SlotAllocator();
+	~SlotAllocator();
+
+	/**
+	 * Allocates a slot, reusing the most recently released
+	 * slot if there is one.
+	 */
+	SlotRef allocate();
+
+	/**
+	 * Releases the slot for reuse. Any reference to the slot
+	 * will no longer be current.
+	 */
+	void release(const SlotRef& ref);
+
+	/**
+	 * Gets whether the specified reference is to the slot's current holder.
+	 */
+	bool isCurrent(const SlotRef& ref) const {
+		return ref.slot < generations.size() && generations[ref.slot] == ref.generation;
+	}
+
+	/**
+	 * Gets the number of slots, allocated or free. Every allocated slot is less than this.
+	 */
+	size_t capacity() const {
+		return generations.size();
+	}
+
+	size_t size() const {
+		return generations.size() - free_slots.size();
+	}
+};
+
+/**
+ * Map from slot to T, stored as a vector indexed by slot. An entry is
+ * only found with a reference of the same generation as it was put with,
+ * so an entry for a slot's previous holder is never returned.
+ */
+template<typename T>
+class SlotMap {
+
+private:
+	struct Entry {
+		unsigned int generation;
+		bool occupied;
+		T value;
+	};
+
+	std::vector<Entry> entries;
+	size_t count;
+
+public:
+	SlotMap() :
+			entries(), count(0) {
+	}
+
+	/**
+	 * Puts the value for the specified reference, replacing any value for
+	 * that slot.
+	 */
+	void put(const SlotRef& ref, const T& value) {
+		if (ref.slot >= entries.size()) {
+			entries.resize(ref.slot + 1, Entry { 0, false, T() });
+		}
+		Entry& entry = entries[ref.slot];
+		if (!entry.occupied) {
+			++count;
+		}
+		entry = Entry { ref.generation, true, value };
+	}
+
+	/**
+	 * Gets the value for the specified reference or nullptr if there is none.
+	 */
+	T* find(const SlotRef& ref) {
+		if (ref.slot < entries.size()) {
+			Entry& entry = entries[ref.slot];
+			if (entry.occupied && entry.generation == ref.generation) {
+				return &entry.value;
+			}
+		}
+		return nullptr;
+	}
+
+	const T* find(const SlotRef& ref) const {
+		return const_cast<SlotMap<T>*>(this)->find(ref);
+	}
+
+	bool contains(const SlotRef& ref) const {
+		return find(ref) != nullptr;
+	}
+
+	/**
+	 * Calls f with each value in this map.
+	 */
+	template<typename F>
+	void forEach(F f) const {
+		for (const Entry& entry : entries) {
+			if (entry.occupied) {
+				f(entry.value);
+			}
+		}
+	}
+
+	/**
+	 * Removes the value for the specified reference.
+	 *
+	 * @return true if the value was removed, otherwise false.
+	 */
+	bool erase(const SlotRef& ref) {
+		if (!contains(ref)) {
+			return false;
+		}
+		Entry& entry = entries[ref.slot];
+		entry.occupied = false;
+		entry.value = T();
+		--count;
+		return true;
+	}
+
+	size_t size() const {
+		return count;
+	}
+
+	/**
+	 * Calls f with each value in slot order.
+	 */
+	template<typename F>
+	void forEach(F f) {
+		for (auto& entry : entries) {
+			if (entry.occupied) {
+				f(entry.value);
+			}
+		}
+	}
+
+	/**
+	 * Removes all the values.
+	 */
+	void clear() {
+		entries.clear();
+		count = 0;
+	}
+};
+
+} /* namespace TransModel */
+
+#endif /* SRC_SLOTALLOCATOR_H_ */
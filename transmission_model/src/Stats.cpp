@@ -21,7 +21,7 @@ void ARTEvent::writeTo(FileOutput& out) {
 const std::string PREPEvent::header("\"tick\",\"p_id\",\"event_type\"");
 
 void PREPEvent::writeTo(FileOutput& out) {
-	out << tick << "," << p_id << "," << type << "\n";
+	out << tick << "," << p_id << "," << static_cast<int>(type) << "\n";
 }
 
 const std::string TestingEvent::header("\"tick\",\"p_id\",\"result\"");
@@ -31,12 +31,14 @@ void TestingEvent::writeTo(FileOutput& out) {
 }
 
 const std::string DeathEvent::header("\"tick\",\"p_id\",\"age\",\"art_status\",\"cause\"");
-const std::string DeathEvent::AGE("AGE");
-const std::string DeathEvent::INFECTION("INFECTION");
-const std::string DeathEvent::ASM("ASM");
+
+const std::string& DeathEvent::causeName(Cause cause) {
+	static const std::string names[] = { "AGE", "INFECTION", "ASM" };
+	return names[cause];
+}
 
 void DeathEvent::writeTo(FileOutput& out) {
-	out << tick << "," << p_id << "," << age << "," << art_status << "," << cause << "\n";
+	out << tick << "," << p_id << "," << age << "," << art_status << "," << causeName(cause) << "\n";
 }
 
 const std::string Biomarker::header("\"tick\",\"p_id\",\"viral_load\",\"cd4_count\",\"art_status\"");
@@ -57,6 +59,10 @@ void InfectionEvent::writeTo(FileOutput& out) {
 
 const std::string PartnershipEvent::header("\"tick\",\"edge_id\",\"p1\",\"p2\",\"type\",\"network_type\"");
 
+PartnershipEvent::PartnershipEvent() :
+		PartnershipEvent(0, 0, 0, 0, STARTED, 0) {
+}
+
 PartnershipEvent::PartnershipEvent(double tick, unsigned int edge_id, int p1, int p2, PEventType type, int net_type) :
 		tick_(tick), edge_id_(edge_id), p1_id(p1), p2_id(p2), type_ { type }, network_type { net_type } {
 }
@@ -65,6 +71,12 @@ void PartnershipEvent::writeTo(FileOutput& out) {
 	out << tick_ << "," << edge_id_ << "," << p1_id << "," << p2_id << "," << static_cast<int>(type_) << "," << network_type << "\n";
 }
 
+const std::string TraceEvent::header("\"tick\",\"p_id\",\"type\",\"other_id\",\"value\"");
+
+void TraceEvent::writeTo(FileOutput& out) {
+	out << tick << "," << p_id << "," << static_cast<int>(type) << "," << other_id << "," << value << "\n";
+}
+
 const std::string Counts::header(
 		"\"time\",\"entries\",\"max_age_exits\",\"infection_deaths\",\"asm_deaths\",\"infected_via_transmission\",\"infected_externally\",\"infected_at_entry\",\"uninfected\","
 		"\"steady_edge_count\",\"casual_edge_count\",\"vertex_count\",\"overlaps\",\"sex_acts\",\"casual_sex_acts\","
@@ -106,44 +118,93 @@ void Counts::reset() {
 	overlaps = 0;
 }
 
+void Counts::addSexActs(const Counts& other) {
+	sex_acts += other.sex_acts;
+	casual_sex_acts += other.casual_sex_acts;
+	steady_sex_acts += other.steady_sex_acts;
+	sd_casual_sex_with_condom += other.sd_casual_sex_with_condom;
+	sd_casual_sex_without_condom += other.sd_casual_sex_without_condom;
+	sd_steady_sex_with_condom += other.sd_steady_sex_with_condom;
+	sd_steady_sex_without_condom += other.sd_steady_sex_without_condom;
+	sc_casual_sex_with_condom += other.sc_casual_sex_with_condom;
+	sc_casual_sex_without_condom += other.sc_casual_sex_without_condom;
+	sc_steady_sex_with_condom += other.sc_steady_sex_with_condom;
+	sc_steady_sex_without_condom += other.sc_steady_sex_without_condom;
+}
+
 Stats* Stats::instance_ = nullptr;
 
-Stats::Stats(std::shared_ptr<StatsWriter<Counts>> counts, std::shared_ptr<StatsWriter<PartnershipEvent>> pevents,
-		std::shared_ptr<StatsWriter<InfectionEvent>> infection_event_writer, std::shared_ptr<StatsWriter<Biomarker>> bio_writer,
-		std::shared_ptr<StatsWriter<DeathEvent>> death_event_writer, const std::string& person_data_fname,
-		std::shared_ptr<StatsWriter<TestingEvent>> testing_event_writer, std::shared_ptr<StatsWriter<ARTEvent>> art_writer,
-		std::shared_ptr<StatsWriter<PREPEvent>> prep_writer) :
-		counts_writer { counts }, current_counts { }, pevent_writer { pevents }, ievent_writer { infection_event_writer }, biomarker_writer {
-				bio_writer }, death_writer { death_event_writer }, tevent_writer{testing_event_writer}, art_event_writer {art_writer}, prep_event_writer{prep_writer},
-				pd_recorder{person_data_fname, 1000}
-			 {
+Stats::Stats(std::shared_ptr<StatsWriter<Counts>> counts, std::shared_ptr<EventStream<PartnershipEvent>> pevents,
+		std::shared_ptr<EventStream<InfectionEvent>> infection_events, std::shared_ptr<EventStream<Biomarker>> biomarkers,
+		std::shared_ptr<EventStream<DeathEvent>> death_events, const std::string& person_data_fname, OutputLevel person_data_level,
+		std::shared_ptr<EventStream<TestingEvent>> testing_events, std::shared_ptr<EventStream<ARTEvent>> art_events,
+		std::shared_ptr<EventStream<PREPEvent>> prep_events, std::shared_ptr<EventStream<TraceEvent>> trace_events,
+		std::shared_ptr<AsyncWriter> io_writer) :
+		counts_writer { counts }, current_counts { }, pevent_stream { pevents }, ievent_stream { infection_events }, biomarker_stream {
+				biomarkers }, death_stream { death_events }, tevent_stream { testing_events }, art_event_stream { art_events }, prep_event_stream {
+				prep_events }, trace_stream { trace_events }, io { io_writer }, pd_recorder { person_data_fname, 1000, io_writer, person_data_level }, summary { nullptr }, summary_fname { } {
 }
 
 Stats::~Stats() {
 }
 
+void Stats::close() {
+	counts_writer->flush();
+	pevent_stream->flush();
+	ievent_stream->flush();
+	biomarker_stream->flush();
+	death_stream->flush();
+	tevent_stream->flush();
+	art_event_stream->flush();
+	prep_event_stream->flush();
+	trace_stream->flush();
+	pd_recorder.close();
+	if (summary) {
+		summary->write(summary_fname);
+	}
+	if (io) {
+		io->flush();
+	}
+}
+
 void Stats::resetForNextTimeStep() {
 	counts_writer->addOutput(current_counts);
+	if (summary) {
+		summary->add(current_counts);
+	}
+	pevent_stream->endTick(current_counts.tick);
+	ievent_stream->endTick(current_counts.tick);
+	biomarker_stream->endTick(current_counts.tick);
+	death_stream->endTick(current_counts.tick);
+	tevent_stream->endTick(current_counts.tick);
+	art_event_stream->endTick(current_counts.tick);
+	prep_event_stream->endTick(current_counts.tick);
+	trace_stream->endTick(current_counts.tick);
 	current_counts.reset();
 }
 
 void Stats::recordARTEvent(double time, int p_id, bool onART) {
-	art_event_writer->addOutput(ARTEvent{time, p_id, onART});
+	art_event_stream->record(p_id, onART, [&] {return ARTEvent {time, p_id, onART};});
 }
 
-void Stats::recordPREPEvent(double time, int p_id, int type) {
-	prep_event_writer->addOutput(PREPEvent{time, p_id, type});
+void Stats::recordPREPEvent(double time, int p_id, PrepStatus type) {
+	prep_event_stream->record(p_id, static_cast<int>(type), [&] {return PREPEvent {time, p_id, type};});
 }
 
 void Stats::recordPartnershipEvent(double t, unsigned int edge_id, int p1, int p2, PartnershipEvent::PEventType event_type, int net_type) {
-	pevent_writer->addOutput(PartnershipEvent { t, edge_id, p1, p2, event_type, net_type });
+	pevent_stream->record(edge_id, event_type, [&] {return PartnershipEvent {t, edge_id, p1, p2, event_type, net_type};});
 }
 
 void Stats::recordTestingEvent(double time, int p_id, bool result) {
-	tevent_writer->addOutput(TestingEvent{time, p_id, result});
+	tevent_stream->record(p_id, result, [&] {return TestingEvent {time, p_id, result};});
 }
 
 void Stats::recordInfectionEvent(double time, const PersonPtr& p) {
+	// entry infections have a network type of -1
+	ievent_stream->record(p->id(), -1, [&] {return infectionEvent(time, p);});
+}
+
+InfectionEvent Stats::infectionEvent(double time, const PersonPtr& p) {
 	InfectionEvent evt;
 	evt.tick = time;
 	evt.p1_id = p->id();
@@ -160,10 +221,17 @@ void Stats::recordInfectionEvent(double time, const PersonPtr& p) {
 	evt.p2_on_prep = false;
 	evt.condom_used = false;
 	evt.network_type = -1;
-	ievent_writer->addOutput(evt);
+	return evt;
 }
 
 void Stats::recordInfectionEvent(double time, const PersonPtr& p1, const PersonPtr& p2, bool condom, int net_type) {
+	// sampled by the infected person
+	ievent_stream->record(p2->id(), net_type, [&] {return infectionEvent(time, p1, p2, condom, net_type);});
+	traceEvent(time, *p1, TRACE_INFECTION, TraceEvent::INFECTED_OTHER, p2->id(), net_type);
+	traceEvent(time, *p2, TRACE_INFECTION, TraceEvent::INFECTED, p1->id(), net_type);
+}
+
+InfectionEvent Stats::infectionEvent(double time, const PersonPtr& p1, const PersonPtr& p2, bool condom, int net_type) {
 	InfectionEvent evt;
 	evt.tick = time;
 	evt.p1_id = p1->id();
@@ -180,27 +248,34 @@ void Stats::recordInfectionEvent(double time, const PersonPtr& p1, const PersonP
 	evt.p2_on_prep = p2->isOnPrep();
 	evt.condom_used = condom;
 	evt.network_type = net_type;
-	ievent_writer->addOutput(evt);
+	return evt;
 }
 
 void Stats::recordBiomarker(double time, const PersonPtr& person) {
-	Biomarker marker;
-	marker.tick = time;
-	marker.cd4 = person->infectionParameters().cd4_count;
-	marker.on_art = person->infectionParameters().art_status;
-	marker.p_id = person->id();
-	marker.viral_load = person->infectionParameters().viral_load;
-	biomarker_writer->addOutput(marker);
-}
-
-void Stats::recordDeathEvent(double time, const PersonPtr& person, const std::string& cause) {
-	DeathEvent event;
-	event.tick = time;
-	event.age = person->age();
-	event.p_id = person->id();
-	event.art_status = person->infectionParameters().art_status;
-	event.cause = cause;
-	death_writer->addOutput(event);
+	bool on_art = person->infectionParameters().art_status;
+	biomarker_stream->record(person->id(), on_art, [&] {
+		Biomarker marker;
+		marker.tick = time;
+		marker.cd4 = person->infectionParameters().cd4_count;
+		marker.on_art = on_art;
+		marker.p_id = person->id();
+		marker.viral_load = person->infectionParameters().viral_load;
+		return marker;
+	});
+}
+
+void Stats::recordDeathEvent(double time, const PersonPtr& person, DeathEvent::Cause cause) {
+	// the end of the trajectory of any traced person
+	traceEvent(time, *person, TRACE_ALL, TraceEvent::DIED, -1, cause);
+	death_stream->record(person->id(), cause, [&] {
+		DeathEvent event;
+		event.tick = time;
+		event.age = person->age();
+		event.p_id = person->id();
+		event.art_status = person->infectionParameters().art_status;
+		event.cause = cause;
+		return event;
+	});
 }
 
 } /* namespace TransModel */
@@ -13,6 +13,8 @@
 
 #include "FileOutput.h"
 #include "StatsWriter.h"
+#include "EventStream.h"
+#include "SummaryStats.h"
 #include "common.h"
 #include "PersonDataRecorder.h"
 
@@ -28,6 +30,13 @@ struct ARTEvent {
 	bool type;
 
 	void writeTo(FileOutput& out);
+
+	template<typename V>
+	void visit(V& visitor) const {
+		visitor("tick", tick);
+		visitor("p_id", p_id);
+		visitor("event_type", (int) type);
+	}
 };
 
 struct PREPEvent {
@@ -36,10 +45,17 @@ struct PREPEvent {
 
 	double tick;
 	int p_id;
-	// 0 is off prep, 1 is off because infected, 2 is on
-	int type;
+	// written as 0 for off prep, 1 for off because infected, 2 for on
+	PrepStatus type;
 
 	void writeTo(FileOutput& out);
+
+	template<typename V>
+	void visit(V& visitor) const {
+		visitor("tick", tick);
+		visitor("p_id", p_id);
+		visitor("event_type", static_cast<int>(type));
+	}
 };
 
 struct TestingEvent {
@@ -51,6 +67,13 @@ struct TestingEvent {
 	bool result;
 
 	void writeTo(FileOutput& out);
+
+	template<typename V>
+	void visit(V& visitor) const {
+		visitor("tick", tick);
+		visitor("p_id", p_id);
+		visitor("result", result);
+	}
 };
 
 struct Biomarker {
@@ -63,20 +86,47 @@ struct Biomarker {
 	bool on_art;
 
 	void writeTo(FileOutput& out);
+
+	template<typename V>
+	void visit(V& visitor) const {
+		visitor("tick", tick);
+		visitor("p_id", p_id);
+		visitor("viral_load", viral_load);
+		visitor("cd4_count", cd4);
+		visitor("art_status", on_art);
+	}
 };
 
 struct DeathEvent {
 
 	static const std::string header;
-	static const std::string AGE, INFECTION, ASM;
+
+	// the type for aggregate output is the cause's value
+	enum Cause {
+		AGE, INFECTION, ASM
+	};
 
 	double tick;
 	int p_id;
 	float age;
 	bool art_status;
-	std::string cause;
+	Cause cause;
+
+	/**
+	 * Gets the name of the cause as written to the output: "AGE", "INFECTION" or "ASM".
+	 */
+	static const std::string& causeName(Cause cause);
 
 	void writeTo(FileOutput& out);
+
+	template<typename V>
+	void visit(V& visitor) const {
+		visitor("tick", tick);
+		visitor("p_id", p_id);
+		visitor("age", age);
+		visitor("art_status", art_status);
+		visitor("cause", causeName(cause));
+	}
 };
 
 struct InfectionEvent {
@@ -91,6 +141,25 @@ struct InfectionEvent {
 	int network_type;
 
 	void writeTo(FileOutput& out);
+
+	template<typename V>
+	void visit(V& visitor) const {
+		visitor("tick", tick);
+		visitor("infector", p1_id);
+		visitor("p1_age", p1_age);
+		visitor("p1_viral_load", p1_viral_load);
+		visitor("p1_cd4", p1_cd4);
+		visitor("p1_art_status", p1_art);
+		visitor("p1_on_prep", p1_on_prep);
+		visitor("p1_infectivity", p1_infectivity);
+		visitor("condom_used", condom_used);
+		visitor("infectee", p2_id);
+		visitor("p2_age", p2_age);
+		visitor("p2_viral_load", p2_viral_load);
+		visitor("p2_cd4", p2_cd4);
+		visitor("p2_on_prep", p2_on_prep);
+		visitor("network_type", network_type);
+	}
 };
 
 struct PartnershipEvent {
@@ -105,9 +174,59 @@ struct PartnershipEvent {
 	PEventType type_;
 	int network_type;
 
+	PartnershipEvent();
 	PartnershipEvent(double tick, unsigned int edge_id, int p1, int p2, PEventType type, int net_type);
 	void writeTo(FileOutput& out);
 
+	template<typename V>
+	void visit(V& visitor) const {
+		visitor("tick", tick_);
+		visitor("edge_id", edge_id_);
+		visitor("p1", p1_id);
+		visitor("p2", p2_id);
+		visitor("type", static_cast<int>(type_));
+		visitor("network_type", network_type);
+	}
+
+};
+
+/**
+ * An event in the trajectory of a traced person. other_id is the id of the
+ * partner, infector or infectee, or -1, and value depends on the type.
+ */
+struct TraceEvent {
+
+	static const std::string header;
+
+	enum Type {
+		// value is the network type
+		PARTNERSHIP_STARTED, PARTNERSHIP_ENDED,
+		// value is the test result
+		TESTED,
+		// value is the PrepStatus for going off PrEP
+		ART_STARTED, ART_STOPPED, PREP_STARTED, PREP_STOPPED,
+		// value is the network type
+		INFECTED, INFECTED_OTHER,
+		// value is the DeathEvent cause
+		DIED
+	};
+
+	double tick;
+	int p_id;
+	Type type;
+	int other_id;
+	float value;
+
+	void writeTo(FileOutput& out);
+
+	template<typename V>
+	void visit(V& visitor) const {
+		visitor("tick", tick);
+		visitor("p_id", p_id);
+		visitor("type", static_cast<int>(type));
+		visitor("other_id", other_id);
+		visitor("value", value);
+	}
 };
 
 struct Counts {
@@ -127,6 +246,39 @@ struct Counts {
 	void reset();
 	void writeTo(FileOutput& out);
 
+	template<typename V>
+	void visit(V& visitor) const {
+		visitor("time", tick);
+		visitor("entries", entries);
+		visitor("max_age_exits", age_deaths);
+		visitor("infection_deaths", infection_deaths);
+		visitor("asm_deaths", asm_deaths);
+		visitor("infected_via_transmission", internal_infected);
+		visitor("infected_externally", external_infected);
+		visitor("infected_at_entry", infected_at_entry);
+		visitor("uninfected", uninfected);
+		visitor("steady_edge_count", main_edge_count);
+		visitor("casual_edge_count", casual_edge_count);
+		visitor("vertex_count", size);
+		visitor("overlaps", overlaps);
+		visitor("sex_acts", sex_acts);
+		visitor("casual_sex_acts", casual_sex_acts);
+		visitor("sd_casual_sex_with_condom", sd_casual_sex_with_condom);
+		visitor("sd_casual_sex_without_condom", sd_casual_sex_without_condom);
+		visitor("sc_casual_sex_with_condom", sc_casual_sex_with_condom);
+		visitor("sc_casual_sex_without_condom", sc_casual_sex_without_condom);
+		visitor("steady_sex_acts", steady_sex_acts);
+		visitor("sd_steady_sex_with_condom", sd_steady_sex_with_condom);
+		visitor("sd_steady_sex_without_condom", sd_steady_sex_without_condom);
+		visitor("sc_steady_sex_with_condom", sc_steady_sex_with_condom);
+		visitor("sc_steady_sex_without_condom", sc_steady_sex_without_condom);
+	}
+
+	/**
+	 * Adds the sex act counts in other to these counts.
+	 */
+	void addSexActs(const Counts& other);
+
 };
 
 class Stats {
@@ -134,30 +286,46 @@ class Stats {
 private:
 	std::shared_ptr<StatsWriter<Counts>> counts_writer;
 	Counts current_counts;
-	std::shared_ptr<StatsWriter<PartnershipEvent>> pevent_writer;
-	std::shared_ptr<StatsWriter<InfectionEvent>> ievent_writer;
-	std::shared_ptr<StatsWriter<Biomarker>> biomarker_writer;
-	std::shared_ptr<StatsWriter<DeathEvent>> death_writer;
-	std::shared_ptr<StatsWriter<TestingEvent>> tevent_writer;
-	std::shared_ptr<StatsWriter<ARTEvent>> art_event_writer;
-	std::shared_ptr<StatsWriter<PREPEvent>> prep_event_writer;
-
+	std::shared_ptr<EventStream<PartnershipEvent>> pevent_stream;
+	std::shared_ptr<EventStream<InfectionEvent>> ievent_stream;
+	std::shared_ptr<EventStream<Biomarker>> biomarker_stream;
+	std::shared_ptr<EventStream<DeathEvent>> death_stream;
+	std::shared_ptr<EventStream<TestingEvent>> tevent_stream;
+	std::shared_ptr<EventStream<ARTEvent>> art_event_stream;
+	std::shared_ptr<EventStream<PREPEvent>> prep_event_stream;
+	std::shared_ptr<EventStream<TraceEvent>> trace_stream;
+
+	std::shared_ptr<AsyncWriter> io;
 	PersonDataRecorder pd_recorder;
+	// null if there is no summary
+	std::shared_ptr<SummaryStats> summary;
+	std::string summary_fname;
 
 	friend class StatsBuilder;
 	static Stats* instance_;
 
-	Stats(std::shared_ptr<StatsWriter<Counts>> counts, std::shared_ptr<StatsWriter<PartnershipEvent>> pevents,
-			std::shared_ptr<StatsWriter<InfectionEvent>> infection_event_writer, std::shared_ptr<StatsWriter<Biomarker>> bio_writer,
-			std::shared_ptr<StatsWriter<DeathEvent>> death_event_writer, const std::string& person_data_fname,
-			std::shared_ptr<StatsWriter<TestingEvent>> testing_event_writer, std::shared_ptr<StatsWriter<ARTEvent>> art_event_writer,
-			std::shared_ptr<StatsWriter<PREPEvent>> prep_event_writer);
+	InfectionEvent infectionEvent(double time, const PersonPtr& p);
+	InfectionEvent infectionEvent(double time, const PersonPtr& p1, const PersonPtr& p2, bool condom, int net_type);
+
+	Stats(std::shared_ptr<StatsWriter<Counts>> counts, std::shared_ptr<EventStream<PartnershipEvent>> pevents,
+			std::shared_ptr<EventStream<InfectionEvent>> infection_events, std::shared_ptr<EventStream<Biomarker>> biomarkers,
+			std::shared_ptr<EventStream<DeathEvent>> death_events, const std::string& person_data_fname, OutputLevel person_data_level,
+			std::shared_ptr<EventStream<TestingEvent>> testing_events, std::shared_ptr<EventStream<ARTEvent>> art_events,
+			std::shared_ptr<EventStream<PREPEvent>> prep_events, std::shared_ptr<EventStream<TraceEvent>> trace_events,
+			std::shared_ptr<AsyncWriter> io);
 
 public:
 	virtual ~Stats();
 
 	void resetForNextTimeStep();
 
+	/**
+	 * Writes all the buffered output, including that of the persons still alive
+	 * and the summary, and waits until it has been written. This is intended to be called at
+	 * the end of the model run.
+	 */
+	void close();
+
 	Counts& currentCounts() {
 		return current_counts;
 	}
@@ -166,10 +334,21 @@ public:
 		return pd_recorder;
 	}
 
+	/**
+	 * Gets the summary of the counts, or nullptr if there is none.
+	 */
+	const SummaryStats* summaryStats() const {
+		return summary.get();
+	}
+
 	static Stats* instance() {
 		return instance_;
 	}
 
+	/**
+	 * Records a partnership event. Sampled partnership events are sampled by edge id
+	 * and the other sampled events by person id.
+	 */
 	void recordPartnershipEvent(double time, unsigned int edge_id, int p1, int p2, PartnershipEvent::PEventType event_type, int net_type);
 	void recordInfectionEvent(double time, const PersonPtr& p1, const PersonPtr& p2, bool condom, int net_type);
 
@@ -178,10 +357,21 @@ public:
 	 */
 	void recordInfectionEvent(double time, const PersonPtr& p);
 	void recordBiomarker(double time, const PersonPtr& person);
-	void recordDeathEvent(double time, const PersonPtr& person, const std::string& cause);
+	void recordDeathEvent(double time, const PersonPtr& person, DeathEvent::Cause cause);
 	void recordTestingEvent(double time, int p_id, bool result);
 	void recordARTEvent(double time, int p_id, bool onART);
-	void recordPREPEvent(double time, int p_id, int type);
+	void recordPREPEvent(double time, int p_id, PrepStatus type);
+
+	/**
+	 * Records a trace event for the person if the person is traced for the
+	 * specified content. The check is only a test of the person's trace flags.
+	 */
+	void traceEvent(double time, const Person& person, TraceContent content, TraceEvent::Type type, int other_id,
+			float value) {
+		if (person.isTraced(content)) {
+			trace_stream->record(person.id(), type, [&] {return TraceEvent {time, person.id(), type, other_id, value};});
+		}
+	}
 };
 
 } /* namespace TransModel */
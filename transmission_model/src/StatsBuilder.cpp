@@ -5,60 +5,115 @@
  *      Author: nick
  */
 
+#include <stdexcept>
+
 #include "StatsBuilder.h"
 
 namespace TransModel {
 
-StatsBuilder::StatsBuilder(const std::string& out_dir) : counts_writer{nullptr}, pevent_writer{nullptr}, ievent_writer(nullptr),
-		biomarker_writer{nullptr}, pd_fname{}, tevent_writer{nullptr}, art_event_writer{nullptr}, prep_event_writer{nullptr}, out_dir_{out_dir} {
+OutputFormat parse_output_format(const std::string& name) {
+	if (name == "csv") {
+		return OutputFormat::CSV;
+	} else if (name == "columnar") {
+		return OutputFormat::COLUMNAR;
+	} else if (name == "hdf5") {
+		return OutputFormat::HDF5;
+	}
+	throw std::invalid_argument("Unknown output format: '" + name + "'");
+}
+
+StatsBuilder::StatsBuilder(const std::string& out_dir, bool async) : counts_writer{nullptr}, pevent_writer{nullptr}, ievent_writer(nullptr),
+		biomarker_writer{nullptr}, pd_fname{}, pd_level{OutputLevel::FULL}, tevent_writer{nullptr}, art_event_writer{nullptr}, prep_event_writer{nullptr}, trace_writer{nullptr}, out_dir_{out_dir}, io{async ? std::make_shared<AsyncWriter>() : nullptr},
+		hdf5_fname{"events.h5"}, event_writer{nullptr}, summary_fname{}, summary_aggregates{} {
 }
 
 StatsBuilder::~StatsBuilder() {
 }
 
-StatsBuilder* StatsBuilder::artEventWriter(const std::string& fname, unsigned int buffer) {
-	art_event_writer = std::make_shared<StatsWriter<ARTEvent>>(out_dir_ + "/" + fname, ARTEvent::header, buffer);
+std::shared_ptr<EventWriter> StatsBuilder::eventWriter(OutputFormat format) {
+	if (format == OutputFormat::HDF5 && !event_writer) {
+		event_writer = std::make_shared<EventWriter>(out_dir_ + "/" + hdf5_fname);
+	}
+	return event_writer;
+}
+
+StatsBuilder* StatsBuilder::summaryFile(const std::string& fname, const std::vector<WindowedAggregate>& aggregates) {
+	summary_fname = out_dir_ + "/" + fname;
+	summary_aggregates = aggregates;
+	return this;
+}
+
+template<typename T>
+std::shared_ptr<EventStream<T>> StatsBuilder::createStream(const std::string& fname, OutputFormat format, unsigned int buffer,
+		const OutputControl& control) {
+	return create_event_stream<T>(out_dir_ + "/" + fname, format, buffer, control, io, [this, format] {return eventWriter(format);});
+}
+
+StatsBuilder* StatsBuilder::hdf5File(const std::string& fname) {
+	if (event_writer) {
+		throw std::logic_error("The HDF5 file must be set before any HDF5 output is created");
+	}
+	hdf5_fname = fname;
+	return this;
+}
+
+StatsBuilder* StatsBuilder::artEventWriter(const std::string& fname, OutputFormat format, unsigned int buffer,
+		const OutputControl& control) {
+	art_event_writer = createStream<ARTEvent>(fname, format, buffer, control);
 	return this;
 }
 
-StatsBuilder* StatsBuilder::prepEventWriter(const std::string& fname, unsigned int buffer) {
-	prep_event_writer = std::make_shared<StatsWriter<PREPEvent>>(out_dir_ + "/" + fname, PREPEvent::header, buffer);
+StatsBuilder* StatsBuilder::prepEventWriter(const std::string& fname, OutputFormat format, unsigned int buffer,
+		const OutputControl& control) {
+	prep_event_writer = createStream<PREPEvent>(fname, format, buffer, control);
 	return this;
 }
 
 
-StatsBuilder* StatsBuilder::countsWriter(const std::string& fname, unsigned int buffer) {
-	counts_writer = std::make_shared<StatsWriter<Counts>>(out_dir_ + "/" + fname, Counts::header, buffer);
+StatsBuilder* StatsBuilder::countsWriter(const std::string& fname, OutputFormat format, unsigned int buffer) {
+	counts_writer = create_stats_writer<Counts>(out_dir_ + "/" + fname, format, buffer, io, eventWriter(format));
 	return this;
 }
 
-StatsBuilder* StatsBuilder::partnershipEventWriter(const std::string& fname, unsigned int buffer) {
-	pevent_writer = std::make_shared<StatsWriter<PartnershipEvent>>(out_dir_ + "/" + fname, PartnershipEvent::header, buffer);
+StatsBuilder* StatsBuilder::partnershipEventWriter(const std::string& fname, OutputFormat format, unsigned int buffer,
+		const OutputControl& control) {
+	pevent_writer = createStream<PartnershipEvent>(fname, format, buffer, control);
 	return this;
 }
 
-StatsBuilder* StatsBuilder::infectionEventWriter(const std::string& fname, unsigned int buffer) {
-	ievent_writer = std::make_shared<StatsWriter<InfectionEvent>>(out_dir_ + "/" + fname, InfectionEvent::header, buffer);
+StatsBuilder* StatsBuilder::infectionEventWriter(const std::string& fname, OutputFormat format, unsigned int buffer,
+		const OutputControl& control) {
+	ievent_writer = createStream<InfectionEvent>(fname, format, buffer, control);
 	return this;
 }
 
-StatsBuilder* StatsBuilder::biomarkerWriter(const std::string& fname, unsigned int buffer) {
-	biomarker_writer = std::make_shared<StatsWriter<Biomarker>>(out_dir_ + "/" + fname, Biomarker::header, buffer);
+StatsBuilder* StatsBuilder::biomarkerWriter(const std::string& fname, OutputFormat format, unsigned int buffer,
+		const OutputControl& control) {
+	biomarker_writer = createStream<Biomarker>(fname, format, buffer, control);
 	return this;
 }
 
-StatsBuilder* StatsBuilder::deathEventWriter(const std::string& fname, unsigned int buffer) {
-	death_writer = std::make_shared<StatsWriter<DeathEvent>>(out_dir_ + "/" + fname, DeathEvent::header, buffer);
+StatsBuilder* StatsBuilder::deathEventWriter(const std::string& fname, OutputFormat format, unsigned int buffer,
+		const OutputControl& control) {
+	death_writer = createStream<DeathEvent>(fname, format, buffer, control);
 	return this;
 }
 
-StatsBuilder* StatsBuilder::testingEventWriter(const std::string& fname, unsigned int buffer) {
-	tevent_writer = std::make_shared<StatsWriter<TestingEvent>>(out_dir_ + "/" + fname, TestingEvent::header, buffer);
+StatsBuilder* StatsBuilder::testingEventWriter(const std::string& fname, OutputFormat format, unsigned int buffer,
+		const OutputControl& control) {
+	tevent_writer = createStream<TestingEvent>(fname, format, buffer, control);
 	return this;
 }
 
-StatsBuilder* StatsBuilder::personDataRecorder(const std::string& fname) {
+StatsBuilder* StatsBuilder::traceEventWriter(const std::string& fname, OutputFormat format, unsigned int buffer,
+		const OutputControl& control) {
+	trace_writer = createStream<TraceEvent>(fname, format, buffer, control);
+	return this;
+}
+
+StatsBuilder* StatsBuilder::personDataRecorder(const std::string& fname, OutputLevel level) {
 	pd_fname = out_dir_ + "/" + fname;
+	pd_level = level;
 	return this;
 }
 
@@ -69,7 +124,12 @@ void StatsBuilder::createStatsSingleton() {
 			delete Stats::instance_;
 		}
 		Stats::instance_ = new Stats(counts_writer, pevent_writer, ievent_writer, biomarker_writer,
-				death_writer, pd_fname, tevent_writer, art_event_writer, prep_event_writer);
+				death_writer, pd_fname, pd_level, tevent_writer, art_event_writer, prep_event_writer,
+				trace_writer ? trace_writer : std::make_shared<EventStream<TraceEvent>>(), io);
+		if (summary_fname.length() > 0) {
+			Stats::instance_->summary = std::make_shared<SummaryStats>(summary_aggregates);
+			Stats::instance_->summary_fname = summary_fname;
+		}
 	} else {
 		throw std::domain_error("Stats must be fully initialized from StatsBuilder before being used.");
 	}
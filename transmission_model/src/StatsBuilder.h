@@ -15,33 +15,84 @@
 
 namespace TransModel {
 
+/**
+ * Parses an output format name: "csv", "columnar" or "hdf5".
+ */
+OutputFormat parse_output_format(const std::string& name);
+
 class StatsBuilder {
 
 private:
 	std::shared_ptr<StatsWriter<Counts>> counts_writer;
-	std::shared_ptr<StatsWriter<PartnershipEvent>> pevent_writer;
-	std::shared_ptr<StatsWriter<InfectionEvent>> ievent_writer;
-	std::shared_ptr<StatsWriter<Biomarker>> biomarker_writer;
-	std::shared_ptr<StatsWriter<DeathEvent>> death_writer;
+	std::shared_ptr<EventStream<PartnershipEvent>> pevent_writer;
+	std::shared_ptr<EventStream<InfectionEvent>> ievent_writer;
+	std::shared_ptr<EventStream<Biomarker>> biomarker_writer;
+	std::shared_ptr<EventStream<DeathEvent>> death_writer;
 	std::string pd_fname;
-	std::shared_ptr<StatsWriter<TestingEvent>> tevent_writer;
-	std::shared_ptr<StatsWriter<ARTEvent>> art_event_writer;
-	std::shared_ptr<StatsWriter<PREPEvent>> prep_event_writer;
+	OutputLevel pd_level;
+	std::shared_ptr<EventStream<TestingEvent>> tevent_writer;
+	std::shared_ptr<EventStream<ARTEvent>> art_event_writer;
+	std::shared_ptr<EventStream<PREPEvent>> prep_event_writer;
+	std::shared_ptr<EventStream<TraceEvent>> trace_writer;
 	std::string out_dir_;
+	std::shared_ptr<AsyncWriter> io;
+	std::string hdf5_fname;
+	std::shared_ptr<EventWriter> event_writer;
+	std::string summary_fname;
+	std::vector<WindowedAggregate> summary_aggregates;
+
+	std::shared_ptr<EventWriter> eventWriter(OutputFormat format);
+
+	template<typename T>
+	std::shared_ptr<EventStream<T>> createStream(const std::string& fname, OutputFormat format, unsigned int buffer,
+			const OutputControl& control);
 
 public:
-	StatsBuilder(const std::string& out_dir);
+	/**
+	 * @param async if true the output is written on a background I/O
+	 * thread shared by all the writers.
+	 */
+	StatsBuilder(const std::string& out_dir, bool async = true);
 	virtual ~StatsBuilder();
 
-	StatsBuilder* countsWriter(const std::string& fname, unsigned int buffer = 1000);
-	StatsBuilder* partnershipEventWriter(const std::string& fname, unsigned int buffer = 1000);
-	StatsBuilder* infectionEventWriter(const std::string& fname, unsigned int buffer = 1000);
-	StatsBuilder* biomarkerWriter(const std::string& fname, unsigned int buffer = 1000);
-	StatsBuilder* deathEventWriter(const std::string& fname, unsigned int buffer = 1000);
-	StatsBuilder* testingEventWriter(const std::string& fname, unsigned int buffer = 1000);
-	StatsBuilder* personDataRecorder(const std::string& fname);
-	StatsBuilder* artEventWriter(const std::string& fname,  unsigned int buffer = 1000);
-	StatsBuilder* prepEventWriter(const std::string& fname,  unsigned int buffer = 1000);
+	StatsBuilder* countsWriter(const std::string& fname, OutputFormat format = OutputFormat::CSV, unsigned int buffer = 1000);
+	StatsBuilder* partnershipEventWriter(const std::string& fname, OutputFormat format = OutputFormat::CSV, unsigned int buffer = 1000,
+			const OutputControl& control = OutputControl());
+	StatsBuilder* infectionEventWriter(const std::string& fname, OutputFormat format = OutputFormat::CSV, unsigned int buffer = 1000,
+			const OutputControl& control = OutputControl());
+	StatsBuilder* biomarkerWriter(const std::string& fname, OutputFormat format = OutputFormat::CSV, unsigned int buffer = 1000,
+			const OutputControl& control = OutputControl());
+	StatsBuilder* deathEventWriter(const std::string& fname, OutputFormat format = OutputFormat::CSV, unsigned int buffer = 1000,
+			const OutputControl& control = OutputControl());
+	StatsBuilder* testingEventWriter(const std::string& fname, OutputFormat format = OutputFormat::CSV, unsigned int buffer = 1000,
+			const OutputControl& control = OutputControl());
+	StatsBuilder* personDataRecorder(const std::string& fname, OutputLevel level = OutputLevel::FULL);
+	StatsBuilder* artEventWriter(const std::string& fname, OutputFormat format = OutputFormat::CSV, unsigned int buffer = 1000,
+			const OutputControl& control = OutputControl());
+	StatsBuilder* prepEventWriter(const std::string& fname, OutputFormat format = OutputFormat::CSV, unsigned int buffer = 1000,
+			const OutputControl& control = OutputControl());
+
+	/**
+	 * Sets the file that the events of the traced persons are written to.
+	 * Nothing is written for them if this is not called.
+	 */
+	StatsBuilder* traceEventWriter(const std::string& fname, OutputFormat format = OutputFormat::CSV, unsigned int buffer = 1000,
+			const OutputControl& control = OutputControl());
+
+	/**
+	 * Sets the name of the single HDF5 file that all the writers with
+	 * HDF5 output write to. This defaults to events.h5 and must be set
+	 * before any of those writers are created.
+	 */
+	StatsBuilder* hdf5File(const std::string& fname);
+
+	/**
+	 * Sets the file that the SummaryStats of the counts, with the
+	 * specified additional aggregates, are written to at the end of the run.
+	 * There is no summary if this is not called.
+	 */
+	StatsBuilder* summaryFile(const std::string& fname,
+			const std::vector<WindowedAggregate>& aggregates = std::vector<WindowedAggregate>());
 
 
 	void createStatsSingleton();
@@ -11,59 +11,256 @@
 #include <string>
 #include <vector>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
 
 #include "FileOutput.h"
+#include "ColumnarWriter.h"
+#include "AsyncWriter.h"
+#include "EventWriter.h"
+#include "BufferRing.h"
 
 namespace TransModel {
 
-// T is a struct that is accumulated by this
-// class and then written out when a buffer size is
-// reached.
+enum class OutputFormat {
+	CSV, COLUMNAR, HDF5
+};
+
+/**
+ * Gets the columns visited for a default constructed T.
+ */
+template<typename T>
+ColumnSchema column_schema() {
+	ColumnSchema schema;
+	T().visit(schema);
+	return schema;
+}
+
+/**
+ * Destination of the data written by a StatsWriter.
+ */
+template<typename T>
+class StatsSink {
+
+public:
+	virtual ~StatsSink() {
+	}
+
+	virtual void write(std::vector<T>& data) = 0;
+};
+
+/**
+ * Writes each item as a csv row using the item's writeTo method.
+ */
+template<typename T>
+class CSVSink: public StatsSink<T> {
+
+private:
+	FileOutput out;
+
+public:
+	CSVSink(const std::string& fname, const std::string& header) :
+			out { fname } {
+		out << header << "\n";
+	}
+
+	virtual ~CSVSink() {
+	}
+
+	void write(std::vector<T>& data) override {
+		for (auto& item : data) {
+			item.writeTo(out);
+		}
+	}
+};
+
+/**
+ * Writes the items as chunks of binary columns, one chunk per write, using
+ * the item's visit method. The columns are those visited for a
+ * default constructed T.
+ */
+template<typename T>
+class ColumnarSink: public StatsSink<T> {
+
+private:
+	ColumnarWriter writer;
+
+public:
+	ColumnarSink(const std::string& fname) :
+			writer(fname, column_schema<T>()) {
+	}
+
+	virtual ~ColumnarSink() {
+	}
+
+	const std::string& dataFile() const {
+		return writer.dataFile();
+	}
+
+	const std::string& schemaFile() const {
+		return writer.schemaFile();
+	}
+
+	void write(std::vector<T>& data) override {
+		for (auto& item : data) {
+			item.visit(writer);
+			writer.endRow();
+		}
+		writer.writeChunk();
+	}
+};
+
+/**
+ * Appends the items to a dataset in an HDF5 EventWriter file, using the
+ * item's visit method. The columns are those visited for a default
+ * constructed T.
+ */
+template<typename T>
+class HDF5Sink: public StatsSink<T> {
+
+private:
+	std::shared_ptr<EventDataSet> dataset;
+
+public:
+	HDF5Sink(EventWriter& event_writer, const std::string& name) :
+			dataset(event_writer.createDataSet(name, column_schema<T>())) {
+	}
+
+	virtual ~HDF5Sink() {
+	}
+
+	void write(std::vector<T>& data) override {
+		for (auto& item : data) {
+			item.visit(*dataset);
+			dataset->endRow();
+		}
+		dataset->writeRows();
+	}
+};
+
+// T is a fixed size record that is accumulated by this
+// class in a buffer and then written out when the buffer
+// size is reached. The buffers are preallocated so adding
+// a record doesn't allocate. If the writer has an AsyncWriter,
+// the full buffer is written on the I/O thread while the next
+// buffer in a ring of them is filled.
 template <typename T>
 class StatsWriter {
 
+	static_assert(std::is_trivially_copyable<T>::value, "StatsWriter records must be trivially copyable");
+
 private:
-	FileOutput out;
-	std::vector<T> data;
+	static const size_t RING_SIZE = 4;
+
+	std::shared_ptr<StatsSink<T>> sink;
 	unsigned int buffer_;
+	std::shared_ptr<AsyncWriter> io;
+	// shared with the I/O tasks, which release the buffers once written
+	std::shared_ptr<BufferRing<T>> ring;
+	std::vector<T>* data;
 
 	void writeData();
 
 public:
-	StatsWriter(const std::string& fname, const std::string& header, unsigned int buffer);
+	/**
+	 * Creates a StatsWriter that writes T as csv to the specified file.
+	 */
+	StatsWriter(const std::string& fname, const std::string& header, unsigned int buffer,
+			std::shared_ptr<AsyncWriter> io_writer = nullptr);
+	StatsWriter(std::shared_ptr<StatsSink<T>> sink, unsigned int buffer, std::shared_ptr<AsyncWriter> io_writer = nullptr);
 	virtual ~StatsWriter();
 
 	void addOutput(const T& output);
+
+	/**
+	 * Writes, or submits for writing, any buffered output.
+	 */
+	void flush();
 };
 
 template<typename T>
-StatsWriter<T>::StatsWriter(const std::string& fname, const std::string& header, unsigned int buffer) : out{fname}, data{},
-	buffer_{buffer} {
-	out << header << "\n";
+StatsWriter<T>::StatsWriter(const std::string& fname, const std::string& header, unsigned int buffer,
+		std::shared_ptr<AsyncWriter> io_writer) :
+		StatsWriter(std::make_shared<CSVSink<T>>(fname, header), buffer, io_writer) {
 }
 
+template<typename T>
+StatsWriter<T>::StatsWriter(std::shared_ptr<StatsSink<T>> stats_sink, unsigned int buffer, std::shared_ptr<AsyncWriter> io_writer) :
+		sink { stats_sink }, buffer_ { buffer }, io { io_writer }, ring { std::make_shared<BufferRing<T>>(io_writer ? RING_SIZE : 1,
+				buffer) }, data { &ring->acquire() } {
+}
 
 template<typename T>
 void StatsWriter<T>::addOutput(const T& output) {
-	data.push_back(output);
-	if (data.size() == buffer_) {
+	data->push_back(output);
+	// >= so that a buffer that failed to be written or submitted
+	// is tried again on the next add
+	if (data->size() >= buffer_) {
 		writeData();
 	}
 }
 
 template<typename T>
 void StatsWriter<T>::writeData() {
-	for (auto& item : data) {
-		item.writeTo(out);
+	if (data->empty()) {
+		return;
+	}
+
+	if (io) {
+		std::vector<T>* full = data;
+		std::shared_ptr<StatsSink<T>> out = sink;
+		std::shared_ptr<BufferRing<T>> buffers = ring;
+		io->submit([out, full, buffers] {
+			try {
+				out->write(*full);
+			} catch (...) {
+				buffers->release(*full);
+				throw;
+			}
+			buffers->release(*full);
+		});
+		data = &ring->acquire();
+	} else {
+		sink->write(*data);
+		data->clear();
 	}
-	data.clear();
 }
 
 template<typename T>
-StatsWriter<T>::~StatsWriter() {
+void StatsWriter<T>::flush() {
 	writeData();
 }
 
+template<typename T>
+StatsWriter<T>::~StatsWriter() {
+	// an error from the I/O thread may be rethrown here, and must not
+	// escape the destructor
+	try {
+		writeData();
+	} catch (std::exception& ex) {
+		std::cerr << "Error writing output: " << ex.what() << std::endl;
+	}
+}
+
+/**
+ * Creates a StatsWriter that writes T to the specified file in the specified format.
+ * HDF5 output is written to a dataset named by dataset_name in event_writer's file.
+ */
+template<typename T>
+std::shared_ptr<StatsWriter<T>> create_stats_writer(const std::string& fname, OutputFormat format, unsigned int buffer,
+		std::shared_ptr<AsyncWriter> io = nullptr, std::shared_ptr<EventWriter> event_writer = nullptr) {
+	if (format == OutputFormat::COLUMNAR) {
+		return std::make_shared<StatsWriter<T>>(std::make_shared<ColumnarSink<T>>(fname), buffer, io);
+	} else if (format == OutputFormat::HDF5) {
+		if (!event_writer) {
+			throw std::invalid_argument("HDF5 output of '" + fname + "' requires an EventWriter");
+		}
+		return std::make_shared<StatsWriter<T>>(std::make_shared<HDF5Sink<T>>(*event_writer, dataset_name(fname)), buffer, io);
+	}
+	return std::make_shared<StatsWriter<T>>(fname, T::header, buffer, io);
+}
+
 
 } /* namespace TransModel */
 
@@ -0,0 +1,261 @@
+/*
+ * SummaryStats.cpp
+ *
+ *  Created on: May 29, 2017
+ *      Author: nick
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+#include <fstream>
+
+#include "boost/algorithm/string.hpp"
+#include "boost/filesystem.hpp"
+
+#include "SummaryStats.h"
+#include "Stats.h"
+
+namespace TransModel {
+
+const size_t SummaryStats::PREVALENCE_WINDOW;
+const size_t SummaryStats::YEAR;
+const size_t SummaryStats::YEARS;
+
+const double NaN = std::numeric_limits<double>::quiet_NaN();
+
+RollingWindow::RollingWindow(size_t size) :
+		values(size), next(0), count(0) {
+	if (size == 0) {
+		throw std::invalid_argument("Summary window size must be greater than 0");
+	}
+}
+
+void RollingWindow::push(double val) {
+	values[next] = val;
+	next = (next + 1) % values.size();
+	if (count < values.size()) {
+		++count;
+	}
+}
+
+double RollingWindow::sum() const {
+	double total = 0;
+	// oldest first so the result doesn't depend on the ring position
+	size_t start = (next + values.size() - count) % values.size();
+	for (size_t i = 0; i < count; ++i) {
+		total += values[(start + i) % values.size()];
+	}
+	return total;
+}
+
+double RollingWindow::mean() const {
+	return count == 0 ? NaN : sum() / count;
+}
+
+double RollingWindow::sd() const {
+	if (count < 2) {
+		return NaN;
+	}
+	double m = mean();
+	double ss = 0;
+	for (size_t i = 0; i < count; ++i) {
+		double d = values[i] - m;
+		ss += d * d;
+	}
+	return std::sqrt(ss / (count - 1));
+}
+
+double RollingWindow::min() const {
+	return count == 0 ? NaN : *std::min_element(values.begin(), values.begin() + count);
+}
+
+double RollingWindow::max() const {
+	return count == 0 ? NaN : *std::max_element(values.begin(), values.begin() + count);
+}
+
+double RollingWindow::last() const {
+	return count == 0 ? NaN : values[(next + values.size() - 1) % values.size()];
+}
+
+const std::vector<std::string> STATISTIC_NAMES { "mean", "sd", "sum", "min", "max", "last" };
+
+std::string WindowedAggregate::name() const {
+	return column + "_" + STATISTIC_NAMES[static_cast<size_t>(statistic)] + "_" + std::to_string(window);
+}
+
+std::vector<WindowedAggregate> parse_windowed_aggregates(const std::string& specs) {
+	std::vector<WindowedAggregate> aggregates;
+	std::vector<std::string> items;
+	boost::split(items, specs, boost::is_any_of(","));
+	for (auto& item : items) {
+		boost::trim(item);
+		if (item.empty()) {
+			continue;
+		}
+		std::vector<std::string> parts;
+		boost::split(parts, item, boost::is_any_of(":"));
+		if (parts.size() != 3) {
+			throw std::invalid_argument("Bad summary aggregate '" + item + "': expected column:statistic:window");
+		}
+		auto iter = std::find(STATISTIC_NAMES.begin(), STATISTIC_NAMES.end(), parts[1]);
+		if (iter == STATISTIC_NAMES.end()) {
+			throw std::invalid_argument("Bad summary aggregate '" + item + "': unknown statistic '" + parts[1] + "'");
+		}
+		long window = std::stol(parts[2]);
+		if (window <= 0) {
+			throw std::invalid_argument("Bad summary aggregate '" + item + "': window must be greater than 0");
+		}
+		aggregates.push_back( { parts[0], static_cast<SummaryStatistic>(iter - STATISTIC_NAMES.begin()), (size_t) window });
+	}
+	return aggregates;
+}
+
+namespace {
+
+/**
+ * Visitor that gets the value of a named Counts column.
+ */
+struct ColumnValue {
+	const std::string& column;
+	double value;
+	bool found;
+
+	ColumnValue(const std::string& name) :
+			column(name), value(0), found(false) {
+	}
+
+	template<typename T>
+	void operator()(const std::string& name, T val) {
+		if (name == column) {
+			value = val;
+			found = true;
+		}
+	}
+};
+
+double statistic(const RollingWindow& window, SummaryStatistic stat) {
+	switch (stat) {
+	case SummaryStatistic::MEAN:
+		return window.mean();
+	case SummaryStatistic::SD:
+		return window.sd();
+	case SummaryStatistic::SUM:
+		return window.sum();
+	case SummaryStatistic::MIN:
+		return window.min();
+	case SummaryStatistic::MAX:
+		return window.max();
+	case SummaryStatistic::LAST:
+		return window.last();
+	}
+	return NaN;
+}
+
+}
+
+SummaryStats::SummaryStats(const std::vector<WindowedAggregate>& aggs) :
+		initial(true), prevalence(PREVALENCE_WINDOW), year_ticks(0), year_sum(0), year_terms(0), prev_uninfected(0), incidence(), pop_size(
+				0), aggregates(aggs), windows() {
+	Counts counts;
+	for (auto& aggregate : aggregates) {
+		ColumnValue column(aggregate.column);
+		counts.visit(column);
+		if (!column.found) {
+			throw std::invalid_argument("Unknown summary aggregate column: '" + aggregate.column + "'");
+		}
+		windows.push_back(RollingWindow(aggregate.window));
+	}
+}
+
+double SummaryStats::currentYearIncidence() const {
+	// a year of 1 timestep has no terms, which is NaN in R too
+	return year_terms == 0 ? NaN : year_sum / year_terms;
+}
+
+void SummaryStats::add(const Counts& counts) {
+	pop_size = counts.size;
+	if (initial) {
+		initial = false;
+		return;
+	}
+
+	prevalence.push((counts.size - counts.uninfected) / (double) counts.size * 100);
+
+	if (year_ticks == YEAR) {
+		incidence.push_back(currentYearIncidence());
+		if (incidence.size() > YEARS) {
+			incidence.pop_front();
+		}
+		year_ticks = 0;
+		year_sum = 0;
+		year_terms = 0;
+	}
+	if (year_ticks > 0) {
+		year_sum += counts.internal_infected / (double) prev_uninfected;
+		++year_terms;
+	}
+	prev_uninfected = counts.uninfected;
+	++year_ticks;
+
+	for (size_t i = 0; i < aggregates.size(); ++i) {
+		ColumnValue column(aggregates[i].column);
+		counts.visit(column);
+		windows[i].push(column.value);
+	}
+}
+
+std::vector<std::pair<std::string, double>> SummaryStats::results() const {
+	std::vector<std::pair<std::string, double>> results;
+	results.push_back( { "prev_mean", prevalence.mean() });
+	results.push_back( { "prev_sd", prevalence.sd() });
+
+	std::vector<double> years(incidence.begin(), incidence.end());
+	if (year_ticks > 0) {
+		years.push_back(currentYearIncidence());
+	}
+	size_t start = years.size() > YEARS ? years.size() - YEARS : 0;
+	for (size_t i = start; i < years.size(); ++i) {
+		double inc = std::round(years[i] * YEAR * 100 * 1000) / 1000;
+		results.push_back( { "inc_" + std::to_string(i - start + 1), inc });
+	}
+
+	results.push_back( { "pop_size", (double) pop_size });
+	for (size_t i = 0; i < aggregates.size(); ++i) {
+		results.push_back( { aggregates[i].name(), statistic(windows[i], aggregates[i].statistic) });
+	}
+	return results;
+}
+
+void SummaryStats::write(const std::string& fname) const {
+	std::vector<std::pair<std::string, double>> summary = results();
+	boost::filesystem::path path(fname);
+	if (!path.parent_path().empty() && !boost::filesystem::exists(path.parent_path())) {
+		boost::filesystem::create_directories(path.parent_path());
+	}
+	// not FileOutput, which would write to a uniquely named file if this
+	// exists, as the sweep reads the summary from fname
+	std::ofstream out(fname.c_str());
+	if (!out.is_open()) {
+		throw std::runtime_error("Cannot open summary file '" + fname + "'");
+	}
+	for (size_t i = 0; i < summary.size(); ++i) {
+		out << (i == 0 ? "" : ",") << summary[i].first;
+	}
+	out << "\n";
+	for (size_t i = 0; i < summary.size(); ++i) {
+		// more precision than the other outputs' %g for calibration
+		char val[32];
+		std::snprintf(val, sizeof(val), "%.10g", summary[i].second);
+		out << (i == 0 ? "" : ",") << val;
+	}
+	out << "\n";
+	out.close();
+	if (out.fail()) {
+		throw std::runtime_error("Error writing summary file '" + fname + "'");
+	}
+}
+
+} /* namespace TransModel */
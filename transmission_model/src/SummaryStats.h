@@ -0,0 +1,144 @@
+/*
+ * SummaryStats.h
+ *
+ *  Created on: May 29, 2017
+ *      Author: nick
+ */
+
+#ifndef SRC_SUMMARYSTATS_H_
+#define SRC_SUMMARYSTATS_H_
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <utility>
+
+namespace TransModel {
+
+struct Counts;
+
+/**
+ * Mean, standard deviation, sum, min, max and last value of the
+ * most recent values, up to a fixed number of them.
+ */
+class RollingWindow {
+
+private:
+	std::vector<double> values;
+	size_t next, count;
+
+public:
+	RollingWindow(size_t size);
+
+	void push(double val);
+
+	size_t size() const {
+		return count;
+	}
+
+	double sum() const;
+	double mean() const;
+
+	/**
+	 * Gets the sample standard deviation, as R's sd.
+	 */
+	double sd() const;
+	double min() const;
+	double max() const;
+	double last() const;
+};
+
+enum class SummaryStatistic {
+	MEAN, SD, SUM, MIN, MAX, LAST
+};
+
+/**
+ * A statistic of a per timestep counts column over the last window timesteps.
+ */
+struct WindowedAggregate {
+	std::string column;
+	SummaryStatistic statistic;
+	size_t window;
+
+	/**
+	 * Gets the name of the aggregate in the summary: column_statistic_window.
+	 */
+	std::string name() const;
+};
+
+/**
+ * Parses a comma separated list of windowed aggregates, each of which is
+ * column:statistic:window, e.g. "infection_deaths:sum:3650,sex_acts:mean:365".
+ * The statistic is one of mean, sd, sum, min, max or last.
+ */
+std::vector<WindowedAggregate> parse_windowed_aggregates(const std::string& specs);
+
+/**
+ * Computes the summaries of the per timestep counts during the run. These are the
+ * summaries that were computed from counts.csv by summarize_prev, summarize_inc and
+ * summarize_pop_size in swift_proj/R/summarize_functions.R, together with any
+ * user defined windowed aggregates.
+ *
+ * As with those functions, the counts of the initial timestep 0 are not summarized,
+ * and the summaries are:
+ *
+ * prev_mean, prev_sd: the mean and standard deviation of the percentage of persons
+ * infected over the last 3650 timesteps.
+ *
+ * inc_1 ... inc_10: the yearly incidence per 100 person years, rounded to 3 decimal
+ * places, for the last 10 years. A year is 365 timesteps counted from the first
+ * timestep. A year's incidence is the mean over its timesteps after its first of the
+ * number infected via transmission divided by the previous timestep's number uninfected,
+ * multiplied by 365 * 100.
+ *
+ * pop_size: the population size at the last timestep.
+ */
+class SummaryStats {
+
+private:
+	static const size_t PREVALENCE_WINDOW = 3650;
+	static const size_t YEAR = 365;
+	static const size_t YEARS = 10;
+
+	bool initial;
+	RollingWindow prevalence;
+	// state of the current year
+	size_t year_ticks;
+	double year_sum;
+	unsigned int year_terms;
+	double prev_uninfected;
+	std::deque<double> incidence;
+	unsigned int pop_size;
+	std::vector<WindowedAggregate> aggregates;
+	std::vector<RollingWindow> windows;
+
+	double currentYearIncidence() const;
+
+public:
+	/**
+	 * @throws std::invalid_argument if an aggregate's column is not a counts column.
+	 */
+	SummaryStats(const std::vector<WindowedAggregate>& aggregates = std::vector<WindowedAggregate>());
+
+	/**
+	 * Adds the counts of a timestep.
+	 */
+	void add(const Counts& counts);
+
+	/**
+	 * Gets the names and values of the summaries.
+	 */
+	std::vector<std::pair<std::string, double>> results() const;
+
+	/**
+	 * Writes the summaries to the specified file as a csv header line
+	 * and a line of values, replacing the file if it exists.
+	 *
+	 * @throws std::runtime_error if the file cannot be written.
+	 */
+	void write(const std::string& fname) const;
+};
+
+} /* namespace TransModel */
+
+#endif /* SRC_SUMMARYSTATS_H_ */
@@ -0,0 +1,77 @@
+/*
+ * ThreadPool.cpp
+ *
+ *  Created on: May 2, 2017
+ *      Author: nick
+ */
+
+#include <stdexcept>
+
+#include "ThreadPool.h"
+
+namespace TransModel {
+
+ThreadPool::ThreadPool(unsigned int size) :
+		size_(size), workers(), mutex(), start_cond(), done_cond(), task(nullptr), generation(0), pending(0), stopping(
+				false) {
+	if (size_ == 0) {
+		throw std::invalid_argument("ThreadPool size must be greater than 0");
+	}
+
+	for (unsigned int i = 1; i < size_; ++i) {
+		workers.emplace_back(&ThreadPool::work, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	start_cond.notify_all();
+	for (auto& worker : workers) {
+		worker.join();
+	}
+}
+
+void ThreadPool::work(unsigned int idx) {
+	unsigned long seen = 0;
+	while (true) {
+		const std::function<void(unsigned int)>* f = nullptr;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			start_cond.wait(lock, [this, seen] {return stopping || generation != seen;});
+			if (stopping) {
+				return;
+			}
+			seen = generation;
+			f = task;
+		}
+
+		(*f)(idx);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			--pending;
+		}
+		done_cond.notify_one();
+	}
+}
+
+void ThreadPool::run(const std::function<void(unsigned int)>& f) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		task = &f;
+		pending = size_ - 1;
+		++generation;
+	}
+	start_cond.notify_all();
+
+	f(0);
+
+	std::unique_lock<std::mutex> lock(mutex);
+	done_cond.wait(lock, [this] {return pending == 0;});
+	task = nullptr;
+}
+
+} /* namespace TransModel */
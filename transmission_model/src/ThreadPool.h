@@ -0,0 +1,60 @@
+/*
+ * ThreadPool.h
+ *
+ *  Created on: May 2, 2017
+ *      Author: nick
+ */
+
+#ifndef SRC_THREADPOOL_H_
+#define SRC_THREADPOOL_H_
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+namespace TransModel {
+
+/**
+ * Fixed size pool of worker threads that runs a single partitioned
+ * task at a time. run(f) calls f(0) ... f(n - 1), where n is
+ * the pool size, once each and blocks until they have all completed.
+ * The calling thread runs f(0) itself so a pool of size 1
+ * creates no additional threads.
+ */
+class ThreadPool {
+
+private:
+	unsigned int size_;
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable start_cond, done_cond;
+	const std::function<void(unsigned int)>* task;
+	unsigned long generation;
+	unsigned int pending;
+	bool stopping;
+
+	void work(unsigned int idx);
+
+public:
+	ThreadPool(unsigned int size);
+	virtual ~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/**
+	 * Runs the task once for each partition index and returns
+	 * when all the partitions have completed.
+	 */
+	void run(const std::function<void(unsigned int)>& f);
+
+	unsigned int size() const {
+		return size_;
+	}
+};
+
+} /* namespace TransModel */
+
+#endif /* SRC_THREADPOOL_H_ */
@@ -0,0 +1,136 @@
+/*
+ * TimingWheel.h
+ *
+ *  Created on: May 10, 2017
+ *      Author: nick
+ */
+
+#ifndef SRC_TIMINGWHEEL_H_
+#define SRC_TIMINGWHEEL_H_
+
+#include <vector>
+
+namespace TransModel {
+
+/**
+ * Hierarchical timing wheel of items keyed by integer tick.
+ *
+ * Level 0 has a bucket for each tick in the current block of 256 ticks,
+ * level 1 a bucket for each block of 256 ticks in the current span of 65536
+ * ticks, and anything later goes into an overflow bucket. As the current
+ * tick enters a new block or span the relevant level 1 and overflow buckets
+ * are cascaded down, so each item is moved at most twice. Buckets are
+ * cleared rather than released and so their storage is reused.
+ *
+ * Items in a bucket are kept in insertion order.
+ */
+template<typename T>
+class TimingWheel {
+
+private:
+	static const int BITS = 8;
+	static const long SLOTS = 1 << BITS;
+	static const long MASK = SLOTS - 1;
+
+	struct Entry {
+		long tick;
+		T item;
+	};
+
+	long now;
+	size_t count;
+	std::vector<std::vector<Entry>> level0, level1;
+	std::vector<Entry> overflow, scratch;
+
+	void insert(const Entry& entry);
+	void cascade(std::vector<Entry>& bucket);
+	void advance();
+
+public:
+	/**
+	 * @param start the first tick that will be popped
+	 */
+	TimingWheel(long start = 0);
+
+	/**
+	 * Adds the item at the specified tick. Items added at a tick earlier
+	 * than the current tick are added at the current tick.
+	 */
+	void push(long tick, const T& item);
+
+	/**
+	 * Advances the wheel to the specified tick, putting the items added at
+	 * any tick up to and including it into out, in tick order.
+	 */
+	void pop(long tick, std::vector<T>& out);
+
+	size_t size() const {
+		return count;
+	}
+
+	/**
+	 * Gets the tick that the next call to pop will start from.
+	 */
+	long currentTick() const {
+		return now;
+	}
+};
+
+template<typename T>
+TimingWheel<T>::TimingWheel(long start) :
+		now(start), count(0), level0(SLOTS), level1(SLOTS), overflow(), scratch() {
+}
+
+template<typename T>
+void TimingWheel<T>::insert(const Entry& entry) {
+	if ((entry.tick >> BITS) == (now >> BITS)) {
+		level0[entry.tick & MASK].push_back(entry);
+	} else if ((entry.tick >> (2 * BITS)) == (now >> (2 * BITS))) {
+		level1[(entry.tick >> BITS) & MASK].push_back(entry);
+	} else {
+		overflow.push_back(entry);
+	}
+}
+
+template<typename T>
+void TimingWheel<T>::push(long tick, const T& item) {
+	insert( { tick < now ? now : tick, item });
+	++count;
+}
+
+template<typename T>
+void TimingWheel<T>::cascade(std::vector<Entry>& bucket) {
+	scratch.swap(bucket);
+	for (auto& entry : scratch) {
+		insert(entry);
+	}
+	scratch.clear();
+}
+
+template<typename T>
+void TimingWheel<T>::advance() {
+	++now;
+	if ((now & MASK) == 0) {
+		if (((now >> BITS) & MASK) == 0) {
+			cascade(overflow);
+		}
+		cascade(level1[(now >> BITS) & MASK]);
+	}
+}
+
+template<typename T>
+void TimingWheel<T>::pop(long tick, std::vector<T>& out) {
+	while (now <= tick) {
+		std::vector<Entry>& bucket = level0[now & MASK];
+		for (auto& entry : bucket) {
+			out.push_back(entry.item);
+		}
+		count -= bucket.size();
+		bucket.clear();
+		advance();
+	}
+}
+
+} /* namespace TransModel */
+
+#endif /* SRC_TIMINGWHEEL_H_ */
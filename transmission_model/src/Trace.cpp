@@ -0,0 +1,44 @@
+/*
+ * Trace.cpp
+ *
+ *  Created on: May 30, 2017
+ *      Author: nick
+ */
+
+#include <vector>
+#include <stdexcept>
+
+#include "boost/algorithm/string.hpp"
+
+#include "Trace.h"
+
+namespace TransModel {
+
+unsigned char parse_trace_contents(const std::string& contents) {
+	std::vector<std::string> items;
+	boost::split(items, contents, boost::is_any_of(","));
+	unsigned char flags = TRACE_NONE;
+	for (auto& item : items) {
+		boost::trim(item);
+		if (item.empty() || item == "none") {
+			continue;
+		} else if (item == "biomarkers") {
+			flags |= TRACE_BIOMARKERS;
+		} else if (item == "partnerships") {
+			flags |= TRACE_PARTNERSHIPS;
+		} else if (item == "testing") {
+			flags |= TRACE_TESTING;
+		} else if (item == "treatment") {
+			flags |= TRACE_TREATMENT;
+		} else if (item == "infection") {
+			flags |= TRACE_INFECTION;
+		} else if (item == "all") {
+			flags |= TRACE_ALL;
+		} else {
+			throw std::invalid_argument("Unknown trace content: '" + item + "'");
+		}
+	}
+	return flags;
+}
+
+} /* namespace TransModel */
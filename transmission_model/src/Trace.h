@@ -0,0 +1,42 @@
+/*
+ * Trace.h
+ *
+ *  Created on: May 30, 2017
+ *      Author: nick
+ */
+
+#ifndef SRC_TRACE_H_
+#define SRC_TRACE_H_
+
+#include <string>
+
+namespace TransModel {
+
+/**
+ * What is recorded for a traced person. A person's trace flags are a
+ * combination of these.
+ */
+enum TraceContent : unsigned char {
+	TRACE_NONE = 0,
+	// biomarkers every time step
+	TRACE_BIOMARKERS = 1,
+	// partnerships starting and ending
+	TRACE_PARTNERSHIPS = 2,
+	// tests and their results
+	TRACE_TESTING = 4,
+	// going on and off ART and PrEP
+	TRACE_TREATMENT = 8,
+	// becoming infected and infecting others
+	TRACE_INFECTION = 16,
+	TRACE_ALL = 31
+};
+
+/**
+ * Parses a comma separated list of trace contents: "biomarkers", "partnerships",
+ * "testing", "treatment", "infection", "all" or "none", into the combined flags.
+ */
+unsigned char parse_trace_contents(const std::string& contents);
+
+} /* namespace TransModel */
+
+#endif /* SRC_TRACE_H_ */
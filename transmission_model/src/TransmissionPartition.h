@@ -0,0 +1,77 @@
+/*
+ * TransmissionPartition.h
+ *
+ *  Created on: May 30, 2017
+ *      Author: nick
+ */
+
+#ifndef SRC_TRANSMISSIONPARTITION_H_
+#define SRC_TRANSMISSIONPARTITION_H_
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+
+#include "common.h"
+#include "Stats.h"
+#include "ThreadPool.h"
+
+namespace TransModel {
+
+/**
+ * An infection determined during a partitioned transmission run
+ * that has yet to be applied to the infectee.
+ */
+struct TransmissionCandidate {
+	unsigned int edge_id;
+	int edge_type;
+	PersonPtr infector, infectee;
+};
+
+/**
+ * Per thread results of a partitioned transmission run.
+ */
+struct TransmissionPartition {
+	Counts counts;
+	std::vector<TransmissionCandidate> candidates;
+};
+
+/**
+ * Calls f(edge, partition) for each of the edges, with the edges split into contiguous
+ * partitions, one per thread in the pool, and then collects the candidates of all the
+ * partitions into candidates, sorted by edge id. Provided f's result for an edge depends
+ * only on that edge, the candidates are the same for any number of threads.
+ */
+template<typename E, typename F>
+void run_partitioned(ThreadPool& pool, const std::vector<E*>& edges, std::vector<TransmissionPartition>& partitions,
+		F f, std::vector<TransmissionCandidate>& candidates) {
+	partitions.resize(pool.size());
+	size_t chunk = (edges.size() + pool.size() - 1) / pool.size();
+
+	std::function<void(unsigned int)> task = [&edges, &partitions, &f, chunk](unsigned int idx) {
+		TransmissionPartition& partition = partitions[idx];
+		partition.counts.reset();
+		partition.candidates.clear();
+
+		size_t begin = std::min(idx * chunk, edges.size());
+		size_t end = std::min(begin + chunk, edges.size());
+		for (size_t i = begin; i < end; ++i) {
+			f(edges[i], partition);
+		}
+	};
+	pool.run(task);
+
+	candidates.clear();
+	for (auto& partition : partitions) {
+		candidates.insert(candidates.end(), partition.candidates.begin(), partition.candidates.end());
+		partition.candidates.clear();
+	}
+	// the edges are unordered so sort to make the candidate
+	// order independent of the partitioning
+	std::sort(candidates.begin(), candidates.end(),
+			[](const TransmissionCandidate& c1, const TransmissionCandidate& c2) {return c1.edge_id < c2.edge_id;});
+}
+
+} /* namespace TransModel */
+
+#endif /* SRC_TRANSMISSIONPARTITION_H_ */
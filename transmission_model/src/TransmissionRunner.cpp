@@ -8,43 +8,83 @@
 #include "TransmissionRunner.h"
 
 #include "Person.h"
+#include "ModelRandom.h"
 
 namespace TransModel {
 
+const unsigned int TransmissionRunner::MULTIPLIER_KEY_COUNT;
+
 TransmissionRunner::TransmissionRunner(float circumcision_multiplier, float prep_multiplier, float condom_multiplier, float infective_insertive_multiplier,
 		std::vector<float>& given_dur_inf_by_age) :
 		circumcision_multiplier_(circumcision_multiplier), prep_multiplier_(prep_multiplier), condom_multiplier_(condom_multiplier),
 		infective_insertive_multiplier_(infective_insertive_multiplier),
-		dur_inf_by_age(given_dur_inf_by_age) {
+		dur_inf_by_age(given_dur_inf_by_age), multipliers(MULTIPLIER_KEY_COUNT, 1.0f) {
+	initMultipliers();
 }
 
-TransmissionRunner::~TransmissionRunner() {
-}
+void TransmissionRunner::initMultipliers() {
+	int roles[] = { VERSATILE, INSERTIVE, RECEPTIVE };
+	for (int infector_role : roles) {
+		for (int infectee_role : roles) {
+			for (int condom_used = 0; condom_used < 2; ++condom_used) {
+				for (int on_prep = 0; on_prep < 2; ++on_prep) {
+					for (int circumcised = 0; circumcised < 2; ++circumcised) {
+						float mult = 1;
+						if (condom_used) {
+							mult *= condom_multiplier_;
+						}
 
-bool TransmissionRunner::determineInfection(PersonPtr& infector, PersonPtr& infectee, bool condom_used, int edge_type) {
-	float infectivity = infector->infectivity();
+						if (on_prep) {
+							mult *= prep_multiplier_;
+						}
 
-	if (condom_used) {
-		infectivity *= condom_multiplier_;
-	}
+						if (circumcised && (infectee_role == INSERTIVE || infectee_role == VERSATILE)
+								&& infector_role == RECEPTIVE && !condom_used) {
+							mult *= circumcision_multiplier_;
+						}
 
-	if (infectee->isOnPrep()) {
-		infectivity *= prep_multiplier_;
+						if ((infector_role == INSERTIVE || infector_role == VERSATILE) && infectee_role == RECEPTIVE) {
+							mult *= infective_insertive_multiplier_;
+						}
+
+						multipliers[multiplierKey(infector_role, infectee_role, condom_used, on_prep, circumcised)] = mult;
+					}
+				}
+			}
+		}
 	}
+}
 
+TransmissionRunner::~TransmissionRunner() {
+}
+
+bool TransmissionRunner::determineInfection(const PersonPtr& infector, const PersonPtr& infectee, bool condom_used,
+		int edge_type) {
+	return determineInfection(infector, infectee, condom_used, edge_type, ModelRandom::instance().uniform());
+}
+
+unsigned int TransmissionRunner::multiplierKey(const PersonPtr& infector, const PersonPtr& infectee, bool condom_used,
+		int edge_type) const {
 	int infectee_role = edge_type == STEADY_NETWORK_TYPE ? infectee->steady_role() : infectee->casual_role();
 	int infector_role = edge_type == STEADY_NETWORK_TYPE ? infector->steady_role() : infector->casual_role();
+	return multiplierKey(infector_role, infectee_role, condom_used, infectee->isOnPrep(), infectee->isCircumcised());
+}
 
-	if (infectee->isCircumcised() && (infectee_role == INSERTIVE || infectee_role == VERSATILE)
-			&& infector_role == RECEPTIVE && !condom_used) {
-		infectivity *= circumcision_multiplier_;
-	}
+bool TransmissionRunner::determineInfection(const PersonPtr& infector, const PersonPtr& infectee, bool condom_used,
+		int edge_type, double draw) const {
+	float infectivity = infector->infectivity() * multipliers[multiplierKey(infector, infectee, condom_used, edge_type)];
+	return infectivity >= draw;
+}
 
-	if ((infector_role == INSERTIVE || infector_role == VERSATILE) && infectee_role == RECEPTIVE) {
-		infectivity *= infective_insertive_multiplier_;
+void TransmissionRunner::determineInfections(const std::vector<float>& infectivities, const std::vector<unsigned int>& keys,
+		const std::vector<double>& draws, std::vector<unsigned char>& infected) const {
+	size_t count = infectivities.size();
+	infected.resize(count);
+	const float* mults = multipliers.data();
+	for (size_t i = 0; i < count; ++i) {
+		float infectivity = infectivities[i] * mults[keys[i]];
+		infected[i] = infectivity >= draws[i];
 	}
-
-	return infectivity >= repast::Random::instance()->nextDouble();
 }
 
 float TransmissionRunner::durInfByAge(float age) {
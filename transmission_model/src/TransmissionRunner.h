@@ -22,10 +22,23 @@ private:
 	float circumcision_multiplier_, prep_multiplier_, condom_multiplier_,
 	infective_insertive_multiplier_;
 	std::vector<float> dur_inf_by_age;
+	// infectivity multiplier for each multiplierKey
+	std::vector<float> multipliers;
 
-
+	void initMultipliers();
 
 public:
+	static const unsigned int MULTIPLIER_KEY_COUNT = 72;
+
+	/**
+	 * Gets the key of the infectivity multiplier for the specified
+	 * combination of roles, condom use, infectee PrEP status and infectee
+	 * circumcision status.
+	 */
+	static unsigned int multiplierKey(int infector_role, int infectee_role, bool condom_used, bool on_prep, bool circumcised) {
+		return ((((infector_role * 3 + infectee_role) * 2 + condom_used) * 2 + on_prep) * 2) + circumcised;
+	}
+
 	TransmissionRunner(float circumcision_multiplier, float prep_multiplier, float condom_multiplier,
 			float infective_insertive_multiplier, std::vector<float>& given_dur_inf_by_age);
 	virtual ~TransmissionRunner();
@@ -40,7 +53,44 @@ public:
 	 * @param infectee the uninfected partner
 	 * @param edge_type the type of edge (steady or casual)
 	 */
-	bool determineInfection(PersonPtr& infector, PersonPtr& infectee, bool condom_used, int edge_type);
+	bool determineInfection(const PersonPtr& infector, const PersonPtr& infectee, bool condom_used, int edge_type);
+
+	/**
+	 * Returns true if the infector has infected the infectee, using the
+	 * specified draw from [0, 1) rather than the default random
+	 * number generator. This does not modify any state and so can be
+	 * called concurrently.
+	 *
+	 * @param infector the infected person
+	 * @param infectee the uninfected partner
+	 * @param edge_type the type of edge (steady or casual)
+	 * @param draw the random draw to compare against the infectivity
+	 */
+	bool determineInfection(const PersonPtr& infector, const PersonPtr& infectee, bool condom_used, int edge_type,
+			double draw) const;
+
+	/**
+	 * Gets the multiplier key for a sex act between the infector and infectee
+	 * on an edge of the specified type.
+	 */
+	unsigned int multiplierKey(const PersonPtr& infector, const PersonPtr& infectee, bool condom_used, int edge_type) const;
+
+	float multiplier(unsigned int key) const {
+		return multipliers[key];
+	}
+
+	/**
+	 * Determines the outcomes of a batch of sex acts. For each act i, infected[i]
+	 * is set to 1 if infectivities[i] adjusted by the multiplier for keys[i] is
+	 * greater than or equal to draws[i], otherwise to 0.
+	 *
+	 * @param infectivities the infectivity of each act's infector
+	 * @param keys the multiplier key of each act
+	 * @param draws a random draw from [0, 1) for each act
+	 * @param infected the vector to put the results in
+	 */
+	void determineInfections(const std::vector<float>& infectivities, const std::vector<unsigned int>& keys,
+			const std::vector<double>& draws, std::vector<unsigned char>& infected) const;
 
 	/**
 	 * Sets the infection flag, time of infection etc on the specified person and
@@ -15,11 +15,24 @@
 
 namespace TransModel {
 
+/**
+ * Sets the person's adherence data for the specified category. Adherence
+ * checks are scheduled separately by the PersonEventScheduler.
+ */
 void initialize_adherence(std::shared_ptr<Person> person, double tick, AdherenceCategory category);
 
-void initialize_adherence(std::shared_ptr<Person> person, double first_art_at_tick);
+/**
+ * Creates the distribution of adherence categories used by initialize_adherence
+ * from the adherence category proportions in the ModelConfig.
+ */
+void init_adherence_categories();
 
-void schedule_adherence(std::shared_ptr<Person> person, double first_art_at_tick);
+/**
+ * Sets the person's adherence data for a category drawn from the
+ * adherence category proportions. init_adherence_categories must have
+ * been called first.
+ */
+void initialize_adherence(std::shared_ptr<Person> person, double first_art_at_tick);
 
 }
 
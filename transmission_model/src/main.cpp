@@ -3,11 +3,14 @@
 #include <iostream>
 
 #include "repast_hpc/initialize_random.h"
+#include "repast_hpc/Random.h"
 #include "repast_hpc/RepastProcess.h"
 #include "repast_hpc/io.h"
 
 #include "Model.h"
 #include "Parameters.h"
+#include "ModelConfig.h"
+#include "ModelRandom.h"
 #include "utils.h"
 #include "file_utils.h"
 #include "FileOutput.h"
@@ -59,6 +62,8 @@ void run(std::string propsFile, int argc, char** argv) {
 
 	repast::Properties props(propsFile, argc, argv);
 	repast::initializeRandom(props);
+	// same seed as repast's generators and R's set.seed
+	TransModel::ModelRandom::initialize(repast::Random::instance()->seed());
 	std::shared_ptr<RInside> R = std::make_shared<RInside>(argc, argv);
 
 	TransModel::Parameters::initialize(props);
@@ -74,6 +79,8 @@ void run(std::string propsFile, int argc, char** argv) {
 	FileOutput out(unique_file_name(output_directory(Parameters::instance()) + "/parameters.txt"));
 	out.ostream() << Parameters::instance();
 	out.close();
+	// fail now rather than part way through the run if any are missing
+	ModelConfig::initialize(*Parameters::instance());
 
 
 	init_network(R, TransModel::Parameters::instance()->getStringParameter(R_FILE));
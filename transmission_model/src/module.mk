@@ -5,6 +5,7 @@ C_SOURCE =
 CPP_SOURCE = Person.cpp \
 	Model.cpp \
 	Parameters.cpp \
+	ModelConfig.cpp \
 	Stats.cpp \
 	StatsBuilder.cpp \
 	DiseaseParameters.cpp \
@@ -14,7 +15,6 @@ CPP_SOURCE = Person.cpp \
 	Stage.cpp \
 	TransmissionRunner.cpp \
 	PersonCreator.cpp \
-	ARTScheduler.cpp \
 	FileOutput.cpp \
 	utils.cpp \
 	file_utils.cpp \
@@ -22,15 +22,27 @@ CPP_SOURCE = Person.cpp \
 	GeometricDistribution.cpp \
 	DayRangeCalculator.cpp \
 	RangeWithProbability.cpp \
-	AdherenceCheckScheduler.cpp \
+	AliasTable.cpp \
+	ASMSampler.cpp \
+	PrepEligibleSet.cpp \
 	art_functions.cpp \
 	PrepParameters.cpp \
-	PrepCessationEvent.cpp \
+	PersonEventScheduler.cpp \
 	CondomUseAssigner.cpp \
+	ThreadPool.cpp \
+	ModelRandom.cpp \
+	PoolAllocator.cpp \
+	SlotAllocator.cpp \
+	ColumnarWriter.cpp \
+	AsyncWriter.cpp \
+	Compressor.cpp \
+	EventWriter.cpp \
+	EventStream.cpp \
+	SummaryStats.cpp \
+	Trace.cpp \
+	SexActSampler.cpp \
 	debug_utils.cpp
 	
-#	EventWriter.cpp \
-	
 
 c_source += $(C_SOURCE)
 cpp_source += $(CPP_SOURCE)
\ No newline at end of file
@@ -9,11 +9,14 @@
 #define SRC_NETWORK_UTILS_H_
 
 #include <map>
+#include <vector>
+#include <unordered_map>
 #include <exception>
 
 #include "RInside.h"
 
 #include "Network.h"
+#include "Person.h"
 #include "Stats.h"
 #include "CondomUseAssigner.h"
 
@@ -39,9 +42,10 @@ void create_r_network(double tick, List& rnet, Network<V>& net, std::map<unsigne
 	List iel(vCount);
 	List oel(vCount);
 
-	std::map<unsigned int, unsigned int> v_to_idx_map;
-	std::map<unsigned int, unsigned int> iel_idx_map;
-	std::map<unsigned int, unsigned int> oel_idx_map;
+	std::unordered_map<unsigned int, unsigned int> v_to_idx_map(vCount);
+	// next free position in each vertex's iel and oel, indexed by c_index
+	std::vector<unsigned int> iel_next(vCount, 0);
+	std::vector<unsigned int> oel_next(vCount, 0);
 
 	int idx = 1;
 	for (auto iter = net.verticesBegin(); iter != net.verticesEnd(); ++iter) {
@@ -75,14 +79,8 @@ void create_r_network(double tick, List& rnet, Network<V>& net, std::map<unsigne
 					Named("inl") = in_idx,
 					Named("outl") = out_idx);
 
-			int idx = iel_idx_map[edge->v2()->id()];
-			as<IntegerVector>(iel[in_idx - 1])(idx) = eidx;
-			iel_idx_map[edge->v2()->id()] = ++idx;
-
-			idx = oel_idx_map[edge->v1()->id()];
-			as<IntegerVector>(oel[out_idx - 1])(idx) = eidx;
-			++idx;
-			oel_idx_map[edge->v1()->id()] = idx;
+			as<IntegerVector>(iel[in_idx - 1])(iel_next[in_idx - 1]++) = eidx;
+			as<IntegerVector>(oel[out_idx - 1])(oel_next[out_idx - 1]++) = eidx;
 
 			++eidx;
 		}
@@ -114,6 +112,21 @@ void simulate(std::shared_ptr<RInside> R, Network<V>& net, const F& attributes_s
 	reset_network_edges(changes, net, idx_map, time, assigner, CASUAL_NETWORK_TYPE);
 }
 
+/**
+ * Records a partnership trace event for each traced person of the edge.
+ */
+inline void trace_partnership_event(double time, const EdgePtr<Person>& edge, TraceEvent::Type type) {
+	Stats::instance()->traceEvent(time, *edge->v1(), TRACE_PARTNERSHIPS, type, edge->v2()->id(), edge->type());
+	Stats::instance()->traceEvent(time, *edge->v2(), TRACE_PARTNERSHIPS, type, edge->v1()->id(), edge->type());
+}
+
+/**
+ * Vertices other than Persons are not traced.
+ */
+template<typename V>
+void trace_partnership_event(double time, const EdgePtr<V>& edge, TraceEvent::Type type) {
+}
+
 template<typename V, typename EdgeInit>
 void reset_network_edges(SEXP& changes, Network<V>& net, const std::map<unsigned int, unsigned int>& idx_map,
 		double time, EdgeInit& edge_initializer, int edge_type) {
@@ -132,6 +145,7 @@ void reset_network_edges(SEXP& changes, Network<V>& net, const std::map<unsigned
 			edge_initializer.initEdge(ep);
 			++added;
 			Stats::instance()->recordPartnershipEvent(time, ep->id(), out, in, PartnershipEvent::STARTED, edge_type);
+			trace_partnership_event(time, ep, TraceEvent::PARTNERSHIP_STARTED);
 		} else {
 			EdgePtr<V> res = net.removeEdge(out, in, edge_type);
 			if (!res) {
@@ -142,6 +156,7 @@ void reset_network_edges(SEXP& changes, Network<V>& net, const std::map<unsigned
 				throw std::domain_error("Updating from tergm changes: trying to remove an edge that doesn't exist");
 			}
 			Stats::instance()->recordPartnershipEvent(time, res->id(), out, in, PartnershipEvent::ENDED_DISSOLUTION, edge_type);
+			trace_partnership_event(time, res, TraceEvent::PARTNERSHIP_ENDED);
 			++removed;
 		}
 	}
@@ -47,6 +47,10 @@ MODEL_CMD="mpirun -n 1 $APP $PROPS_FILE $param_line"
 # Turn bash error checking off. This is
 # required to properly handle the model execution return value
 # the optional timeout.
+# a summary left by an earlier run in this directory must not be
+# read as this run's
+rm -f output/summary.csv
+
 set +e
 echo $MODEL_CMD
 $TIMEOUT_CMD $MODEL_CMD
@@ -59,4 +63,6 @@ if [ "$RES" -ne 0 ]; then
   else
 	   echo "---> Error in $MODEL_CMD"
   fi
+elif [ ! -f output/summary.csv ]; then
+  echo "---> No summary written to $instance_directory/output/summary.csv, summary.file must be set to summary.csv"
 fi
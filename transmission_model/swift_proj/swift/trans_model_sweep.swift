@@ -1,22 +1,12 @@
 import io;
 import sys;
 import files;
-import R;
 import string;
+import assert;
 
 string emews_root = getenv("EMEWS_PROJECT_ROOT");
 string turbine_output = getenv("TURBINE_OUTPUT");
 
-string summarize_template = """
-source('%s/R/summarize_functions.R')
-f <- '%s'
-prev <- summarize_prev(f)
-inc <- summarize_inc(f)
-pop_size <- summarize_pop_size(f)
-a <- paste(paste(prev, collapse=','), paste(inc, collapse=','),
-  paste(pop_size, collapse=','), sep = ',')
-""";
-
 app (file out, file err) run_model (file shfile, string param_line, string instance)
 {
     "bash" shfile param_line emews_root instance @stdout=out @stderr=err;
@@ -45,9 +35,14 @@ run_prerequisites() => {
       file out <instance+"out.txt">;
       file err <instance+"err.txt">;
       (out,err) = run_model(model_sh, s, instance) => {
-        string summarize_code = summarize_template % (emews_root, instance + "output/counts.csv");
-        string result = R(summarize_code, "a");
-        results[i] = "%i,%s" % (i + 1, result);
+        // the model writes the prevalence, incidence and population size
+        // summaries as a header line and a line of values to summary.file
+        string summary_file = instance + "output/summary.csv";
+        assert(file_exists(summary_file),
+          "%s not found: summary.file must be set to summary.csv in the model properties" % summary_file) => {
+          string summary[] = file_lines(input(summary_file));
+          results[i] = "%i,%s" % (i + 1, summary[1]);
+        }
       }
     }
   }
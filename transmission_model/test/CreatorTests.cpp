@@ -5,16 +5,28 @@
  *      Author: nick
  */
 
+#include <fstream>
+#include <map>
+#include <algorithm>
+
 #include "gtest/gtest.h"
 
+#include "boost/filesystem.hpp"
+#include "boost/algorithm/string.hpp"
+
 #include "repast_hpc/RepastProcess.h"
 
 #include "Parameters.h"
+#include "ModelConfig.h"
 #include "PersonCreator.h"
 #include "RInstance.h"
 #include "TransmissionRunner.h"
 #include "StatsBuilder.h"
+#include "PersonDataRecorder.h"
 #include "utils.h"
+#include "art_functions.h"
+#include "ModelRandom.h"
+#include "PrepEligibleSet.h"
 
 using namespace TransModel;
 using namespace Rcpp;
@@ -41,8 +53,11 @@ protected:
 		Parameters::initialize(props);
 		init_parameters("../test_data/parameters.R", "../test_data/params_derived.R", "", Parameters::instance(),
 					RInstance::rptr);
+		ModelConfig::initialize(*Parameters::instance());
+		init_adherence_categories();
 
 		repast::Random::initialize(1);
+		ModelRandom::initialize(repast::Random::instance()->seed());
 		repast::RepastProcess::init("");
 
 		float non_tester_rate = Parameters::instance()->getDoubleParameter(NON_TESTERS_PROP);
@@ -84,17 +99,18 @@ TEST_F(CreatorTests, TestInfectedPersonCreationNoART) {
 	ASSERT_FALSE(person->isOnPrep());
 
 	InfectionParameters params = person->infectionParameters();
+	const ARTInitParameters& art_params = person->artInitParameters();
 	ASSERT_FALSE(params.art_status);
 	ASSERT_FLOAT_EQ(294, params.time_since_infection);
 	ASSERT_FLOAT_EQ(-294, params.time_of_infection);
 	ASSERT_FLOAT_EQ(61.87456, params.age_at_infection);
 	ASSERT_FLOAT_EQ(455.2354, params.cd4_count);
 	ASSERT_TRUE(isnan(params.time_since_art_init));
-	ASSERT_TRUE(isnan(params.time_of_art_init));
+	ASSERT_TRUE(isnan(art_params.time_of_art_init));
 	ASSERT_FLOAT_EQ(4.2f, params.viral_load);
 	ASSERT_TRUE(isnan(params.vl_art_traj_slope));
-	ASSERT_TRUE(isnan(params.vl_at_art_init));
-	ASSERT_TRUE(isnan(params.cd4_at_art_init));
+	ASSERT_TRUE(isnan(art_params.vl_at_art_init));
+	ASSERT_TRUE(isnan(art_params.cd4_at_art_init));
 }
 
 TEST_F(CreatorTests, TestUninfectedPersonCreation) {
@@ -118,6 +134,7 @@ TEST_F(CreatorTests, TestUninfectedPersonCreation) {
 	ASSERT_TRUE(person->isOnPrep());
 
 	InfectionParameters params = person->infectionParameters();
+	const ARTInitParameters& art_params = person->artInitParameters();
 	ASSERT_FALSE(params.art_status);
 	ASSERT_TRUE(isnan(params.time_since_infection));
 	ASSERT_TRUE(isnan(params.time_of_infection));
@@ -125,11 +142,11 @@ TEST_F(CreatorTests, TestUninfectedPersonCreation) {
 	ASSERT_FLOAT_EQ(518.0f, params.cd4_count);
 	ASSERT_TRUE(isnan(params.time_since_infection));
 	ASSERT_TRUE(isnan(params.time_since_art_init));
-	ASSERT_TRUE(isnan(params.time_of_art_init));
+	ASSERT_TRUE(isnan(art_params.time_of_art_init));
 	ASSERT_FLOAT_EQ(0, params.viral_load);
 	ASSERT_TRUE(isnan(params.vl_art_traj_slope));
-	ASSERT_TRUE(isnan(params.vl_at_art_init));
-	ASSERT_TRUE(isnan(params.cd4_at_art_init));
+	ASSERT_TRUE(isnan(art_params.vl_at_art_init));
+	ASSERT_TRUE(isnan(art_params.cd4_at_art_init));
 }
 
 TEST_F(CreatorTests, TestInfectedPersonCreationART) {
@@ -162,17 +179,18 @@ TEST_F(CreatorTests, TestInfectedPersonCreationART) {
 	ASSERT_FALSE(person->isOnPrep());
 
 	InfectionParameters params = person->infectionParameters();
+	const ARTInitParameters& art_params = person->artInitParameters();
 	ASSERT_TRUE(params.art_status);
 	ASSERT_FLOAT_EQ(2134, params.time_since_infection);
 	ASSERT_FLOAT_EQ(-2134, params.time_of_infection);
 	ASSERT_FLOAT_EQ(17.89907f, params.age_at_infection);
 	ASSERT_FLOAT_EQ(257.4882f, params.cd4_count);
 	ASSERT_EQ(0, params.time_since_art_init);
-	ASSERT_EQ(0, params.time_of_art_init);
+	ASSERT_EQ(0, art_params.time_of_art_init);
 	ASSERT_FLOAT_EQ(4.276811f, params.viral_load);
 	ASSERT_NEAR(0.02148201f, params.vl_art_traj_slope, 0.000001);
-	ASSERT_FLOAT_EQ(4.276811f, params.vl_at_art_init);
-	ASSERT_FLOAT_EQ(0, params.cd4_at_art_init);
+	ASSERT_FLOAT_EQ(4.276811f, art_params.vl_at_art_init);
+	ASSERT_FLOAT_EQ(0, art_params.cd4_at_art_init);
 }
 
 TEST_F(CreatorTests, TestCreatorFromSavedNet) {
@@ -191,6 +209,36 @@ TEST_F(CreatorTests, TestCreatorFromSavedNet) {
 	}
 }
 
+TEST_F(CreatorTests, TestAdherenceCategoryDraws) {
+	std::vector<float> dur_inf { 10, 20, 30, 40 };
+	std::shared_ptr<TransmissionRunner> runner = std::make_shared<TransmissionRunner>(1, 1, 1, 1, dur_inf);
+	PersonCreator creator(runner, 0.5, 1);
+	PersonPtr person = creator(1, 30);
+
+	const ModelConfig& config = ModelConfig::instance();
+	std::map<AdherenceCategory, double> expected_props { { AdherenceCategory::ALWAYS, config.prop_always_adherent }, {
+			AdherenceCategory::NEVER, config.prop_never_adherent }, { AdherenceCategory::PARTIAL_PLUS,
+			config.prop_partial_pos_adherent }, { AdherenceCategory::PARTIAL_MINUS, config.prop_partial_neg_adherent } };
+	std::map<AdherenceCategory, double> expected_probs { { AdherenceCategory::ALWAYS, config.always_adherent_prob }, {
+			AdherenceCategory::NEVER, config.never_adherent_prob }, { AdherenceCategory::PARTIAL_PLUS,
+			config.partial_pos_adherent_prob }, { AdherenceCategory::PARTIAL_MINUS, config.partial_neg_adherent_prob } };
+
+	// categories drawn from the adherence alias table
+	std::map<AdherenceCategory, int> counts;
+	int n = 20000;
+	for (int i = 0; i < n; ++i) {
+		initialize_adherence(person, 1);
+		AdherenceCategory category = person->adherence().category;
+		ASSERT_TRUE(expected_props.find(category) != expected_props.end());
+		ASSERT_EQ(expected_probs[category], person->adherence().probability);
+		++counts[category];
+	}
+
+	for (auto& item : expected_props) {
+		ASSERT_NEAR(item.second, counts[item.first] / (double) n, 0.015);
+	}
+}
+
 TEST_F(CreatorTests, TestDiagnosis) {
 	std::string cmd = "load(file=\"../test_data/initialized-model.RData\")";
 	RInstance::rptr->parseEvalQ(cmd);
@@ -235,3 +283,169 @@ TEST_F(CreatorTests, TestDiagnosis) {
 	ASSERT_EQ(0, p2->timeUntilNextTest(50));
 	ASSERT_TRUE(p2->isDiagnosed());
 }
+
+TEST_F(CreatorTests, TestPersonDataSlotReuse) {
+	std::string cmd = "load(file=\"../test_data/initialized-model.RData\")";
+	RInstance::rptr->parseEvalQ(cmd);
+	List rnet = as<List>((*RInstance::rptr)["n0"]);
+	List val = as<List>(rnet["val"]);
+	List p_list = as<List>(val[101]);
+
+	std::vector<float> dur_inf { 10, 20, 30, 40 };
+	std::shared_ptr<TransmissionRunner> runner = std::make_shared<TransmissionRunner>(1, 1, 1, 1, dur_inf);
+	PersonCreator creator(runner, 0.5, 10);
+
+	std::string fname = "../test_output/person_data_test.csv";
+	boost::filesystem::remove(fname);
+	{
+		PersonDataRecorder recorder(fname, 10);
+		PersonPtr p0 = creator(p_list, 1);
+		PersonPtr p1 = creator(p_list, 1);
+		recorder.initRecord(p0, 0);
+		recorder.initRecord(p1, 0);
+
+		recorder.recordDeath(p0, 5);
+		creator.release(p0);
+		PersonPtr p2 = creator(p_list, 5);
+		// p2 reuses p0's slot
+		ASSERT_EQ(p0->slot().slot, p2->slot().slot);
+		recorder.initRecord(p2, 5);
+		recorder.recordARTStart(p2, 6);
+		ASSERT_THROW(recorder.recordARTStart(p0, 6), std::out_of_range);
+		recorder.close();
+	}
+
+	std::ifstream in(fname);
+	std::string line;
+	std::vector<std::vector<std::string>> rows;
+	std::getline(in, line);
+	while (std::getline(in, line)) {
+		std::vector<std::string> fields;
+		boost::split(fields, line, boost::is_any_of(","));
+		rows.push_back(fields);
+	}
+
+	// the dead person first and then those alive at the end in id order
+	ASSERT_EQ(3, rows.size());
+	ASSERT_EQ("0", rows[0][0]);
+	ASSERT_EQ("5", rows[0][2]);
+	ASSERT_EQ("1", rows[1][0]);
+	ASSERT_EQ("-1", rows[1][2]);
+	ASSERT_EQ("2", rows[2][0]);
+	ASSERT_EQ("1", rows[2][5]);
+	ASSERT_EQ("6", rows[2][6]);
+	boost::filesystem::remove(fname);
+}
+
+TEST_F(CreatorTests, TestFindBySlot) {
+	std::string cmd = "load(file=\"../test_data/initialized-model.RData\")";
+	RInstance::rptr->parseEvalQ(cmd);
+	List rnet = as<List>((*RInstance::rptr)["n0"]);
+	List val = as<List>(rnet["val"]);
+	List p_list = as<List>(val[101]);
+
+	std::vector<float> dur_inf { 10, 20, 30, 40 };
+	std::shared_ptr<TransmissionRunner> runner = std::make_shared<TransmissionRunner>(1, 1, 1, 1, dur_inf);
+	PersonCreator creator(runner, 0.5, 10);
+
+	PersonPtr p0 = creator(p_list, 1);
+	SlotRef ref = p0->slot();
+	ASSERT_EQ(p0, creator.find(ref));
+
+	creator.release(p0);
+	ASSERT_FALSE(creator.find(ref));
+
+	// the new holder of the slot is not found with the old reference
+	PersonPtr p1 = creator(p_list, 5);
+	ASSERT_EQ(ref.slot, p1->slot().slot);
+	ASSERT_FALSE(creator.find(ref));
+	ASSERT_EQ(p1, creator.find(p1->slot()));
+}
+
+TEST_F(CreatorTests, TestPrepEligibleSet) {
+	std::vector<float> dur_inf { 10, 20, 30, 40 };
+	std::shared_ptr<TransmissionRunner> runner = std::make_shared<TransmissionRunner>(1, 1, 1, 1, dur_inf);
+	PersonCreator creator(runner, 0.5, 10);
+	PrepEligibleSet eligible;
+
+	std::vector<PersonPtr> persons;
+	for (int i = 0; i < 10; ++i) {
+		persons.push_back(creator(1, 30));
+		eligible.update(persons.back());
+	}
+
+	// membership matches the eligibility predicate for every living person
+	auto check = [&persons, &eligible]() {
+		size_t count = 0;
+		for (auto& p : persons) {
+			bool is_eligible = PrepEligibleSet::isEligible(*p);
+			ASSERT_EQ(is_eligible, eligible.contains(*p));
+			if (is_eligible) {
+				++count;
+			}
+		}
+		ASSERT_EQ(count, eligible.size());
+	};
+	check();
+	ASSERT_EQ(10, eligible.size());
+
+	// updating an already eligible person doesn't add them twice
+	eligible.update(persons[0]);
+	check();
+
+	// uptake: the selected persons are eligible, in id order, and are
+	// swap-removed once on PrEP
+	std::vector<PersonPtr> starts;
+	eligible.sample(0.5, starts);
+	ASSERT_FALSE(starts.empty());
+	for (size_t i = 0; i < starts.size(); ++i) {
+		ASSERT_TRUE(eligible.contains(*starts[i]));
+		if (i > 0) {
+			ASSERT_LT(starts[i - 1]->id(), starts[i]->id());
+		}
+		starts[i]->goOnPrep(1, 10);
+		eligible.update(starts[i]);
+		check();
+	}
+
+	// infection
+	for (auto& p : persons) {
+		if (!p->isOnPrep()) {
+			p->infect(10, 2);
+			eligible.update(p);
+			check();
+			break;
+		}
+	}
+
+	// prep cessation makes an uninfected person eligible again
+	starts[0]->goOffPrep();
+	eligible.update(starts[0]);
+	check();
+	ASSERT_TRUE(eligible.contains(*starts[0]));
+
+	// death: the released slot is reused by a new eligible person
+	PersonPtr dead = starts[0];
+	dead->setDead(true);
+	eligible.remove(*dead);
+	creator.release(dead);
+	persons.erase(std::find(persons.begin(), persons.end(), dead));
+	check();
+
+	PersonPtr entry = creator(3, 20);
+	ASSERT_EQ(dead->slot().slot, entry->slot().slot);
+	ASSERT_FALSE(eligible.contains(*entry));
+	persons.push_back(entry);
+	eligible.update(entry);
+	check();
+
+	// everyone eligible goes on PrEP with probability 1
+	eligible.sample(1, starts);
+	ASSERT_EQ(eligible.size(), starts.size());
+	for (auto& p : starts) {
+		p->goOnPrep(3, 10);
+		eligible.update(p);
+		check();
+	}
+	ASSERT_TRUE(eligible.empty());
+}
@@ -5,11 +5,24 @@
  *      Author: nick
  */
 
+#include <sstream>
+#include <fstream>
+#include <limits>
+#include <cmath>
+#include <numeric>
+#include <algorithm>
+#include <random>
+
 #include "gtest/gtest.h"
 
+#include "boost/filesystem.hpp"
+#include "zlib.h"
+#include "H5Cpp.h"
+
 #include "repast_hpc/Random.h"
 
 #include "Parameters.h"
+#include "ModelConfig.h"
 #include "RInstance.h"
 #include "utils.h"
 #include "Diagnoser.h"
@@ -18,6 +31,30 @@
 #include "RangeWithProbability.h"
 
 #include "GeometricDistribution.h"
+#include "ThreadPool.h"
+#include "TransmissionPartition.h"
+#include "Edge.h"
+#include "EdgeRandomStream.h"
+#include "SexActSampler.h"
+#include "TransmissionRunner.h"
+#include "CalendarQueue.h"
+#include "TimingWheel.h"
+#include "PersonEventScheduler.h"
+#include "Person.h"
+#include "ASMSampler.h"
+#include "AliasTable.h"
+#include "ProbDist.h"
+#include "ModelRandom.h"
+#include "PoolAllocator.h"
+#include "SlotAllocator.h"
+#include "StatsWriter.h"
+#include "AsyncWriter.h"
+#include "BufferRing.h"
+#include "FileOutput.h"
+#include "EventWriter.h"
+#include "EventStream.h"
+#include "SummaryStats.h"
+#include "Stats.h"
 
 using namespace TransModel;
 using namespace Rcpp;
@@ -184,6 +221,42 @@ TEST(ParametersTests, TestParameterParsing) {
 	ASSERT_EQ(4.2, as<double>((*RInstance::rptr)["x.y.z"]));
 }
 
+TEST(ParametersTests, TestModelConfig) {
+	repast::Properties props("../test_data/test.props");
+	Parameters::initialize(props);
+	Parameters* params = Parameters::instance();
+	ASSERT_THROW(ModelConfig::create(*params), std::invalid_argument);
+
+	std::vector<std::string> keys { SIZE_OF_TIMESTEP, MIN_AGE, DAILY_ENTRY_RATE, INIT_HIV_PREV_ENTRIES,
+			EXTERNAL_INFECTION_RATE_MIN, EXTERNAL_INFECTION_RATE_MAX, PR_INSERTIVE_MAIN, PR_RECEPTIVE_MAIN,
+			PR_INSERTIVE_CASUAL, PR_RECEPTIVE_CASUAL, DAILY_TESTING_PROB, DETECTION_WINDOW, PREP_DAILY_STOP_PROB,
+			PREP_USE_PROP, PARTIAL_ART_ADHER_WINDOW_LENGTH, PROP_ALWAYS_ADHERENT, PROP_NEVER_ADHERENT,
+			PROP_PARTIAL_POS_ADHERENT, PROP_PARTIAL_NEG_ADHERENT, ALWAYS_ADHERENT_PROB, NEVER_ADHERENT_PROB,
+			PARTIAL_POS_ADHERENT_PROB, PARTIAL_NEG_ADHERENT_PROB };
+	for (auto& key : keys) {
+		params->putParameter(key, 1.0);
+	}
+	params->putParameter(MAX_AGE, 65.5);
+	params->putParameter(COUNT_OVERLAPS, false);
+	params->putParameter(DAILY_ENTRY_RATE, 0.25);
+
+	ModelConfig config = ModelConfig::create(*params);
+	ASSERT_EQ(3.5, config.stop_at);
+	ASSERT_EQ(1, config.size_of_timestep);
+	ASSERT_EQ(65, config.max_age);
+	ASSERT_EQ(0.25, config.daily_entry_rate);
+	ASSERT_FALSE(config.count_overlaps);
+
+	params->putParameter(SIZE_OF_TIMESTEP, 1.5);
+	ASSERT_THROW(ModelConfig::create(*params), std::invalid_argument);
+	params->putParameter(SIZE_OF_TIMESTEP, 1.0);
+	params->putParameter(MIN_AGE, std::string("abc"));
+	ASSERT_THROW(ModelConfig::create(*params), std::invalid_argument);
+	params->putParameter(MIN_AGE, 16.0);
+	params->putParameter(COUNT_OVERLAPS, std::string("yes"));
+	ASSERT_THROW(ModelConfig::create(*params), std::invalid_argument);
+}
+
 struct MockGen {
 
 	double next() {
@@ -206,7 +279,7 @@ TEST(DiagnoserTests, TestDiagnosis) {
 
 	std::shared_ptr<MockGen> gen = std::make_shared<MockGen>();
 	// window is 2, next_test at 5
-	Diagnoser<MockGen> diagnoser(2, 5, 0, gen);
+	Diagnoser<MockGen> diagnoser(2, 5, 0, gen.get());
 
 	ASSERT_EQ(5, diagnoser.timeUntilNextTest(0));
 	ASSERT_EQ(0, diagnoser.testCount());
@@ -246,3 +319,1339 @@ TEST(DiagnoserTests, TestDiagnosis) {
 	ASSERT_EQ(Result::POSITIVE, diagnoser.test(11, infection_params));
 	ASSERT_EQ(3, diagnoser.testCount());
 }
+
+TEST(ThreadPoolTests, TestRun) {
+	ThreadPool pool(4);
+	ASSERT_EQ(4, pool.size());
+
+	std::vector<int> counts(4, 0);
+	std::function<void(unsigned int)> task = [&counts](unsigned int idx) {
+		++counts[idx];
+	};
+
+	for (int i = 0; i < 10; ++i) {
+		pool.run(task);
+	}
+
+	for (int count : counts) {
+		ASSERT_EQ(10, count);
+	}
+
+	ASSERT_THROW(ThreadPool(0), std::invalid_argument);
+}
+
+TEST(EdgeRandomStreamTests, TestStreams) {
+	EdgeRandomStream s1(42, 1);
+	EdgeRandomStream s2(42, 1);
+	EdgeRandomStream s3(42, 2);
+	EdgeRandomStream s4(43, 1);
+
+	bool diff_edge = false, diff_seed = false;
+	for (int i = 0; i < 100; ++i) {
+		double d1 = s1.nextDouble();
+		ASSERT_TRUE(d1 >= 0 && d1 < 1);
+		ASSERT_EQ(d1, s2.nextDouble());
+		diff_edge = diff_edge || d1 != s3.nextDouble();
+		diff_seed = diff_seed || d1 != s4.nextDouble();
+	}
+	ASSERT_TRUE(diff_edge);
+	ASSERT_TRUE(diff_seed);
+}
+
+TEST(TransmissionPartitionTests, TestThreadCounts) {
+	std::shared_ptr<GeometricDistribution> gen = std::make_shared<GeometricDistribution>(0.5, 0);
+	Diagnoser<GeometricDistribution> diagnoser(0, 100, 0, gen.get());
+	std::vector<PersonPtr> persons;
+	for (int i = 0; i < 100; ++i) {
+		persons.push_back(std::make_shared<Person>(i, 20, false, 0, 0, diagnoser));
+	}
+
+	// edges in an arbitrary order, as in the discordant edge index
+	std::vector<std::shared_ptr<Edge<Person>>> edges;
+	std::vector<Edge<Person>*> edge_ptrs;
+	for (unsigned int id = 0; id < 500; ++id) {
+		edges.push_back(std::make_shared<Edge<Person>>(id, persons[id % 100], persons[(id * 7 + 1) % 100], id % 2));
+		edge_ptrs.push_back(edges.back().get());
+	}
+	std::mt19937 shuffle_gen(1);
+	std::shuffle(edge_ptrs.begin(), edge_ptrs.end(), shuffle_gen);
+
+	// as Model::runPartitionedTransmission, an edge's outcome
+	// depends only on its own random stream
+	uint64_t tick_seed = 42;
+	auto run_edge = [tick_seed](Edge<Person>* edge, TransmissionPartition& partition) {
+		EdgeRandomStream stream(tick_seed, edge->id());
+		if (stream.nextDouble() < 0.5) {
+			++partition.counts.sex_acts;
+			if (stream.nextDouble() < 0.2) {
+				partition.candidates.push_back( { edge->id(), edge->type(), edge->v1(), edge->v2() });
+			}
+		}
+	};
+
+	std::vector<TransmissionCandidate> expected;
+	unsigned int expected_sex_acts = 0;
+	for (unsigned int threads : { 1, 2, 3, 8 }) {
+		ThreadPool pool(threads);
+		std::vector<TransmissionPartition> partitions;
+		std::vector<TransmissionCandidate> candidates;
+		run_partitioned(pool, edge_ptrs, partitions, run_edge, candidates);
+		ASSERT_EQ(threads, partitions.size());
+
+		unsigned int sex_acts = 0;
+		for (auto& partition : partitions) {
+			sex_acts += partition.counts.sex_acts;
+		}
+
+		if (threads == 1) {
+			expected = candidates;
+			expected_sex_acts = sex_acts;
+			ASSERT_TRUE(expected.size() > 0);
+		} else {
+			ASSERT_EQ(expected_sex_acts, sex_acts);
+			ASSERT_EQ(expected.size(), candidates.size());
+			for (size_t i = 0; i < expected.size(); ++i) {
+				ASSERT_EQ(expected[i].edge_id, candidates[i].edge_id);
+				ASSERT_EQ(expected[i].edge_type, candidates[i].edge_type);
+				ASSERT_EQ(expected[i].infector, candidates[i].infector);
+				ASSERT_EQ(expected[i].infectee, candidates[i].infectee);
+			}
+		}
+	}
+
+	// fewer edges than threads
+	ThreadPool pool(8);
+	std::vector<TransmissionPartition> partitions;
+	std::vector<TransmissionCandidate> candidates;
+	std::vector<Edge<Person>*> few { edge_ptrs[0], edge_ptrs[1] };
+	run_partitioned(pool, few, partitions, [](Edge<Person>* edge, TransmissionPartition& partition) {
+		partition.candidates.push_back( { edge->id(), edge->type(), edge->v1(), edge->v2() });
+	}, candidates);
+	ASSERT_EQ(2, candidates.size());
+	ASSERT_TRUE(candidates[0].edge_id < candidates[1].edge_id);
+}
+
+// checks the sampler against the distribution of the per edge Bernoulli draws:
+// each edge selected with probability p, and so the count ~ Binomial(n, p).
+void check_sex_act_sampler(SexActSampler& sampler) {
+	const size_t n = 200;
+	const double p = 0.1;
+	const int reps = 5000;
+
+	std::vector<int> freqs(n, 0);
+	std::vector<size_t> selected;
+	double sum = 0, sum_sq = 0;
+	for (int r = 0; r < reps; ++r) {
+		sampler.sample(n, p, selected);
+		for (size_t i = 0; i < selected.size(); ++i) {
+			ASSERT_TRUE(selected[i] < n);
+			if (i > 0) {
+				ASSERT_TRUE(selected[i - 1] < selected[i]);
+			}
+			++freqs[selected[i]];
+		}
+		sum += selected.size();
+		sum_sq += selected.size() * selected.size();
+	}
+
+	double mean = sum / reps;
+	double var = sum_sq / reps - mean * mean;
+	// mean: 20, sd of the mean ~ 0.06; var: 18, sd of the var ~ 0.4
+	ASSERT_NEAR(n * p, mean, 0.3);
+	ASSERT_NEAR(n * p * (1 - p), var, 2.0);
+	// each edge: 500 expected, sd ~ 21
+	for (int freq : freqs) {
+		ASSERT_NEAR(reps * p, freq, 110);
+	}
+
+	sampler.sample(0, p, selected);
+	ASSERT_EQ(0, selected.size());
+	sampler.sample(n, 0, selected);
+	ASSERT_EQ(0, selected.size());
+	sampler.sample(n, 1, selected);
+	ASSERT_EQ(n, selected.size());
+}
+
+TEST(SexActSamplerTests, TestSamplers) {
+	ModelRandom::initialize(1);
+	BernoulliSexActSampler bernoulli;
+	check_sex_act_sampler(bernoulli);
+
+	SkipAheadSexActSampler skip_ahead;
+	check_sex_act_sampler(skip_ahead);
+
+	BinomialSexActSampler binomial;
+	check_sex_act_sampler(binomial);
+
+	ASSERT_THROW(create_sex_act_sampler("foo"), std::invalid_argument);
+}
+
+TEST(TransmissionRunnerTests, TestMultipliers) {
+	std::vector<float> dur_inf { 1, 1, 1, 1 };
+	// circ, prep, condom, infective insertive
+	TransmissionRunner runner(0.5f, 0.25f, 0.1f, 2.0f, dur_inf);
+
+	std::set<unsigned int> keys;
+	int roles[] = { VERSATILE, INSERTIVE, RECEPTIVE };
+	for (int r1 : roles) {
+		for (int r2 : roles) {
+			for (int i = 0; i < 8; ++i) {
+				unsigned int key = TransmissionRunner::multiplierKey(r1, r2, i & 1, i & 2, i & 4);
+				ASSERT_TRUE(key < 72);
+				keys.insert(key);
+			}
+		}
+	}
+	ASSERT_EQ(72, keys.size());
+
+	ASSERT_FLOAT_EQ(1.0f, runner.multiplier(TransmissionRunner::multiplierKey(VERSATILE, VERSATILE, false, false, false)));
+	// circumcision only applies if infectee is insertive / versatile and infector receptive, and no condom
+	ASSERT_FLOAT_EQ(0.5f, runner.multiplier(TransmissionRunner::multiplierKey(RECEPTIVE, INSERTIVE, false, false, true)));
+	ASSERT_FLOAT_EQ(0.1f, runner.multiplier(TransmissionRunner::multiplierKey(RECEPTIVE, INSERTIVE, true, false, true)));
+	ASSERT_FLOAT_EQ(1.0f, runner.multiplier(TransmissionRunner::multiplierKey(INSERTIVE, VERSATILE, false, false, true)));
+	// insertive infector and receptive infectee
+	ASSERT_FLOAT_EQ(2.0f * 0.25f, runner.multiplier(TransmissionRunner::multiplierKey(VERSATILE, RECEPTIVE, false, true, false)));
+	ASSERT_FLOAT_EQ(2.0f * 0.25f * 0.1f, runner.multiplier(TransmissionRunner::multiplierKey(INSERTIVE, RECEPTIVE, true, true, true)));
+
+	std::vector<float> infectivities { 0.2f, 0.2f, 0.2f };
+	std::vector<unsigned int> batch_keys { TransmissionRunner::multiplierKey(INSERTIVE, RECEPTIVE, false, false, false),
+		TransmissionRunner::multiplierKey(INSERTIVE, RECEPTIVE, true, false, false),
+		TransmissionRunner::multiplierKey(VERSATILE, VERSATILE, false, false, false)};
+	std::vector<double> draws { 0.3, 0.3, 0.2 };
+	std::vector<unsigned char> infected;
+	runner.determineInfections(infectivities, batch_keys, draws, infected);
+	ASSERT_EQ(3, infected.size());
+	ASSERT_TRUE(infected[0]);
+	ASSERT_FALSE(infected[1]);
+	ASSERT_TRUE(infected[2]);
+}
+
+TEST(CalendarQueueTests, TestPushPop) {
+	CalendarQueue<int> queue(6);
+	queue.push(3, 1);
+	queue.push(3, 2);
+	queue.push(4, 3);
+	// same bucket as 3 with 8 buckets
+	queue.push(11, 4);
+	queue.push(1000, 5);
+	ASSERT_EQ(5, queue.size());
+
+	std::vector<int> out;
+	queue.pop(2, out);
+	ASSERT_EQ(0, out.size());
+
+	queue.pop(3, out);
+	ASSERT_EQ(2, out.size());
+	ASSERT_EQ(1, out[0]);
+	ASSERT_EQ(2, out[1]);
+	ASSERT_EQ(3, queue.size());
+
+	out.clear();
+	queue.pop(4, out);
+	ASSERT_EQ(1, out.size());
+	ASSERT_EQ(3, out[0]);
+
+	out.clear();
+	queue.pop(11, out);
+	ASSERT_EQ(1, out.size());
+	ASSERT_EQ(4, out[0]);
+
+	out.clear();
+	queue.pop(1000, out);
+	ASSERT_EQ(1, out.size());
+	ASSERT_EQ(5, out[0]);
+	ASSERT_EQ(0, queue.size());
+}
+
+TEST(TimingWheelTests, TestPushPop) {
+	TimingWheel<int> wheel(1);
+	// level 0, level 1 and overflow
+	wheel.push(5, 1);
+	wheel.push(300, 2);
+	wheel.push(70000, 3);
+	wheel.push(5, 4);
+	ASSERT_EQ(4, wheel.size());
+
+	std::vector<int> out;
+	wheel.pop(4, out);
+	ASSERT_EQ(0, out.size());
+	wheel.pop(5, out);
+	ASSERT_EQ(2, out.size());
+	ASSERT_EQ(1, out[0]);
+	ASSERT_EQ(4, out[1]);
+
+	out.clear();
+	// in the past so added at the current tick
+	wheel.push(2, 5);
+	wheel.pop(299, out);
+	ASSERT_EQ(1, out.size());
+	ASSERT_EQ(5, out[0]);
+
+	out.clear();
+	wheel.pop(300, out);
+	ASSERT_EQ(1, out.size());
+	ASSERT_EQ(2, out[0]);
+
+	out.clear();
+	wheel.pop(69999, out);
+	ASSERT_EQ(0, out.size());
+	wheel.pop(70000, out);
+	ASSERT_EQ(1, out.size());
+	ASSERT_EQ(3, out[0]);
+	ASSERT_EQ(0, wheel.size());
+}
+
+TEST(TimingWheelTests, TestOrder) {
+	repast::Random::initialize(1);
+	TimingWheel<std::pair<long, int>> wheel(0);
+	std::vector<std::pair<long, int>> expected;
+	for (int i = 0; i < 5000; ++i) {
+		long tick = (long) (repast::Random::instance()->nextDouble() * 200000);
+		wheel.push(tick, std::make_pair(tick, i));
+		expected.push_back(std::make_pair(tick, i));
+	}
+	// ticks in order, and insertion order within a tick
+	std::sort(expected.begin(), expected.end());
+
+	std::vector<std::pair<long, int>> out;
+	for (long tick = 0; tick < 200000; tick += 1000) {
+		wheel.pop(tick + 999, out);
+	}
+	ASSERT_EQ(expected, out);
+}
+
+TEST(PersonEventSchedulerTests, TestPrepCessation) {
+	StatsBuilder builder("/dev");
+	builder.countsWriter("null");
+	builder.partnershipEventWriter("null");
+	builder.infectionEventWriter("null");
+	builder.biomarkerWriter("null");
+	builder.deathEventWriter("null");
+	builder.personDataRecorder("null");
+	builder.testingEventWriter("null");
+	builder.prepEventWriter("null");
+	builder.artEventWriter("null");
+	builder.createStatsSingleton();
+
+	std::shared_ptr<GeometricDistribution> gen = std::make_shared<GeometricDistribution>(0.5, 0);
+	Diagnoser<GeometricDistribution> diagnoser(0, 100, 0, gen.get());
+	PersonPtr person = std::make_shared<Person>(1, 20, false, 0, 0, diagnoser);
+
+	// the person holds the first slot, as allocated by a PersonCreator
+	SlotAllocator slots;
+	SlotRef ref = slots.allocate();
+	ASSERT_EQ(person->slot().slot, ref.slot);
+	ASSERT_EQ(person->slot().generation, ref.generation);
+	Stats::instance()->personDataRecorder().initRecord(person, 0);
+
+	std::vector<PersonPtr> stopped;
+	PersonEventScheduler scheduler(30, [&slots, &person](const SlotRef& ref) {
+		return slots.isCurrent(ref) ? person : PersonPtr();
+	}, [&stopped](const PersonPtr& p) {stopped.push_back(p);});
+
+	// scheduling: cessation occurs after the step at its timestamp and so
+	// runs at the start of the next step
+	person->goOnPrep(1, 5.5);
+	scheduler.schedulePrepCessation(person, 5.5);
+	ASSERT_EQ(1, scheduler.size());
+	scheduler.run(5);
+	ASSERT_TRUE(person->isOnPrep());
+	ASSERT_EQ(0, stopped.size());
+	scheduler.run(6);
+	ASSERT_FALSE(person->isOnPrep());
+	ASSERT_EQ(1, stopped.size());
+	ASSERT_EQ(person, stopped[0]);
+	ASSERT_EQ(0, scheduler.size());
+
+	// a cessation for a person already off PrEP does nothing
+	scheduler.schedulePrepCessation(person, 7);
+	scheduler.run(8);
+	ASSERT_EQ(1, stopped.size());
+
+	// finish runs the events up to and including the final tick only
+	person->goOnPrep(8, 20.5);
+	scheduler.schedulePrepCessation(person, 20.5);
+	scheduler.finish(20);
+	ASSERT_TRUE(person->isOnPrep());
+	ASSERT_EQ(0, scheduler.size());
+
+	PersonEventScheduler at_end(30, [&slots, &person](const SlotRef& ref) {
+		return slots.isCurrent(ref) ? person : PersonPtr();
+	}, [&stopped](const PersonPtr& p) {stopped.push_back(p);});
+	at_end.schedulePrepCessation(person, 20);
+	at_end.finish(20);
+	ASSERT_FALSE(person->isOnPrep());
+	ASSERT_EQ(2, stopped.size());
+}
+
+TEST(PersonEventSchedulerTests, TestSkipDeadAndReleased) {
+	StatsBuilder builder("/dev");
+	builder.countsWriter("null");
+	builder.partnershipEventWriter("null");
+	builder.infectionEventWriter("null");
+	builder.biomarkerWriter("null");
+	builder.deathEventWriter("null");
+	builder.personDataRecorder("null");
+	builder.testingEventWriter("null");
+	builder.prepEventWriter("null");
+	builder.artEventWriter("null");
+	builder.createStatsSingleton();
+
+	std::shared_ptr<GeometricDistribution> gen = std::make_shared<GeometricDistribution>(0.5, 0);
+	Diagnoser<GeometricDistribution> diagnoser(0, 100, 0, gen.get());
+	PersonPtr person = std::make_shared<Person>(1, 20, false, 0, 0, diagnoser);
+
+	SlotAllocator slots;
+	SlotRef ref = slots.allocate();
+	int resolved = 0;
+	std::vector<PersonPtr> stopped;
+	PersonEventScheduler scheduler(30, [&slots, &person, &resolved](const SlotRef& ref) {
+		++resolved;
+		return slots.isCurrent(ref) ? person : PersonPtr();
+	}, [&stopped](const PersonPtr& p) {stopped.push_back(p);});
+
+	// dead but not yet released
+	person->goOnPrep(1, 5);
+	scheduler.schedulePrepCessation(person, 5);
+	person->setDead(true);
+	scheduler.run(6);
+	ASSERT_EQ(1, resolved);
+	ASSERT_TRUE(person->isOnPrep());
+	ASSERT_EQ(0, stopped.size());
+	ASSERT_EQ(0, scheduler.size());
+
+	// released and the slot reused by another person: the pending
+	// event is cancelled rather than run for the slot's new holder
+	person->setDead(false);
+	scheduler.schedulePrepCessation(person, 10);
+	scheduler.scheduleAdherenceCheck(person, 12);
+	slots.release(ref);
+	SlotRef reused = slots.allocate();
+	ASSERT_EQ(ref.slot, reused.slot);
+	ASSERT_EQ(2, scheduler.size());
+	scheduler.run(15);
+	ASSERT_EQ(3, resolved);
+	ASSERT_TRUE(person->isOnPrep());
+	ASSERT_EQ(0, stopped.size());
+	// the adherence check doesn't reschedule itself when dropped
+	ASSERT_EQ(0, scheduler.size());
+}
+
+TEST(PersonTests, TestAging) {
+	Person::setYearsPerTick(1 / 365.0f);
+	Person::setClock(10);
+	std::shared_ptr<GeometricDistribution> gen = std::make_shared<GeometricDistribution>(0.5, 0);
+	Diagnoser<GeometricDistribution> diagnoser(0, 100, 0, gen.get());
+	Person person(1, 20, false, 0, 0, diagnoser);
+
+	ASSERT_FLOAT_EQ(20, person.age());
+	Person::setClock(10 + 365);
+	ASSERT_FLOAT_EQ(21, person.age());
+	ASSERT_FLOAT_EQ(20.5f, person.ageAt(10 + 182.5));
+
+	// first clock at which the age is greater than max age
+	double clock = person.ageOutClock(21);
+	ASSERT_TRUE(person.ageAt(clock) > 21);
+	ASSERT_FALSE(person.ageAt(clock - 1) > 21);
+	ASSERT_NEAR(10 + 365, clock, 1);
+
+	// already older than max age
+	ASSERT_EQ(10, person.ageOutClock(19));
+
+	Person::setClock(400);
+	person.infect(1000, 400);
+	ASSERT_EQ(0, person.timeSinceInfection());
+	Person::setClock(420);
+	ASSERT_EQ(20, person.timeSinceInfection());
+	person.updateTimeSince(410);
+	ASSERT_EQ(10, person.infectionParameters().time_since_infection);
+
+	person.goOnART(420);
+	Person::setClock(425);
+	ASSERT_EQ(5, person.timeSinceARTInit());
+	ASSERT_EQ(25, person.timeSinceInfection());
+
+	Person::setClock(0);
+}
+
+TEST(PersonTests, TestARTInit) {
+	Person::setClock(1);
+	std::shared_ptr<GeometricDistribution> gen = std::make_shared<GeometricDistribution>(0.5, 0);
+	Diagnoser<GeometricDistribution> diagnoser(0, 100, 0, gen.get());
+	Person person(1, 20, false, 0, 0, diagnoser);
+	ASSERT_TRUE(std::isnan(person.artInitParameters().time_of_art_init));
+	ASSERT_TRUE(std::isnan(person.artInitParameters().cd4_at_art_init));
+
+	person.infect(100, 1);
+	person.setCD4Count(500);
+	person.setViralLoad(4);
+	Person::setClock(11);
+	person.goOnART(11);
+	ASSERT_EQ(11, person.artInitParameters().time_of_art_init);
+	ASSERT_EQ(500, person.artInitParameters().cd4_at_art_init);
+	ASSERT_EQ(4, person.artInitParameters().vl_at_art_init);
+
+	person.goOffART();
+	person.setCD4Count(300);
+	Person::setClock(21);
+	person.goOnART(21);
+	ASSERT_EQ(21, person.artInitParameters().time_of_art_init);
+	ASSERT_EQ(300, person.artInitParameters().cd4_at_art_init);
+	ASSERT_EQ(0, person.timeSinceARTInit());
+
+	// going on and off ART leaves the testing state as constructed
+	const Diagnoser<GeometricDistribution>& d = person.diagnoser();
+	ASSERT_EQ(100, d.nextTestAt());
+	ASSERT_EQ(0, d.testCount());
+	ASSERT_EQ(-1, d.lastTestAt());
+}
+
+TEST(ASMSamplerTests, TestDeathTicks) {
+	ModelRandom::initialize(1);
+	Person::setYearsPerTick(1);
+	Person::setClock(1);
+	std::shared_ptr<GeometricDistribution> gen = std::make_shared<GeometricDistribution>(0.5, 0);
+	Diagnoser<GeometricDistribution> diagnoser(0, 100, 0, gen.get());
+	Person person(1, 20, false, 0, 0, diagnoser);
+
+	RangeWithProbabilityCreator creator;
+	creator.addBin(0, 25, 0.05);
+	creator.addBin(25, 30, 0.2);
+	creator.addBin(30, 40, 0.02);
+	ASMSampler sampler(creator.createRangeWithProbability());
+
+	// the age tested at tick t is 20 + t, so ticks 1 - 4 are in the first bin,
+	// 5 - 9 in the second and 10 - 19 in the third.
+	std::vector<double> expected(20, 0);
+	double survival = 1;
+	for (int tick = 1; tick < 20; ++tick) {
+		double p = tick < 5 ? 0.05 : (tick < 10 ? 0.2 : 0.02);
+		expected[tick] = survival * p;
+		survival *= 1 - p;
+	}
+
+	const int n = 100000;
+	std::vector<int> counts(20, 0);
+	int survived = 0;
+	for (int i = 0; i < n; ++i) {
+		long tick = sampler.drawDeathTick(person, 1, 20);
+		if (tick == -1) {
+			++survived;
+		} else {
+			ASSERT_TRUE(tick >= 1 && tick < 20);
+			++counts[tick];
+		}
+	}
+
+	for (int tick = 1; tick < 20; ++tick) {
+		double sd = std::sqrt(expected[tick] * (1 - expected[tick]) / n);
+		ASSERT_NEAR(expected[tick], counts[tick] / (double) n, 5 * sd);
+	}
+	double sd = std::sqrt(survival * (1 - survival) / n);
+	ASSERT_NEAR(survival, survived / (double) n, 5 * sd);
+
+	ASSERT_EQ(-1, sampler.drawDeathTick(person, 5, 5));
+
+	Person::setYearsPerTick(1 / 365.0f);
+	Person::setClock(0);
+}
+
+TEST(ProbDistTests, TestDraw) {
+	ProbDistCreator<int> creator;
+	creator.addItem(0.2, std::make_shared<int>(1));
+	creator.addItem(0.3, std::make_shared<int>(2));
+	creator.addItem(0.5, std::make_shared<int>(3));
+	ProbDist<int> dist = creator.createProbDist();
+
+	repast::Random::initialize(1);
+	const int n = 100000;
+	std::vector<int> counts(3, 0);
+	for (int i = 0; i < n; ++i) {
+		++counts[*dist.draw(repast::Random::instance()->nextDouble()) - 1];
+	}
+	std::vector<double> probs { 0.2, 0.3, 0.5 };
+	for (size_t i = 0; i < probs.size(); ++i) {
+		ASSERT_NEAR(probs[i], counts[i] / (double) n, 5 * std::sqrt(probs[i] * (1 - probs[i]) / n));
+	}
+}
+
+TEST(AliasTableTests, TestDraw) {
+	repast::Random::initialize(1);
+	std::vector<double> weights { 0.1, 0, 0.5, 0.15, 0.25 };
+	AliasTable table(weights);
+	ASSERT_EQ(5, table.size());
+
+	const int n = 100000;
+	std::vector<int> counts(weights.size(), 0);
+	for (int i = 0; i < n; ++i) {
+		++counts[table.draw(repast::Random::instance()->nextDouble())];
+	}
+
+	for (size_t i = 0; i < weights.size(); ++i) {
+		double sd = std::sqrt(weights[i] * (1 - weights[i]) / n);
+		ASSERT_NEAR(weights[i], counts[i] / (double) n, 5 * sd + 1e-9);
+	}
+
+	ASSERT_THROW(AliasTable(std::vector<double> { 0, 0 }), std::invalid_argument);
+	ASSERT_THROW(AliasTable(std::vector<double> { 1, -1 }), std::invalid_argument);
+
+	ProbDistCreator<int> creator;
+	creator.addItem(0.2, std::make_shared<int>(1));
+	creator.addItem(0.8, std::make_shared<int>(2));
+	ProbDist<int> dist = creator.createProbDist();
+	int ones = 0;
+	for (int i = 0; i < n; ++i) {
+		if (*dist.draw(repast::Random::instance()->nextDouble()) == 1) {
+			++ones;
+		}
+	}
+	ASSERT_NEAR(0.2, ones / (double) n, 5 * std::sqrt(0.2 * 0.8 / n));
+}
+
+TEST(ModelRandomTests, TestDistributions) {
+	ModelRandom rng(42);
+	ModelRandom same(42);
+	for (int i = 0; i < 2000; ++i) {
+		// more than a buffer's worth
+		ASSERT_EQ(rng.uniform(), same.uniform());
+	}
+
+	const int n = 100000;
+	double sum = 0, geom_sum = 0;
+	long binom_sum = 0, poisson_sum = 0;
+	int successes = 0;
+	for (int i = 0; i < n; ++i) {
+		double u = rng.uniform();
+		ASSERT_TRUE(u >= 0 && u < 1);
+		sum += u;
+		if (rng.bernoulli(0.3)) {
+			++successes;
+		}
+		binom_sum += rng.binomial(10, 0.2);
+		poisson_sum += rng.poisson(3.5);
+		geom_sum += rng.geometric(0.25);
+	}
+
+	ASSERT_NEAR(0.5, sum / n, 0.01);
+	ASSERT_NEAR(0.3, successes / (double) n, 0.01);
+	ASSERT_NEAR(2, binom_sum / (double) n, 0.05);
+	ASSERT_NEAR(3.5, poisson_sum / (double) n, 0.05);
+	// mean failures before the first success is (1 - p) / p
+	ASSERT_NEAR(3, geom_sum / n, 0.1);
+
+	ASSERT_EQ(0, rng.binomial(10, 0));
+	ASSERT_EQ(10, rng.binomial(10, 1));
+	for (int i = 0; i < 2000; ++i) {
+		ASSERT_FALSE(rng.bernoulli(0));
+		ASSERT_TRUE(rng.bernoulli(1));
+	}
+	ASSERT_EQ(0, rng.geometric(1));
+	for (int i = 0; i < 100; ++i) {
+		size_t val = rng.uniformInt(3, 5);
+		ASSERT_TRUE(val >= 3 && val <= 5);
+	}
+}
+
+struct PoolTestItem {
+	int a;
+	double b;
+
+	PoolTestItem(int a_, double b_) :
+			a(a_), b(b_) {
+	}
+};
+
+TEST(PoolAllocatorTests, TestPool) {
+	FixedSizePool pool;
+	void* p1 = pool.allocate(12);
+	void* p2 = pool.allocate(16);
+	ASSERT_NE(p1, p2);
+	ASSERT_EQ(0, pool.stats().block_size % alignof(std::max_align_t));
+	ASSERT_TRUE(pool.stats().block_size >= 12);
+	ASSERT_EQ(nullptr, pool.allocate(pool.stats().block_size + 1));
+	ASSERT_EQ(2, pool.stats().in_use);
+	ASSERT_EQ(1, pool.stats().chunks);
+
+	// freed blocks are reused
+	pool.deallocate(p1);
+	ASSERT_EQ(p1, pool.allocate(8));
+	pool.deallocate(p1);
+	pool.deallocate(p2);
+
+	const PoolStats& stats = pool.stats();
+	ASSERT_EQ(0, stats.in_use);
+	ASSERT_EQ(2, stats.peak_in_use);
+	ASSERT_EQ(3, stats.allocations);
+	ASSERT_EQ(3, stats.deallocations);
+
+	std::vector<std::shared_ptr<PoolTestItem>> items;
+	for (int i = 0; i < 10000; ++i) {
+		items.push_back(std::allocate_shared<PoolTestItem>(PoolAllocator<PoolTestItem>(), i, i * 0.5));
+	}
+	for (int i = 0; i < 10000; ++i) {
+		ASSERT_EQ(i, items[i]->a);
+		ASSERT_EQ(i * 0.5, items[i]->b);
+	}
+	ASSERT_EQ(10000, PoolAllocator<PoolTestItem>::stats().in_use);
+	ASSERT_TRUE(PoolAllocator<PoolTestItem>::stats().chunks > 1);
+	items.clear();
+	ASSERT_EQ(0, PoolAllocator<PoolTestItem>::stats().in_use);
+	ASSERT_EQ(10000, PoolAllocator<PoolTestItem>::stats().peak_in_use);
+
+	// arrays go to operator new
+	PoolAllocator<PoolTestItem> alloc;
+	PoolTestItem* arr = alloc.allocate(4);
+	alloc.deallocate(arr, 4);
+	ASSERT_EQ(0, PoolAllocator<PoolTestItem>::stats().in_use);
+}
+
+TEST(SlotAllocatorTests, TestSlots) {
+	SlotAllocator slots;
+	SlotRef r0 = slots.allocate();
+	SlotRef r1 = slots.allocate();
+	SlotRef r2 = slots.allocate();
+	ASSERT_EQ(0, r0.slot);
+	ASSERT_EQ(1, r1.slot);
+	ASSERT_EQ(2, r2.slot);
+	ASSERT_EQ(0, r1.generation);
+	ASSERT_EQ(3, slots.size());
+
+	slots.release(r1);
+	ASSERT_FALSE(slots.isCurrent(r1));
+	ASSERT_TRUE(slots.isCurrent(r0));
+	ASSERT_THROW(slots.release(r1), std::invalid_argument);
+
+	// released slot is reused with a new generation
+	SlotRef r3 = slots.allocate();
+	ASSERT_EQ(1, r3.slot);
+	ASSERT_EQ(1, r3.generation);
+	ASSERT_TRUE(slots.isCurrent(r3));
+	ASSERT_FALSE(slots.isCurrent(r1));
+	ASSERT_EQ(3, slots.capacity());
+	ASSERT_EQ(3, slots.size());
+
+	SlotMap<int> map;
+	map.put(r1, 10);
+	map.put(r2, 20);
+	ASSERT_EQ(2, map.size());
+	ASSERT_EQ(20, *map.find(r2));
+	ASSERT_EQ(10, *map.find(r1));
+	// the slot's new holder doesn't see the old holder's value
+	ASSERT_EQ(nullptr, map.find(r3));
+	ASSERT_FALSE(map.erase(r3));
+	ASSERT_FALSE(map.contains(r0));
+
+	map.put(r3, 30);
+	ASSERT_EQ(2, map.size());
+	ASSERT_EQ(30, *map.find(r3));
+	ASSERT_FALSE(map.contains(r1));
+	ASSERT_TRUE(map.erase(r3));
+	ASSERT_EQ(1, map.size());
+	ASSERT_FALSE(map.contains(r3));
+
+	std::vector<int> values;
+	map.forEach([&values](int val) {values.push_back(val);});
+	ASSERT_EQ(std::vector<int>({ 20 }), values);
+}
+
+template<typename T>
+T read_val(std::ifstream& in) {
+	T val;
+	in.read(reinterpret_cast<char*>(&val), sizeof(T));
+	return val;
+}
+
+TEST(ColumnarWriterTests, TestWrite) {
+	std::string fname = "../test_output/columnar_test.bin";
+	std::string data_file, schema_file;
+	{
+		std::shared_ptr<ColumnarSink<DeathEvent>> sink = std::make_shared<ColumnarSink<DeathEvent>>(fname);
+		data_file = sink->dataFile();
+		schema_file = sink->schemaFile();
+		StatsWriter<DeathEvent> writer(sink, 2);
+		writer.addOutput( { 1.5, 3, 20.5f, true, DeathEvent::AGE });
+		writer.addOutput( { 2, 4, 30, false, DeathEvent::ASM });
+		writer.addOutput( { 3, 5, 40, false, DeathEvent::INFECTION });
+	}
+
+	std::ifstream schema_in(schema_file);
+	std::string line;
+	std::vector<std::string> lines;
+	while (std::getline(schema_in, line)) {
+		lines.push_back(line);
+	}
+	std::vector<std::string> expected { "tick,float64", "p_id,int32", "age,float32", "art_status,bool", "cause,string" };
+	ASSERT_EQ(expected, lines);
+
+	std::ifstream in(data_file, std::ios::binary);
+	char magic[8];
+	in.read(magic, 8);
+	ASSERT_EQ(ColumnarWriter::MAGIC, std::string(magic, 8));
+
+	// a chunk of 2 rows and then one of 1 row
+	std::vector<unsigned int> chunk_rows { 2, 1 };
+	std::vector<double> ticks { 1.5, 2, 3 };
+	std::vector<std::string> causes { "AGE", "ASM", "INFECTION" };
+	size_t row = 0;
+	for (unsigned int rows : chunk_rows) {
+		ASSERT_EQ(rows, read_val<uint32_t>(in));
+		ASSERT_EQ(5, read_val<uint32_t>(in));
+
+		ASSERT_EQ(static_cast<unsigned char>(ColumnType::FLOAT64), read_val<unsigned char>(in));
+		ASSERT_EQ(rows * 8, read_val<uint64_t>(in));
+		for (size_t i = 0; i < rows; ++i) {
+			ASSERT_EQ(ticks[row + i], read_val<double>(in));
+		}
+
+		ASSERT_EQ(static_cast<unsigned char>(ColumnType::INT32), read_val<unsigned char>(in));
+		ASSERT_EQ(rows * 4, read_val<uint64_t>(in));
+		for (size_t i = 0; i < rows; ++i) {
+			ASSERT_EQ(row + i + 3, read_val<int>(in));
+		}
+
+		ASSERT_EQ(static_cast<unsigned char>(ColumnType::FLOAT32), read_val<unsigned char>(in));
+		ASSERT_EQ(rows * 4, read_val<uint64_t>(in));
+		in.seekg(rows * 4, std::ios::cur);
+
+		ASSERT_EQ(static_cast<unsigned char>(ColumnType::BOOL), read_val<unsigned char>(in));
+		ASSERT_EQ(rows, read_val<uint64_t>(in));
+		for (size_t i = 0; i < rows; ++i) {
+			ASSERT_EQ(row + i == 0, read_val<unsigned char>(in) == 1);
+		}
+
+		ASSERT_EQ(static_cast<unsigned char>(ColumnType::STRING), read_val<unsigned char>(in));
+		read_val<uint64_t>(in);
+		for (size_t i = 0; i < rows; ++i) {
+			uint32_t length = read_val<uint32_t>(in);
+			std::string cause(length, ' ');
+			in.read(&cause[0], length);
+			ASSERT_EQ(causes[row + i], cause);
+		}
+		row += rows;
+	}
+	in.peek();
+	ASSERT_TRUE(in.eof());
+
+	boost::filesystem::remove(data_file);
+	boost::filesystem::remove(schema_file);
+}
+
+TEST(ColumnarWriterTests, TestOpenError) {
+	// files cannot be created in /proc
+	ASSERT_THROW(ColumnarWriter("/proc/columnar_test.bin", column_schema<DeathEvent>()), std::runtime_error);
+}
+
+struct IntItem {
+	int val;
+};
+
+class MockSink: public StatsSink<IntItem> {
+
+public:
+	std::vector<int> written;
+	std::thread::id writer_thread;
+
+	void write(std::vector<IntItem>& data) override {
+		writer_thread = std::this_thread::get_id();
+		for (auto& item : data) {
+			written.push_back(item.val);
+		}
+	}
+};
+
+TEST(AsyncWriterTests, TestWrite) {
+	std::shared_ptr<AsyncWriter> io = std::make_shared<AsyncWriter>(2);
+	std::shared_ptr<MockSink> sink = std::make_shared<MockSink>();
+	{
+		StatsWriter<IntItem> writer(sink, 3, io);
+		for (int i = 0; i < 100; ++i) {
+			writer.addOutput( { i });
+		}
+		writer.flush();
+		io->flush();
+		ASSERT_EQ(100, sink->written.size());
+		ASSERT_NE(std::this_thread::get_id(), sink->writer_thread);
+		writer.addOutput( { 100 });
+	}
+	io->flush();
+	ASSERT_EQ(101, sink->written.size());
+	for (int i = 0; i < 101; ++i) {
+		ASSERT_EQ(i, sink->written[i]);
+	}
+
+	// errors are rethrown on the submitting thread
+	io->submit([] {throw std::domain_error("disk full");});
+	ASSERT_THROW(io->flush(), std::domain_error);
+	int count = 0;
+	io->submit([&count] {++count;});
+	io->flush();
+	ASSERT_EQ(1, count);
+}
+
+class FailOnceSink: public StatsSink<IntItem> {
+
+public:
+	bool fail = true;
+	std::vector<int> written;
+
+	void write(std::vector<IntItem>& data) override {
+		if (fail) {
+			fail = false;
+			throw std::runtime_error("disk full");
+		}
+		for (auto& item : data) {
+			written.push_back(item.val);
+		}
+	}
+};
+
+TEST(StatsWriterTests, TestRetryAfterError) {
+	std::shared_ptr<FailOnceSink> sink = std::make_shared<FailOnceSink>();
+	StatsWriter<IntItem> writer(sink, 3);
+	writer.addOutput( { 0 });
+	writer.addOutput( { 1 });
+	ASSERT_THROW(writer.addOutput( { 2 }), std::runtime_error);
+	ASSERT_TRUE(sink->written.empty());
+
+	// the full buffer is written on the next add rather than growing unwritten
+	writer.addOutput( { 3 });
+	ASSERT_EQ(std::vector<int>({ 0, 1, 2, 3 }), sink->written);
+	writer.addOutput( { 4 });
+	writer.addOutput( { 5 });
+	writer.addOutput( { 6 });
+	ASSERT_EQ(7, sink->written.size());
+}
+
+TEST(BufferRingTests, TestRing) {
+	BufferRing<IntItem> ring(2, 10);
+	std::vector<IntItem>& first = ring.acquire();
+	ASSERT_EQ(10, first.capacity());
+	for (int i = 0; i < 10; ++i) {
+		first.push_back( { i });
+	}
+	const IntItem* storage = first.data();
+	std::vector<IntItem>& second = ring.acquire();
+	ASSERT_NE(&first, &second);
+
+	// the first buffer is acquired again once it has been released
+	std::thread consumer([&ring, &first] {
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		ring.release(first);
+	});
+	std::vector<IntItem>& third = ring.acquire();
+	consumer.join();
+	ASSERT_EQ(&first, &third);
+	ASSERT_TRUE(third.empty());
+	ASSERT_EQ(storage, third.data());
+}
+
+TEST(FileOutputTests, TestFormatting) {
+	std::string fname = "../test_output/file_output_test.csv";
+	boost::filesystem::remove(fname);
+
+	std::vector<double> doubles { 0, -0.0, 1, -1, 25000, 999999, 1000000, -999999, 0.1, 1.0 / 3, 123456.7, 1234567, 1e-5,
+			-2.5e-7, 1e300, std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::infinity(),
+			-std::numeric_limits<double>::infinity(), 365.25, 0.0001, 99999.95 };
+	ModelRandom::initialize(1);
+	ModelRandom& rng = ModelRandom::instance();
+	for (int i = 0; i < 1000; ++i) {
+		doubles.push_back((rng.uniform() - 0.5) * 2e7);
+		doubles.push_back(std::floor((rng.uniform() - 0.5) * 2e7) / 1000);
+		doubles.push_back(std::floor((rng.uniform() - 0.5) * 2e6));
+	}
+
+	std::stringstream expected;
+	{
+		FileOutput out(fname);
+		for (double val : doubles) {
+			out << val << ",";
+			expected << val << ",";
+			out << (float) val << ",";
+			expected << (float) val << ",";
+		}
+		std::vector<int> ints { 0, -1, 1, 42, std::numeric_limits<int>::min(), std::numeric_limits<int>::max() };
+		for (int val : ints) {
+			out << val << "," << (unsigned int) val << "\n";
+			expected << val << "," << (unsigned int) val << "\n";
+		}
+		out << true << false << std::string("AGE");
+		expected << true << false << std::string("AGE");
+		out.ostream() << "|ostream|";
+		expected << "|ostream|";
+		out << 1.5;
+		expected << 1.5;
+	}
+
+	std::ifstream in(fname);
+	std::stringstream actual;
+	actual << in.rdbuf();
+	ASSERT_EQ(expected.str(), actual.str());
+	boost::filesystem::remove(fname);
+}
+
+TEST(FileOutputTests, TestGzip) {
+	std::string fname = "../test_output/file_output_test.csv.gz";
+	boost::filesystem::remove(fname);
+
+	std::stringstream expected;
+	{
+		FileOutput out(fname);
+		for (int i = 0; i < 20000; ++i) {
+			out << i << "," << i * 0.5 << ",PARTNERSHIP_ENDED\n";
+			expected << i << "," << i * 0.5 << ",PARTNERSHIP_ENDED\n";
+		}
+		// larger than the buffer and so compressed directly
+		std::string large(100000, 'x');
+		out << large;
+		expected << large;
+		ASSERT_THROW(out.ostream(), std::logic_error);
+	}
+
+	std::ifstream in(fname, std::ios::binary);
+	std::string compressed((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	ASSERT_LT(compressed.size(), expected.str().size());
+
+	z_stream strm;
+	strm.zalloc = Z_NULL;
+	strm.zfree = Z_NULL;
+	strm.opaque = Z_NULL;
+	strm.next_in = Z_NULL;
+	strm.avail_in = 0;
+	ASSERT_EQ(Z_OK, inflateInit2(&strm, 15 + 16));
+	strm.next_in = reinterpret_cast<Bytef*>(&compressed[0]);
+	strm.avail_in = compressed.size();
+	std::string actual;
+	std::vector<char> chunk(1 << 16);
+	int ret;
+	do {
+		strm.next_out = reinterpret_cast<Bytef*>(chunk.data());
+		strm.avail_out = chunk.size();
+		ret = inflate(&strm, Z_NO_FLUSH);
+		ASSERT_TRUE(ret == Z_OK || ret == Z_STREAM_END);
+		actual.append(chunk.data(), chunk.size() - strm.avail_out);
+	} while (ret != Z_STREAM_END);
+	inflateEnd(&strm);
+
+	ASSERT_EQ(expected.str(), actual);
+	boost::filesystem::remove(fname);
+}
+
+struct DeathRow {
+	double tick;
+	int p_id;
+	char* cause;
+};
+
+TEST(EventWriterTests, TestWrite) {
+	std::string fname = "../test_output/event_writer_test.h5";
+	boost::filesystem::remove(fname);
+	{
+		std::shared_ptr<EventWriter> event_writer = std::make_shared<EventWriter>(fname);
+		ASSERT_EQ(fname, event_writer->fileName());
+		std::shared_ptr<AsyncWriter> io = std::make_shared<AsyncWriter>();
+		std::shared_ptr<StatsWriter<DeathEvent>> deaths = create_stats_writer<DeathEvent>("../test_output/death_events.csv",
+				OutputFormat::HDF5, 2, io, event_writer);
+		std::shared_ptr<StatsWriter<Biomarker>> biomarkers = create_stats_writer<Biomarker>("../test_output/biomarkers.csv",
+				OutputFormat::HDF5, 1000, io, event_writer);
+		ASSERT_THROW(event_writer->createDataSet("biomarkers", column_schema<Biomarker>()), std::invalid_argument);
+
+		deaths->addOutput( { 1.5, 3, 20.5f, true, DeathEvent::AGE });
+		deaths->addOutput( { 2, 4, 30, false, DeathEvent::ASM });
+		deaths->addOutput( { 3, 5, 40, false, DeathEvent::INFECTION });
+		for (int i = 0; i < 5000; ++i) {
+			biomarkers->addOutput( { (double) i, i, 1000.0f, 500.0f, i % 2 == 0 });
+		}
+		deaths->flush();
+		biomarkers->flush();
+		io->flush();
+	}
+
+	H5::H5File file(fname, H5F_ACC_RDONLY);
+	H5::DataSet deaths = file.openDataSet("death_events");
+	hsize_t dims[1];
+	deaths.getSpace().getSimpleExtentDims(dims);
+	ASSERT_EQ(3, dims[0]);
+
+	// read a subset of the columns, matched by name
+	H5::CompType death_type(sizeof(DeathRow));
+	death_type.insertMember("tick", HOFFSET(DeathRow, tick), H5::PredType::NATIVE_DOUBLE);
+	death_type.insertMember("p_id", HOFFSET(DeathRow, p_id), H5::PredType::NATIVE_INT);
+	H5::StrType str_type(H5::PredType::C_S1, H5T_VARIABLE);
+	death_type.insertMember("cause", HOFFSET(DeathRow, cause), str_type);
+	std::vector<DeathRow> rows(3);
+	deaths.read(rows.data(), death_type);
+
+	std::vector<double> ticks { 1.5, 2, 3 };
+	std::vector<std::string> causes { "AGE", "ASM", "INFECTION" };
+	for (size_t i = 0; i < rows.size(); ++i) {
+		ASSERT_EQ(ticks[i], rows[i].tick);
+		ASSERT_EQ(i + 3, rows[i].p_id);
+		ASSERT_EQ(causes[i], std::string(rows[i].cause));
+	}
+	H5::DataSet::vlenReclaim(rows.data(), death_type, deaths.getSpace());
+
+	H5::DataSet biomarkers = file.openDataSet("biomarkers");
+	biomarkers.getSpace().getSimpleExtentDims(dims);
+	ASSERT_EQ(5000, dims[0]);
+	H5::CompType p_id_type(sizeof(int));
+	p_id_type.insertMember("p_id", 0, H5::PredType::NATIVE_INT);
+	std::vector<int> ids(5000);
+	biomarkers.read(ids.data(), p_id_type);
+	for (int i = 0; i < 5000; ++i) {
+		ASSERT_EQ(i, ids[i]);
+	}
+
+	file.close();
+	boost::filesystem::remove(fname);
+}
+
+TEST(EventWriterTests, TestPartialRow) {
+	std::string fname = "../test_output/event_writer_test.h5";
+	boost::filesystem::remove(fname);
+	{
+		EventWriter event_writer(fname);
+		std::shared_ptr<EventDataSet> deaths = event_writer.createDataSet("death_events", column_schema<DeathEvent>());
+		DeathEvent event { 1.5, 3, 20.5f, true, DeathEvent::AGE };
+		event.visit(*deaths);
+		deaths->endRow();
+
+		// a row that fails part way through is not added
+		(*deaths)("tick", 2.0);
+		(*deaths)("p_id", 4);
+		ASSERT_THROW((*deaths)("cause", std::string("ASM")), std::invalid_argument);
+		ASSERT_THROW(deaths->endRow(), std::invalid_argument);
+
+		DeathEvent next { 3, 5, 40, false, DeathEvent::INFECTION };
+		next.visit(*deaths);
+		deaths->endRow();
+		deaths->writeRows();
+		ASSERT_EQ(2, deaths->size());
+	}
+
+	H5::H5File file(fname, H5F_ACC_RDONLY);
+	H5::DataSet deaths = file.openDataSet("death_events");
+	H5::CompType death_type(sizeof(DeathRow));
+	death_type.insertMember("tick", HOFFSET(DeathRow, tick), H5::PredType::NATIVE_DOUBLE);
+	death_type.insertMember("p_id", HOFFSET(DeathRow, p_id), H5::PredType::NATIVE_INT);
+	H5::StrType str_type(H5::PredType::C_S1, H5T_VARIABLE);
+	death_type.insertMember("cause", HOFFSET(DeathRow, cause), str_type);
+	std::vector<DeathRow> rows(2);
+	deaths.read(rows.data(), death_type);
+	ASSERT_EQ(1.5, rows[0].tick);
+	ASSERT_EQ(3, rows[1].tick);
+	ASSERT_EQ(5, rows[1].p_id);
+	ASSERT_EQ("INFECTION", std::string(rows[1].cause));
+	H5::DataSet::vlenReclaim(rows.data(), death_type, deaths.getSpace());
+
+	file.close();
+	boost::filesystem::remove(fname);
+}
+
+template<typename T>
+class VectorSink: public StatsSink<T> {
+
+public:
+	std::vector<T> items;
+
+	void write(std::vector<T>& data) override {
+		items.insert(items.end(), data.begin(), data.end());
+	}
+};
+
+TEST(EventStreamTests, TestLevels) {
+	ASSERT_EQ(OutputLevel::SAMPLED, parse_output_level("sampled"));
+	ASSERT_THROW(parse_output_level("some"), std::invalid_argument);
+	ASSERT_THROW(OutputControl(OutputLevel::SAMPLED, 1.5), std::invalid_argument);
+
+	int made = 0;
+	auto make = [&made] {
+		++made;
+		return TestingEvent {1, 2, true};
+	};
+
+	EventStream<TestingEvent> off;
+	off.record(2, 1, make);
+	ASSERT_EQ(0, made);
+
+	std::shared_ptr<VectorSink<TestingEvent>> sink = std::make_shared<VectorSink<TestingEvent>>();
+	EventStream<TestingEvent> full(std::make_shared<StatsWriter<TestingEvent>>(sink, 10), OutputControl());
+	for (int id = 0; id < 1000; ++id) {
+		full.record(id, 1, make);
+	}
+	full.flush();
+	ASSERT_EQ(1000, sink->items.size());
+
+	made = 0;
+	sink->items.clear();
+	EventStream<TestingEvent> sampled(std::make_shared<StatsWriter<TestingEvent>>(sink, 10),
+			OutputControl(OutputLevel::SAMPLED, 0.25));
+	IdSampler sampler(0.25);
+	int selected = 0;
+	for (int id = 0; id < 10000; ++id) {
+		sampled.record(id, 1, make);
+		if (sampler.isSelected(id)) {
+			++selected;
+		}
+	}
+	sampled.flush();
+	// the same ids are sampled and events are only made for those
+	ASSERT_EQ(selected, made);
+	ASSERT_EQ(selected, sink->items.size());
+	ASSERT_NEAR(2500, selected, 150);
+
+	std::shared_ptr<VectorSink<EventCount>> count_sink = std::make_shared<VectorSink<EventCount>>();
+	EventStream<TestingEvent> aggregate(std::make_shared<StatsWriter<EventCount>>(count_sink, 10));
+	made = 0;
+	aggregate.record(1, 1, make);
+	aggregate.record(2, 0, make);
+	aggregate.record(3, 1, make);
+	aggregate.endTick(1);
+	aggregate.endTick(2);
+	aggregate.record(4, 0, make);
+	aggregate.endTick(3);
+	aggregate.flush();
+	ASSERT_EQ(0, made);
+	ASSERT_EQ(3, count_sink->items.size());
+	ASSERT_EQ(1, count_sink->items[0].tick);
+	ASSERT_EQ(0, count_sink->items[0].type);
+	ASSERT_EQ(1, count_sink->items[0].count);
+	ASSERT_EQ(1, count_sink->items[1].type);
+	ASSERT_EQ(2, count_sink->items[1].count);
+	ASSERT_EQ(3, count_sink->items[2].tick);
+	ASSERT_EQ(0, count_sink->items[2].type);
+	ASSERT_EQ(1, count_sink->items[2].count);
+}
+
+TEST(TraceTests, TestTrace) {
+	ASSERT_EQ(TRACE_NONE, parse_trace_contents(""));
+	ASSERT_EQ(TRACE_BIOMARKERS | TRACE_TESTING, parse_trace_contents("biomarkers, testing"));
+	ASSERT_EQ(TRACE_ALL, parse_trace_contents("all"));
+	ASSERT_THROW(parse_trace_contents("biomarkers,vitals"), std::invalid_argument);
+
+	std::string fname("../test_output/trace_events.csv");
+	boost::filesystem::remove(fname);
+	StatsBuilder builder("../test_output", false);
+	builder.countsWriter("null");
+	builder.partnershipEventWriter("null");
+	builder.infectionEventWriter("null");
+	builder.biomarkerWriter("null");
+	builder.deathEventWriter("null");
+	builder.personDataRecorder("null");
+	builder.testingEventWriter("null");
+	builder.prepEventWriter("null");
+	builder.artEventWriter("null");
+	builder.traceEventWriter("trace_events.csv");
+	builder.createStatsSingleton();
+
+	std::shared_ptr<GeometricDistribution> gen = std::make_shared<GeometricDistribution>(0.5, 0);
+	Diagnoser<GeometricDistribution> diagnoser(0, 100, 0, gen.get());
+	Person traced(1, 20, false, 0, 0, diagnoser);
+	Person untraced(2, 20, false, 0, 0, diagnoser);
+	ASSERT_FALSE(traced.isTraced());
+	traced.setTrace(parse_trace_contents("testing,treatment"));
+	ASSERT_TRUE(traced.isTraced());
+	ASSERT_TRUE(traced.isTraced(TRACE_TESTING));
+	ASSERT_FALSE(traced.isTraced(TRACE_BIOMARKERS | TRACE_PARTNERSHIPS));
+
+	Stats* stats = Stats::instance();
+	stats->traceEvent(1, traced, TRACE_TESTING, TraceEvent::TESTED, -1, 1);
+	stats->traceEvent(1, untraced, TRACE_TESTING, TraceEvent::TESTED, -1, 1);
+	stats->traceEvent(2, traced, TRACE_PARTNERSHIPS, TraceEvent::PARTNERSHIP_STARTED, 2, 0);
+	stats->traceEvent(3, traced, TRACE_TREATMENT, TraceEvent::ART_STARTED, -1, 0);
+	stats->traceEvent(4, traced, TRACE_ALL, TraceEvent::DIED, -1, 0);
+	stats->close();
+	// replacing the stats closes its files
+	builder.traceEventWriter("null");
+	builder.createStatsSingleton();
+
+	std::ifstream in(fname);
+	std::string line;
+	std::vector<std::string> lines;
+	while (std::getline(in, line)) {
+		lines.push_back(line);
+	}
+	ASSERT_EQ(4, lines.size());
+	ASSERT_EQ(TraceEvent::header, lines[0]);
+	ASSERT_EQ("1,1,2,-1,1", lines[1]);
+	ASSERT_EQ("3,1,3,-1,0", lines[2]);
+	ASSERT_EQ("4,1,9,-1,0", lines[3]);
+}
+
+TEST(SummaryStatsTests, TestSummary) {
+	ASSERT_THROW(parse_windowed_aggregates("sex_acts:median:10"), std::invalid_argument);
+	ASSERT_THROW(parse_windowed_aggregates("sex_acts:sum"), std::invalid_argument);
+	ASSERT_THROW(SummaryStats(parse_windowed_aggregates("no_such_column:sum:10")), std::invalid_argument);
+
+	std::vector<WindowedAggregate> aggregates = parse_windowed_aggregates("sex_acts:sum:10, uninfected:last:1");
+	ASSERT_EQ(2, aggregates.size());
+	ASSERT_EQ("sex_acts_sum_10", aggregates[0].name());
+	SummaryStats summary(aggregates);
+
+	// the initial counts aren't summarized
+	std::vector<Counts> all;
+	Counts initial;
+	initial.size = 5;
+	initial.uninfected = 5;
+	summary.add(initial);
+	// 11.5 years so the first is dropped and the last is partial
+	for (int t = 1; t <= 4197; ++t) {
+		Counts counts;
+		counts.tick = t;
+		counts.size = 1000 + t % 11;
+		counts.uninfected = 900 - t % 7;
+		counts.internal_infected = t % 3;
+		counts.sex_acts = t;
+		summary.add(counts);
+		all.push_back(counts);
+	}
+
+	// as summarize_prev, summarize_inc and summarize_pop_size
+	std::vector<double> prev;
+	for (size_t i = all.size() - 3650; i < all.size(); ++i) {
+		prev.push_back((all[i].size - all[i].uninfected) / (double) all[i].size * 100);
+	}
+	double mean = std::accumulate(prev.begin(), prev.end(), 0.0) / prev.size();
+	double ss = 0;
+	for (double p : prev) {
+		ss += (p - mean) * (p - mean);
+	}
+	std::vector<double> inc;
+	for (size_t start = 0; start < all.size(); start += 365) {
+		size_t end = std::min(start + 365, all.size());
+		double sum = 0;
+		for (size_t i = start + 1; i < end; ++i) {
+			sum += all[i].internal_infected / (double) all[i - 1].uninfected;
+		}
+		inc.push_back(std::round(sum / (end - start - 1) * 365 * 100 * 1000) / 1000);
+	}
+
+	std::vector<std::pair<std::string, double>> results = summary.results();
+	ASSERT_EQ(2 + 10 + 1 + 2, results.size());
+	ASSERT_EQ("prev_mean", results[0].first);
+	ASSERT_NEAR(mean, results[0].second, 1e-9);
+	ASSERT_EQ("prev_sd", results[1].first);
+	ASSERT_NEAR(std::sqrt(ss / (prev.size() - 1)), results[1].second, 1e-9);
+	for (size_t i = 0; i < 10; ++i) {
+		ASSERT_EQ("inc_" + std::to_string(i + 1), results[2 + i].first);
+		ASSERT_NEAR(inc[inc.size() - 10 + i], results[2 + i].second, 1e-9);
+	}
+	ASSERT_EQ("pop_size", results[12].first);
+	ASSERT_EQ(all.back().size, results[12].second);
+	ASSERT_EQ("sex_acts_sum_10", results[13].first);
+	ASSERT_EQ(4188 + 4189 + 4190 + 4191 + 4192 + 4193 + 4194 + 4195 + 4196 + 4197, results[13].second);
+	ASSERT_EQ("uninfected_last_1", results[14].first);
+	ASSERT_EQ(all.back().uninfected, results[14].second);
+
+	// a rerun replaces the summary rather than writing to a new file
+	std::string fname = "../test_output/summary_test.csv";
+	SummaryStats(aggregates).write(fname);
+	summary.write(fname);
+	ASSERT_FALSE(boost::filesystem::exists("../test_output/summary_test_1.csv"));
+	std::ifstream in(fname);
+	std::string header, values;
+	std::getline(in, header);
+	std::getline(in, values);
+	ASSERT_EQ(0, header.find("prev_mean,prev_sd,inc_1,"));
+	ASSERT_NEAR(mean, std::stod(values.substr(0, values.find(','))), 1e-6);
+	boost::filesystem::remove(fname);
+}
@@ -10,6 +10,7 @@
 #include "RInstance.h"
 #include "Network.h"
 #include "network_utils.h"
+#include "DiscordantEdgeIndex.h"
 #include "StatsBuilder.h"
 
 using namespace TransModel;
@@ -20,11 +21,20 @@ class Agent {
 
 private:
 	unsigned int id_, age_;
+	bool infected_;
 
 public:
 
 	Agent(unsigned int id, unsigned int age) :
-			id_(id), age_(age) {
+			id_(id), age_(age), infected_(false) {
+	}
+
+	bool isInfected() const {
+		return infected_;
+	}
+
+	void setInfected(bool infected) {
+		infected_ = infected;
 	}
 
 	unsigned int id() const {
@@ -533,3 +543,66 @@ TEST_F(NetworkTests, InitNetTest) {
 	ASSERT_EQ(2, edge->type());
 }
 
+TEST(IndexedSetTests, TestAddRemove) {
+	IndexedSet<int> set;
+	ASSERT_TRUE(set.add(1, 10));
+	ASSERT_TRUE(set.add(2, 20));
+	ASSERT_TRUE(set.add(3, 30));
+	ASSERT_FALSE(set.add(2, 200));
+	ASSERT_EQ(3, set.size());
+
+	ASSERT_TRUE(set.remove(1));
+	ASSERT_FALSE(set.remove(1));
+	ASSERT_FALSE(set.contains(1));
+	ASSERT_EQ(2, set.size());
+	// last moved into the removed position
+	ASSERT_EQ(30, set[0]);
+	ASSERT_EQ(20, set[1]);
+
+	set.swap(0, 1);
+	ASSERT_EQ(20, set[0]);
+	ASSERT_TRUE(set.remove(3));
+	ASSERT_EQ(1, set.size());
+	ASSERT_EQ(20, set[0]);
+	ASSERT_TRUE(set.contains(2));
+}
+
+TEST(DiscordantEdgeIndexTests, TestIndex) {
+	Network<Agent> net(true);
+	DiscordantEdgeIndex<Agent> index;
+	net.addListener(&index);
+
+	AgentPtr one = std::make_shared<Agent>(1, 1);
+	AgentPtr two = std::make_shared<Agent>(2, 1);
+	AgentPtr three = std::make_shared<Agent>(3, 1);
+	two->setInfected(true);
+	net.addVertex(one);
+	net.addVertex(two);
+	net.addVertex(three);
+
+	net.addEdge(one, two, 0);
+	net.addEdge(one, three, 0);
+	net.addEdge(three, two, 1);
+	ASSERT_EQ(1, index.discordantEdges(0).size());
+	ASSERT_EQ(1, index.concordantEdges(0).size());
+	ASSERT_EQ(1, index.discordantEdges(1).size());
+	ASSERT_EQ(0, index.concordantEdges(1).size());
+
+	three->setInfected(true);
+	std::vector<EdgePtr<Agent>> edges;
+	net.getEdges(three, edges);
+	for (auto& edge : edges) {
+		index.update(edge);
+	}
+	ASSERT_EQ(2, index.discordantEdges(0).size());
+	ASSERT_EQ(0, index.concordantEdges(0).size());
+	ASSERT_EQ(0, index.discordantEdges(1).size());
+	ASSERT_EQ(1, index.concordantEdges(1).size());
+
+	net.removeEdge(1, 3, 0);
+	ASSERT_EQ(1, index.discordantEdges(0).size());
+
+	net.removeVertex(two);
+	ASSERT_EQ(0, index.discordantEdges(0).size());
+	ASSERT_EQ(0, index.concordantEdges(1).size());
+}